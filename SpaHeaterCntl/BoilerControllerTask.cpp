@@ -67,7 +67,7 @@ void BoilerControllerTask::BoilerControllerThreadEntry(void *pvParameters)
  */
 void BoilerControllerTask::setup()
 {
-    logger.Printf(Logger::RecType::Info, "*** BoilerControllerTask Thread Active ***");
+    $Log(Boiler, Info, "*** BoilerControllerTask Thread Active ***");
 
     pinMode(_heaterControlPin, OUTPUT); // Make sure the heater is turned off to start with
     digitalWrite(_heaterControlPin, false);
@@ -85,23 +85,29 @@ void BoilerControllerTask::setup()
     _tempState._sequence = 1;
 
     ClearOneWireBusStats();
-
-    // discover the temperature sensors on the one wire bus for use by forground task (e.g. configures the sensors)
-    logger.Printf(Logger::RecType::Info, "BoilerControllerTask: Start bus enumeration");
-    
-    array<DiscoveredTempSensor, 5>* results;
-    uint8_t resultsSize;
-
-    while (!OneWireCoProcEnumLoop(results, resultsSize));
-
-    for (int ix = 0; ix < resultsSize; ix++)
+    _samplingMode = SamplingMode::Idle;
+    memset(&_samplingPolicy, 0, sizeof(_samplingPolicy));
+    ClearSamplingStats();
+    _lastHeaterSwitchTimeInMS = 0;
+
+    // The discovered sensor set is built (and kept current) from the enumerations done each loop - see UpdateDiscoveredSensors()
+    memset(&_discoveredSensors[0], 0, sizeof(_discoveredSensors));
+    _discoveredSensorCount = 0;
+    _discoverySequence = 0;
+    _sensorEventHead = 0;
+    _sensorEventTail = 0;
+    _sensorEventOverflows = 0;
+
+#if SPA_SENSOR_SOURCE == SPA_SENSOR_SOURCE_NATIVE
+    if (!_oneWire.Begin(_oneWireBusPin))
     {
-        logger.Printf(Logger::RecType::Info, "BoilerControllerTask: OneWireCoProcEnumLoop: Sensor ID: %" $PRIX64, 
-                                             To$PRIX64(results->at(ix)._id));
-
-        _sensors.push_back(results->at(ix)._id);
+        $Log(Boiler, Critical, "BoilerControllerTask: OneWireNative: No GPT timer available");
+        $FailFast();
     }
-    logger.Printf(Logger::RecType::Info, "BoilerControllerTask: Start bus enumeration - COMPLETE");
+#else
+    Serial1.begin(9600);                    // OneWireCoProc link - must be up before the first sampling policy is sent
+    Serial1.setTimeout(0);                  // Just a polled environment - don't wait for anything
+#endif
 }
 
 
@@ -118,6 +124,30 @@ void BoilerControllerTask::loop()
     SnapshotTargetTemps(targetTemps);
     SnapshotTempState(tempState);
 
+    // Account the time since the last cycle to the current sampling mode and pick the sampling policy for
+    // this cycle from our current state
+    static uint32_t lastLoopTimeInMS = millis();
+    uint32_t const nowInMS = millis();
+    synchronized
+    {
+        _samplingStats[(int)_samplingMode]._timeInModeInMS += (nowInMS - lastLoopTimeInMS);
+    }
+    lastLoopTimeInMS = nowInMS;
+
+    UpdateSamplingPolicy(tempState, sensors);
+
+    // Absorb any completed enumeration from the sensor source. This is done in every state so the discovered
+    // sensor set is kept current whether or not the heater is being controlled.
+    array<DiscoveredTempSensor, 5>* results;
+    uint8_t resultsSize;
+    bool isFullEnum;
+    bool haveEnum = SensorEnumLoop(results, resultsSize, isFullEnum);
+
+    if (haveEnum && isFullEnum)
+    {
+        UpdateDiscoveredSensors(*results, resultsSize);
+    }
+
     // Auto update the target temps if they are different from the current target temps
     if (targetTemps._setPoint != tempState._setPoint ||
         targetTemps._hysteresis != tempState._hysteresis)
@@ -143,6 +173,7 @@ void BoilerControllerTask::loop()
         {
             // The heater state has changed - update our local copy
             tempState._heaterOn = digitalRead(_heaterControlPin);
+            _lastHeaterSwitchTimeInMS = millis();       // sample boilerIn at the fast rate while things settle
 
             synchronized
             {
@@ -166,7 +197,7 @@ void BoilerControllerTask::loop()
                 firstTimeInRunningState = true;
                 SafeClearCommand();                       // acknowledge the command
                 SafeSetStateMachineState(StateMachineState::Running); // Go to the Running state
-                logger.Printf(Logger::RecType::Info, "BoilerControllerTask: HeaterState::Halted: Command::Start");
+                $Log(Boiler, Info, "BoilerControllerTask: HeaterState::Halted: Command::Start");
             }
         }
         break;
@@ -191,6 +222,12 @@ void BoilerControllerTask::loop()
             static uint32_t startOfEnumTimeInMS;                                // Time in MS when the enumeration started
             static bool haveReadTempsAtLeastOnce;                               // True if we have read the temps at least once in a cycle
 
+            // An enumeration that completes while in StartCycle is held for the next pass (ControlHeater) - the
+            // source's results buffer may be refilled by then, so it is copied
+            static array<DiscoveredTempSensor, 5> deferredResults;
+            static uint8_t deferredResultsSize;
+            static bool haveDeferredEnum;
+
             if (command == Command::Stop)
             {
                 // The forground task has requested that we stop
@@ -207,6 +244,7 @@ void BoilerControllerTask::loop()
 
                 // First time in the Running state - initialize our inner state machine
                 state = State::StartCycle;
+                haveDeferredEnum = false;
             }
 
             // Inner state machine for the Running state
@@ -215,7 +253,7 @@ void BoilerControllerTask::loop()
                 case State::StartCycle:
                 {
                     //printf(Serial, "BoilerControllerTask: Running: StartCycle; Changing to ControlHeater\n");
-                    logger.Printf(Logger::RecType::Info, "BoilerControllerTask: HeaterState::Running:");
+                    $Log(Boiler, Info, "BoilerControllerTask: HeaterState::Running:");
 
                     // Start of the Running cycle
                     coEnumTimeoutTimer.SetAlarm(coEnumTimeoutInMS);
@@ -225,6 +263,13 @@ void BoilerControllerTask::loop()
                     startOfEnumTimeInMS = millis();   // Capture the start time of the enumeration cycle
 
                     haveReadTempsAtLeastOnce = false;
+
+                    if (haveEnum)
+                    {
+                        deferredResults = *results;
+                        deferredResultsSize = resultsSize;
+                        haveDeferredEnum = true;
+                    }
                     state = State::ControlHeater;
                 }
                 break;
@@ -236,11 +281,16 @@ void BoilerControllerTask::loop()
                     float boilerInTemp = tempState._boilerInTemp;
                     float boilerOutTemp = tempState._boilerOutTemp;
 
-                    // First we try and absord an enum from the co-processor
-                    array<DiscoveredTempSensor, 5>* results;
-                    uint8_t resultsSize;
+                    // First we try and absord the enum (if any) completed this cycle - or held from StartCycle
+                    if (!haveEnum && haveDeferredEnum)
+                    {
+                        results = &deferredResults;
+                        resultsSize = deferredResultsSize;
+                        haveEnum = true;
+                    }
+                    haveDeferredEnum = false;
 
-                    if (OneWireCoProcEnumLoop(results, resultsSize))
+                    if (haveEnum)
                     {
                         // We have a completed CoProc enumeration - reconcile the results with our configured sensors; capture the temps as found
                         haveReadTempsAtLeastOnce = true;
@@ -279,12 +329,6 @@ void BoilerControllerTask::loop()
                                 boilerOutTemp = results->at(ix)._temp;
                                 boilerOutTempReadTimeoutTimer.SetAlarm(boilerOutTempReadTimeoutInMS);
                             }
-                            else
-                            {
-                                // This is a sensor we don't know about - log a warning
-                                logger.Printf(Logger::RecType::Warning, "BoilerControllerTask: OneWireCoProcEnumLoop: Unknown sensor ID: %" $PRIX64, 
-                                             To$PRIX64(results->at(ix)._id));
-                            }
                         }
                     }
 
@@ -420,17 +464,43 @@ BoilerControllerTask::~BoilerControllerTask()
     $FailFast();
 }
 
+// Accumulates the UART and CPU load of each sensor enum loop call into the current sampling mode's stats
+struct BoilerControllerTask::LoadSample
+{
+    BoilerControllerTask&   _task;
+    uint32_t                _startTimeInUSecs;
+    uint32_t                _bytesRead;
+
+    LoadSample(BoilerControllerTask& Task) : _task(Task), _startTimeInUSecs(micros()), _bytesRead(0) {}
+    ~LoadSample()
+    {
+        uint32_t const elapsed = micros() - _startTimeInUSecs;
+        synchronized
+        {
+            SamplingStats& stats = _task._samplingStats[(int)_task._samplingMode];
+            stats._uartBytes += _bytesRead;
+            stats._cpuTimeInUSecs += elapsed;
+        }
+    }
+};
+
 // Support for reading temperatures from the sensors - this is done via the OneWireCoProc attached to Serial1
 /**
  * @brief Performs the enumeration for a co-processor connected via OneWire protocol.
  * 
+ * The co-processor brackets each enumeration with "ESTART" (full bus enumeration) or "ESTARTP" (control
+ * sensor only - see SamplingPolicy) and "ESTOP".
+ * 
  * @param[out] Results Pointer to an array of DiscoveredTempSensor objects to store the enumeration results.
  * @param[out] ResultsSize Reference to an integer to store the size of the enumeration results.
+ * @param[out] IsFullEnum Set to true if the completed enumeration covered the whole bus.
  * @return true if the co-processor loop has completed the enumeration cycle, 
  *         false if it is still enumerating - keep calling.
  */
-bool BoilerControllerTask::OneWireCoProcEnumLoop(array<DiscoveredTempSensor, 5>*& Results, uint8_t& ResultsSize) 
+bool BoilerControllerTask::OneWireCoProcEnumLoop(array<DiscoveredTempSensor, 5>*& Results, uint8_t& ResultsSize, bool& IsFullEnum) 
 {
+    LoadSample load(*this);
+
     static bool firstTime = true;
     enum class State
     {
@@ -444,18 +514,18 @@ bool BoilerControllerTask::OneWireCoProcEnumLoop(array<DiscoveredTempSensor, 5>*
     static uint8_t      sensorIndex;
     static char         buffer[33];
     static uint8_t      bufferIndex;
+    static bool         isFullEnum;
 
     if (firstTime)
     {
         // Start of the enumeration cycle
         firstTime = false;
-        Serial1.begin(9600);
-        Serial1.setTimeout(0);                  // Just a polled environment - don't wait for anything
         state = State::StartCycle;
     }
 
     Results = nullptr;
     ResultsSize = 0;
+    IsFullEnum = false;
 
     switch (state)
     {
@@ -467,7 +537,11 @@ bool BoilerControllerTask::OneWireCoProcEnumLoop(array<DiscoveredTempSensor, 5>*
             {   // Drain any data in the serial buffer
                 byte        tossBuffer[32];
 
-                while (Serial1.readBytes(tossBuffer, sizeof(tossBuffer)) > 0) {}
+                size_t size;
+                while ((size = Serial1.readBytes(tossBuffer, sizeof(tossBuffer))) > 0)
+                {
+                    load._bytesRead += size;
+                }
             }
 
             state = State::HuntForEnum;
@@ -480,6 +554,7 @@ bool BoilerControllerTask::OneWireCoProcEnumLoop(array<DiscoveredTempSensor, 5>*
             while (Serial1.available())
             {
                 char c = Serial1.read();
+                load._bytesRead++;
                 if (c == '\n')                  // just drop the '\n' and wait for the '\r'
                     return false;
 
@@ -487,9 +562,10 @@ bool BoilerControllerTask::OneWireCoProcEnumLoop(array<DiscoveredTempSensor, 5>*
                 {
                     // End of line - check for the start of the enumeration
                     buffer[bufferIndex] = 0;
-                    if ((bufferIndex == 6) && (memcmp(buffer, "ESTART", 6) == 0))
+                    if (((bufferIndex == 6) || ((bufferIndex == 7) && (buffer[6] == 'P'))) && (memcmp(buffer, "ESTART", 6) == 0))
                     {
-                        // Start of the enumeration
+                        // Start of the enumeration - "ESTARTP" is a partial (control sensor only) enumeration
+                        isFullEnum = (bufferIndex == 6);
                         sensorIndex = 0;
                         bufferIndex = 0;
                         state = State::Enumerate;
@@ -529,6 +605,7 @@ bool BoilerControllerTask::OneWireCoProcEnumLoop(array<DiscoveredTempSensor, 5>*
             while (Serial1.available())
             {
                 char c = Serial1.read();
+                load._bytesRead++;
                 if (c == '\n') // just drop the '\n' and wait for the '\r'
                     return false;
 
@@ -541,6 +618,12 @@ bool BoilerControllerTask::OneWireCoProcEnumLoop(array<DiscoveredTempSensor, 5>*
                         // End of the enumeration
                         Results = &sensors;
                         ResultsSize = sensorIndex;
+                        IsFullEnum = isFullEnum;
+
+                        synchronized
+                        {
+                            _samplingStats[(int)_samplingMode]._enumCount++;
+                        }
                         
                         state = State::StartCycle;
                         return true;
@@ -624,6 +707,406 @@ bool BoilerControllerTask::OneWireCoProcEnumLoop(array<DiscoveredTempSensor, 5>*
     return false;
 }
 
+#if SPA_SENSOR_SOURCE == SPA_SENSOR_SOURCE_NATIVE
+// Support for reading temperatures from the sensors natively - OneWireNative on _oneWireBusPin
+/**
+ * @brief Native counterpart of OneWireCoProcEnumLoop() - same results contract, no co-processor.
+ * 
+ * Each call advances the enumeration by at most one step and never waits on the bus; the bus time
+ * slots are run by the OneWireNative timer ISR. A full enumeration is a Search ROM sweep, a Skip ROM
+ * Convert T to all sensors, then a Match ROM Read Scratchpad per sensor. A partial enumeration
+ * converts and reads the SamplingPolicy's control sensor only. Full and partial enumerations are
+ * scheduled from _samplingPolicy just as the co-processor does.
+ * 
+ * @param[out] Results Pointer to an array of DiscoveredTempSensor objects to store the enumeration results.
+ * @param[out] ResultsSize Reference to an integer to store the size of the enumeration results.
+ * @param[out] IsFullEnum Set to true if the completed enumeration covered the whole bus.
+ * @return true if the enumeration cycle has completed, false if it is still enumerating - keep calling.
+ */
+bool BoilerControllerTask::OneWireNativeEnumLoop(array<DiscoveredTempSensor, 5>*& Results, uint8_t& ResultsSize, bool& IsFullEnum)
+{
+    LoadSample load(*this);
+
+    enum class State
+    {
+        StartCycle,         // Wait for the next full or partial enumeration to be due
+        Search,             // Search ROM sweep - full enumeration only
+        Convert,            // Convert T issued
+        WaitForConversion,  // Wait for the sensors to complete the conversion
+        ReadScratchpad,     // Reading each sensor's scratchpad
+    };
+    static State state = State::StartCycle;
+
+    static constexpr uint32_t conversionTimeInMS = 750;     // 12 bit DS18B20 conversion
+
+    static array<DiscoveredTempSensor, 5> sensors;  // Max of 5 sensors
+    static uint8_t      sensorCount;                // Sensors to read this cycle
+    static uint8_t      sensorIndex;                // Sensor being read
+    static uint8_t      validCount;                 // Sensors read successfully - compacted to the front of sensors
+    static bool         isFullEnum;
+    static bool         firstTime = true;
+    static uint32_t     lastBusEnumTimeInMS;
+    static uint32_t     lastControlReadTimeInMS;
+    static Timer        conversionTimer;
+    uint8_t             tx[OneWireNative::MaxTxBytes];
+
+    Results = nullptr;
+    ResultsSize = 0;
+    IsFullEnum = false;
+
+    auto StartMatchRomTransaction = [this, &tx](uint64_t Id, uint8_t Cmd, uint8_t RxLen)
+    {
+        tx[0] = OneWireNative::MatchRomCmd;
+        memcpy(&tx[1], &Id, sizeof(Id));           // ROM code is sent LS byte (family code) first
+        tx[9] = Cmd;
+        _oneWire.StartTransaction(tx, 10, RxLen);
+    };
+
+    auto CompleteCycle = [&]() -> bool
+    {
+        Results = &sensors;
+        ResultsSize = validCount;
+        IsFullEnum = isFullEnum;
+
+        synchronized
+        {
+            _samplingStats[(int)_samplingMode]._enumCount++;
+        }
+
+        state = State::StartCycle;
+        return true;
+    };
+
+    switch (state)
+    {
+        case State::StartCycle:
+        {
+            uint32_t const now = millis();
+
+            validCount = 0;
+            if (firstTime || (_samplingPolicy._busPeriodInMS == 0) || ((now - lastBusEnumTimeInMS) >= _samplingPolicy._busPeriodInMS))
+            {
+                firstTime = false;
+                lastBusEnumTimeInMS = now;
+                lastControlReadTimeInMS = now;
+
+                isFullEnum = true;
+                sensorCount = 0;
+                _oneWire.ResetSearch();
+                _oneWire.StartSearch();
+                state = State::Search;
+            }
+            else if ((_samplingPolicy._controlPeriodInMS != 0) && ((now - lastControlReadTimeInMS) >= _samplingPolicy._controlPeriodInMS))
+            {
+                lastControlReadTimeInMS = now;
+
+                isFullEnum = false;
+                sensors[0]._id = _samplingPolicy._controlSensorId;
+                sensorCount = 1;
+                StartMatchRomTransaction(sensors[0]._id, OneWireNative::ConvertTCmd, 0);
+                state = State::Convert;
+            }
+            return false;
+        }
+        break;
+
+        case State::Search:
+        {
+            if (_oneWire.IsBusy())
+                return false;
+
+            if (_oneWire.GetStatus() == OneWireNative::Status::NoPresence)
+            {
+                // Nothing on the bus
+                return CompleteCycle();
+            }
+            if (_oneWire.GetStatus() != OneWireNative::Status::Done)
+            {
+                // The sweep failed part way - it says nothing about the sensors not reached, so discovery must
+                // not count them as missing
+                isFullEnum = false;
+                return CompleteCycle();
+            }
+
+            uint64_t const rom = _oneWire.GetSearchRom();
+            uint8_t const* romBytes = (uint8_t const*)&rom;
+            uint8_t const family = romBytes[0];
+
+            if (OneWireNative::Crc8(romBytes, 7) != romBytes[7])
+            {
+                synchronized
+                {
+                    _oneWireStats._totalFormatErrors++;
+                }
+            }
+            else if ((family == 0x10) || (family == 0x22) || (family == 0x28))  // DS18S20, DS1822, DS18B20
+            {
+                if (sensorCount < sensors.size())
+                {
+                    sensors[sensorCount++]._id = rom;
+                }
+                else
+                {
+                    synchronized
+                    {
+                        _oneWireStats._totalSensorCountOverflowErrors++;
+                    }
+                }
+            }
+
+            if (!_oneWire.IsLastDevice())
+            {
+                _oneWire.StartSearch();
+                return false;
+            }
+
+            tx[0] = OneWireNative::SkipRomCmd;
+            tx[1] = OneWireNative::ConvertTCmd;
+            _oneWire.StartTransaction(tx, 2, 0);
+            state = State::Convert;
+            return false;
+        }
+        break;
+
+        case State::Convert:
+        {
+            if (_oneWire.IsBusy())
+                return false;
+
+            if (_oneWire.GetStatus() != OneWireNative::Status::Done)
+            {
+                isFullEnum = false;                 // no readings - not an empty bus
+                return CompleteCycle();
+            }
+            if (sensorCount == 0)
+            {
+                return CompleteCycle();
+            }
+
+            conversionTimer.SetAlarm(conversionTimeInMS);
+            state = State::WaitForConversion;
+            return false;
+        }
+        break;
+
+        case State::WaitForConversion:
+        {
+            if (!conversionTimer.IsAlarmed())
+                return false;
+
+            sensorIndex = 0;
+            StartMatchRomTransaction(sensors[sensorIndex]._id, OneWireNative::ReadScratchpadCmd, 9);
+            state = State::ReadScratchpad;
+            return false;
+        }
+        break;
+
+        case State::ReadScratchpad:
+        {
+            if (_oneWire.IsBusy())
+                return false;
+
+            uint8_t const* scratchpad = _oneWire.GetRxBytes();
+            if ((_oneWire.GetStatus() == OneWireNative::Status::Done) && (OneWireNative::Crc8(scratchpad, 8) == scratchpad[8]))
+            {
+                int16_t const raw = (int16_t)((scratchpad[1] << 8) | scratchpad[0]);
+                bool const isDS18S20 = ((uint8_t)sensors[sensorIndex]._id == 0x10);     // 9 bit, 0.5C per count
+
+                sensors[validCount]._id = sensors[sensorIndex]._id;
+                sensors[validCount]._temp = isDS18S20 ? (raw / 2.0) : (raw / 16.0);
+                validCount++;
+            }
+            else
+            {
+                synchronized
+                {
+                    _oneWireStats._totalFormatErrors++;
+                }
+            }
+
+            if (++sensorIndex < sensorCount)
+            {
+                StartMatchRomTransaction(sensors[sensorIndex]._id, OneWireNative::ReadScratchpadCmd, 9);
+                return false;
+            }
+
+            return CompleteCycle();
+        }
+        break;
+
+        default:
+        {
+            $FailFast();
+        }
+    }
+
+    return false;
+}
+#endif
+
+// Sensor discovery service - keeps the discovered sensor set current from the normal enumeration stream
+/**
+ * @brief Reconciles a completed full enumeration with the discovered sensor set.
+ * 
+ * New sensors are added at once; a known sensor is only removed after missing _sensorRemoveMissCount
+ * consecutive full enumerations so a single bad enumeration does not churn the set. Each change queues
+ * a SensorEvent for the foreground task and bumps _discoverySequence.
+ */
+void BoilerControllerTask::UpdateDiscoveredSensors(const array<DiscoveredTempSensor, 5>& Results, uint8_t ResultsSize)
+{
+    uint32_t const nowInMS = millis();
+
+    synchronized
+    {
+        // Age the known sensors - remove any that have been missing for too long
+        for (int ix = _discoveredSensorCount - 1; ix >= 0; ix--)
+        {
+            TempSensorEntry& entry = _discoveredSensors[ix];
+            bool found = false;
+
+            for (int rx = 0; rx < ResultsSize; rx++)
+            {
+                if (Results[rx]._id == entry._id)
+                {
+                    found = true;
+                    break;
+                }
+            }
+
+            if (found)
+            {
+                entry._lastSeenTimeInMS = nowInMS;
+                entry._missedFullEnums = 0;
+            }
+            else if (++entry._missedFullEnums >= _sensorRemoveMissCount)
+            {
+                PushSensorEvent(SensorEvent::Type::Removed, entry._id);
+                memmove(&_discoveredSensors[ix], &_discoveredSensors[ix + 1], (_discoveredSensorCount - ix - 1) * sizeof(TempSensorEntry));
+                _discoveredSensorCount--;
+                _discoverySequence++;
+            }
+        }
+
+        // Add any sensors we have not seen before
+        for (int rx = 0; rx < ResultsSize; rx++)
+        {
+            bool known = false;
+            for (int ix = 0; ix < _discoveredSensorCount; ix++)
+            {
+                if (_discoveredSensors[ix]._id == Results[rx]._id)
+                {
+                    known = true;
+                    break;
+                }
+            }
+
+            if (!known && (_discoveredSensorCount < MaxTempSensors))
+            {
+                _discoveredSensors[_discoveredSensorCount++] = { Results[rx]._id, nowInMS, 0 };
+                PushSensorEvent(SensorEvent::Type::Added, Results[rx]._id);
+                _discoverySequence++;
+            }
+        }
+    }
+}
+
+// Queues a sensor discovery event for the foreground task - caller must be synchronized
+void BoilerControllerTask::PushSensorEvent(SensorEvent::Type Type, uint64_t Id)
+{
+    uint8_t const next = (_sensorEventHead + 1) % (sizeof(_sensorEvents) / sizeof(_sensorEvents[0]));
+    if (next == _sensorEventTail)
+    {
+        _sensorEventOverflows++;            // Foreground task is not keeping up - drop the event
+        return;
+    }
+
+    _sensorEvents[_sensorEventHead] = { Type, Id };
+    _sensorEventHead = next;
+}
+
+// Support for adapting the one-wire bus sampling rate to the controller's state
+/**
+ * @brief Picks the sampling mode for the current controller state and hands the matching policy to the co-processor.
+ * 
+ * The control sensor (boilerIn) is sampled fastest when it is near either hysteresis threshold or the heater
+ * has just switched; the whole bus is sampled slowly when nothing depends on the temps (Halted, Faulted or Off).
+ * The policy is only sent when it changes - and periodically in case the co-processor has been reset.
+ */
+void BoilerControllerTask::UpdateSamplingPolicy(const TempertureState& State, const TempSensorIds& Sensors)
+{
+    // Rates for each SamplingMode. Note: boilerIn must be read at least every boilerInTempReadTimeoutInMS (10s)
+    // in the Running state or the controller will fault
+    static constexpr SamplingPolicy policies[(int)SamplingMode::Count] =
+    {
+        {10000, 0, 0},      // Idle
+        {5000, 0, 0},       // Off
+        {6000, 2000, 0},    // Normal
+        {6000, 750, 0},     // NearThreshold - a 12 bit DS18B20 conversion takes 750ms
+    };
+
+    SamplingMode mode;
+    if (_state != StateMachineState::Running)
+    {
+        mode = SamplingMode::Idle;
+    }
+    else if ((_boilerMode != BoilerMode::Eco) && (_boilerMode != BoilerMode::Performance))
+    {
+        mode = SamplingMode::Off;
+    }
+    else
+    {
+        float const hardOffTemp = State._setPoint + State._hysteresis;
+        float const hardOnTemp = State._setPoint - State._hysteresis;
+        bool const nearThreshold = (fabsf(State._boilerInTemp - hardOffTemp) <= _nearThresholdBandInC) ||
+                                   (fabsf(State._boilerInTemp - hardOnTemp) <= _nearThresholdBandInC);
+        bool const recentlySwitched = ((millis() - _lastHeaterSwitchTimeInMS) < _heaterSwitchSettleTimeInMS);
+
+        mode = (nearThreshold || recentlySwitched) ? SamplingMode::NearThreshold : SamplingMode::Normal;
+    }
+
+    SamplingPolicy policy = policies[(int)mode];
+    if ((policy._controlPeriodInMS != 0) && TempSensorsConfig::IsSensorIdValid(Sensors._boilerInTempSensorId))
+    {
+        policy._controlSensorId = Sensors._boilerInTempSensorId;
+    }
+    else
+    {
+        policy._controlPeriodInMS = 0;
+    }
+
+    static Timer refreshTimer;
+    if ((mode != _samplingMode) ||
+        (policy._busPeriodInMS != _samplingPolicy._busPeriodInMS) ||
+        (policy._controlPeriodInMS != _samplingPolicy._controlPeriodInMS) ||
+        (policy._controlSensorId != _samplingPolicy._controlSensorId) ||
+        refreshTimer.IsAlarmed())
+    {
+        synchronized
+        {
+            _samplingMode = mode;
+            _samplingPolicy = policy;
+        }
+
+    #if SPA_SENSOR_SOURCE == SPA_SENSOR_SOURCE_COPROC
+        SendSamplingPolicyToCoProc();       // The native source reads _samplingPolicy directly
+    #endif
+        refreshTimer.SetAlarm(_policyRefreshTimeInMS);
+    }
+}
+
+/**
+ * @brief Sends the current sampling policy to the co-processor.
+ * 
+ * Format: SP;<bus period in ms>;<control period in ms>;<control sensor ID - 16 HEX digits><\r>
+ */
+void BoilerControllerTask::SendSamplingPolicyToCoProc()
+{
+    printf(Serial1, "SP;%u;%u;%" $PRIX64 "\r",
+           _samplingPolicy._busPeriodInMS,
+           _samplingPolicy._controlPeriodInMS,
+           To$PRIX64(_samplingPolicy._controlSensorId));
+}
+
 
 //** Getters and setters for the various parameters - these methods are thread safe
 BoilerControllerTask::FaultReason BoilerControllerTask::GetFaultReason()
@@ -755,6 +1238,57 @@ void BoilerControllerTask::ClearOneWireBusStats()
     }
 }
 
+uint8_t BoilerControllerTask::GetTempSensors(array<TempSensorEntry, MaxTempSensors>& Sensors, uint32_t& Sequence)
+{
+    synchronized
+    {
+        memcpy(Sensors.data(), &_discoveredSensors[0], _discoveredSensorCount * sizeof(TempSensorEntry));
+        Sequence = _discoverySequence;
+        return _discoveredSensorCount;
+    }
+}
+
+uint32_t BoilerControllerTask::GetSensorEventOverflows()
+{
+    synchronized
+    {
+        return _sensorEventOverflows;
+    }
+}
+
+bool BoilerControllerTask::GetSensorEvent(SensorEvent& Event)
+{
+    synchronized
+    {
+        if (_sensorEventHead == _sensorEventTail)
+        {
+            return false;
+        }
+
+        Event = _sensorEvents[_sensorEventTail];
+        _sensorEventTail = (_sensorEventTail + 1) % (sizeof(_sensorEvents) / sizeof(_sensorEvents[0]));
+        return true;
+    }
+}
+
+void BoilerControllerTask::ClearSamplingStats()
+{
+    synchronized
+    {
+        memset(&_samplingStats[0], 0, sizeof(_samplingStats));
+    }
+}
+
+void BoilerControllerTask::GetSamplingState(SamplingMode& Mode, SamplingPolicy& Policy, SamplingStats (&Stats)[(int)SamplingMode::Count])
+{
+    synchronized
+    {
+        Mode = _samplingMode;
+        Policy = _samplingPolicy;
+        memcpy(&Stats[0], &_samplingStats[0], sizeof(_samplingStats));
+    }
+}
+
 void BoilerControllerTask::SetAllBoilerParametersFromConfig()
 {
     BoilerControllerTask::TargetTemps temps;
@@ -901,6 +1435,25 @@ void BoilerControllerTask::DisplayOneWireBusStats(Stream& output, const OneWireB
     printf(output, PSTR("%sTotalSensorCountOverflowErrors: %u\n"), prependString, stats._totalSensorCountOverflowErrors);
 }
 
+void BoilerControllerTask::DisplaySamplingStats(Stream& output, const SamplingStats (&stats)[(int)SamplingMode::Count], const char* prependString)
+{
+    for (int ix = 0; ix < (int)SamplingMode::Count; ix++)
+    {
+        SamplingStats const& s = stats[ix];
+        uint32_t const timeInSecs = s._timeInModeInMS / 1000;
+
+        printf(output, "%s%s: Time: %us; Enums: %u; UART: %u bytes (%u B/s); CPU: %sus (%.3f%%)\n",
+               prependString,
+               GetSamplingModeDescription((SamplingMode)ix),
+               timeInSecs,
+               s._enumCount,
+               s._uartBytes,
+               (timeInSecs > 0) ? (s._uartBytes / timeInSecs) : 0,
+               UInt64ToString(s._cpuTimeInUSecs),
+               (s._timeInModeInMS > 0) ? ((float)s._cpuTimeInUSecs / ((float)s._timeInModeInMS * 10.0)) : 0.0);
+    }
+}
+
 // Helpers for the Console methods
 void BoilerControllerTask::ShowCurrentBoilerConfig(Stream &Out, int PostLineFeedCount)
 {
@@ -948,19 +1501,21 @@ void BoilerControllerTask::ShowCurrentBoilerConfig(Stream &Out, int PostLineFeed
         Out.println("   No Temp Sensors Configured");
     }
 
-    Out.println("Temp Sensors Discovered:");
-    auto const sensors = boilerControllerTask.GetTempSensors();
-    int i = 0;
+    array<BoilerControllerTask::TempSensorEntry, BoilerControllerTask::MaxTempSensors> sensors;
+    uint32_t sequence;
+    uint8_t const sensorCount = boilerControllerTask.GetTempSensors(sensors, sequence);
+    uint32_t const nowInMS = millis();
 
-    for (auto const &sensor : sensors)
+    printf(Out, "Temp Sensors Discovered (Seq: %u):\n", sequence);
+    for (int i = 0; i < sensorCount; i++)
     {
-        i++;
-        printf(Out, "   %d) %" $PRIX64 "  --  ", i, To$PRIX64(sensor));
+        uint64_t const& sensor = sensors[i]._id;
+        printf(Out, "   %d) %" $PRIX64 "  --  ", i + 1, To$PRIX64(sensor));
         for (uint8_t *byte = ((uint8_t *)(&sensor)); byte < ((uint8_t *)(&sensor)) + sizeof(sensor); ++byte)
         {
             printf(Out, " %d", *byte);
         }
-        Out.println();
+        printf(Out, "  (seen %us ago)\n", (nowInMS - sensors[i]._lastSeenTimeInMS) / 1000);
     }
 
     Out.println("Boiler Config:");
@@ -1034,14 +1589,18 @@ CmdLine::Status AssignTempConfigProcessor(Stream &CmdStream, int Argc, char cons
         return CmdLine::Status::UnexpectedParameterCount;
     }
 
+    array<BoilerControllerTask::TempSensorEntry, BoilerControllerTask::MaxTempSensors> sensors;
+    uint32_t sequence;
+    uint8_t const sensorCount = boilerControllerTask.GetTempSensors(sensors, sequence);
+
     int sensorNumber = atoi(Args[1]);
-    if ((sensorNumber < 1) || (sensorNumber > boilerControllerTask.GetTempSensors().size()))
+    if ((sensorNumber < 1) || (sensorNumber > sensorCount))
     {
         CmdStream.println("Invalid sensor number");
         return CmdLine::Status::CommandFailed;
     }
 
-    auto const sensorId = boilerControllerTask.GetTempSensors()[sensorNumber - 1];
+    auto const sensorId = sensors[sensorNumber - 1]._id;
     
     if (strcmp(Args[2], "ambiant") == 0)
     {
@@ -1265,6 +1824,32 @@ CmdLine::Status ClearOneWireStatsControlProcessor(Stream &CmdStream, int Argc, c
     }
 
     boilerControllerTask.ClearOneWireBusStats();
+    boilerControllerTask.ClearSamplingStats();
+
+    return CmdLine::Status::Ok;
+}
+
+CmdLine::Status ShowSamplingControlProcessor(Stream &CmdStream, int Argc, char const **Args, void *Context)
+{
+    if (Argc != 1)
+    {
+        printf(CmdStream, "Show sampling policy and load. Usage: sampling");
+        return CmdLine::Status::UnexpectedParameterCount;
+    }
+
+    BoilerControllerTask::SamplingMode mode;
+    BoilerControllerTask::SamplingPolicy policy;
+    BoilerControllerTask::SamplingStats stats[(int)BoilerControllerTask::SamplingMode::Count];
+    boilerControllerTask.GetSamplingState(mode, policy, stats);
+
+    printf(CmdStream, "Sampling Mode: %s\n", BoilerControllerTask::GetSamplingModeDescription(mode));
+    printf(CmdStream, "    Bus Period: %ums; Control Sensor Period: %ums; Control Sensor ID: %" $PRIX64 "\n",
+           policy._busPeriodInMS,
+           policy._controlPeriodInMS,
+           To$PRIX64(policy._controlSensorId));
+    printf(CmdStream, "    Load per Sampling Mode:\n");
+    BoilerControllerTask::DisplaySamplingStats(CmdStream, stats, "        ");
+    CmdStream.println();
 
     return CmdLine::Status::Ok;
 }
@@ -1286,7 +1871,8 @@ CmdLine::ProcessorDesc controlBoilerCmdProcessors[] =
     {StopBoilerControlProcessor, "Stop", "Stop the boiler state machine - only if it is Running. Usage: setBoilerConfig"},
     {ResetBoilerControlProcessor, "Reset", "Reset the boiler state machine - only if it is Faulted. Usage: setBoilerConfig"},
     {ShowBoilerControlProcessor, "show", "Show current boiler state"},
-    {ClearOneWireStatsControlProcessor, "clearOWStats", "Clear the OneWire Bus Stats"},
+    {ClearOneWireStatsControlProcessor, "clearOWStats", "Clear the OneWire Bus and Sampling Stats"},
+    {ShowSamplingControlProcessor, "sampling", "Show the sensor sampling policy and the UART/CPU load per sampling mode"},
     {ConfigBoilerProcessor, "config", "Config menu for the Boiler"},
     {ExitBoilerControlProcessor, "exit", "Exit the control of the boiler"},
 };
@@ -6,6 +6,14 @@
 #pragma once
 
 #include "SpaHeaterCntl.hpp"
+#include "OneWireNative.hpp"
+
+//** Temperature sensor source - selected at build time (e.g. -DSPA_SENSOR_SOURCE=SPA_SENSOR_SOURCE_NATIVE)
+#define SPA_SENSOR_SOURCE_COPROC    1       // OneWireCoProc on a separate Arduino attached to Serial1
+#define SPA_SENSOR_SOURCE_NATIVE    2       // Timer interrupt driven 1-Wire master (OneWireNative) on _oneWireBusPin
+#if !defined(SPA_SENSOR_SOURCE)
+#define SPA_SENSOR_SOURCE           SPA_SENSOR_SOURCE_COPROC
+#endif
 
 /*
  * The BoilerControllerTask class is part of the Maxie HA system 2024 developed by TinyBus.
@@ -152,6 +160,84 @@ public:
     };
     static void DisplayOneWireBusStats(Stream& output, const OneWireBusStats& stats, const char* prependString = "");
 
+    // Sampling modes for the one-wire bus - selected each cycle from the controller's state
+    enum class SamplingMode
+    {
+        Idle,           // Halted or Faulted - nothing depends on the temps; slowest bus rate
+        Off,            // Running but the boiler mode is off - only fault detection depends on the temps
+        Normal,         // Running and heating is enabled - boilerIn is well away from the thresholds
+        NearThreshold,  // Running and boilerIn is near a threshold or the heater has just switched
+        Count           // Number of sampling modes - must be last
+    };
+    static constexpr const char* GetSamplingModeDescription(SamplingMode mode)
+    {
+        switch (mode)
+        {
+            case SamplingMode::Idle:
+                return PSTR("Idle");
+            case SamplingMode::Off:
+                return PSTR("Off");
+            case SamplingMode::Normal:
+                return PSTR("Normal");
+            case SamplingMode::NearThreshold:
+                return PSTR("NearThreshold");
+            default:
+                return PSTR("Unknown");
+        }
+    }
+
+    // Sampling policy handed to the sensor source (OneWireCoProc). A full bus enumeration is done every
+    // _busPeriodInMS; between those the control sensor (boilerIn) alone is read every _controlPeriodInMS.
+    struct SamplingPolicy
+    {
+        uint32_t    _busPeriodInMS;
+        uint32_t    _controlPeriodInMS;     // zero if no control sensor only reads are to be done
+        uint64_t    _controlSensorId;
+    };
+
+    // Diagnostic UART and CPU load counters for each sampling mode
+    struct SamplingStats
+    {
+        uint32_t    _timeInModeInMS;        // total time spent in the mode
+        uint32_t    _enumCount;             // completed enumerations (full or control sensor only)
+        uint32_t    _uartBytes;             // bytes received from the co-processor
+        uint64_t    _cpuTimeInUSecs;        // time spent in OneWireCoProcEnumLoop()
+    };
+    static void DisplaySamplingStats(Stream& output, const SamplingStats (&stats)[(int)SamplingMode::Count], const char* prependString = "");
+
+    // Discovered temperature sensors - kept current from the full bus enumerations (hot-plug)
+    static constexpr uint8_t MaxTempSensors = 5;
+    struct TempSensorEntry
+    {
+        uint64_t    _id;
+        uint32_t    _lastSeenTimeInMS;      // millis() of the last full enumeration that found the sensor
+        uint8_t     _missedFullEnums;       // consecutive full enumerations that did not find the sensor
+    };
+
+    // Sensor discovery events - queued by the boiler controller task, drained by the foreground task
+    struct SensorEvent
+    {
+        enum class Type : uint8_t
+        {
+            Added,
+            Removed,
+        };
+        Type        _type;
+        uint64_t    _id;
+    };
+    static constexpr const char* GetSensorEventTypeDescription(SensorEvent::Type type)
+    {
+        switch (type)
+        {
+            case SensorEvent::Type::Added:
+                return PSTR("Added");
+            case SensorEvent::Type::Removed:
+                return PSTR("Removed");
+            default:
+                return PSTR("Unknown");
+        }
+    }
+
     // Boiler Modes - same as HA UI
     enum class BoilerMode
     {
@@ -208,7 +294,9 @@ public:
     void SetMode(BoilerMode Mode);
     BoilerMode GetMode();
 
-    inline const vector<uint64_t> &GetTempSensors() const { return _sensors; }
+    uint8_t GetTempSensors(array<TempSensorEntry, MaxTempSensors>& Sensors, uint32_t& Sequence);
+    bool GetSensorEvent(SensorEvent& Event);
+    uint32_t GetSensorEventOverflows();     // events dropped because the foreground task was not keeping up
     FaultReason GetFaultReason();
     StateMachineState GetStateMachineState();
     uint32_t GetHeaterStateSequence();
@@ -223,6 +311,9 @@ public:
     void ClearOneWireBusStats();
     void GetOneWireBusStats(OneWireBusStats& Stats);
 
+    void ClearSamplingStats();
+    void GetSamplingState(SamplingMode& Mode, SamplingPolicy& Policy, SamplingStats (&Stats)[(int)SamplingMode::Count]);
+
     void SetAllBoilerParametersFromConfig();
 
     // Console display helpers
@@ -238,6 +329,7 @@ private:
     };    
 
 private:
+    struct LoadSample;
     void SnapshotTempSensors(TempSensorIds& SensorIds);
     void SnapshotTargetTemps(TargetTemps& Temps);
     void SnapshotTempState(TempertureState& State);
@@ -245,7 +337,20 @@ private:
     void SafeSetFaultReason(FaultReason Reason);
     void SafeSetStateMachineState(StateMachineState State);
     void SafeClearCommand();
-    bool OneWireCoProcEnumLoop(array<DiscoveredTempSensor, 5>*& Results, uint8_t& ResultsSize);
+    bool OneWireCoProcEnumLoop(array<DiscoveredTempSensor, 5>*& Results, uint8_t& ResultsSize, bool& IsFullEnum);
+    bool OneWireNativeEnumLoop(array<DiscoveredTempSensor, 5>*& Results, uint8_t& ResultsSize, bool& IsFullEnum);
+    inline bool SensorEnumLoop(array<DiscoveredTempSensor, 5>*& Results, uint8_t& ResultsSize, bool& IsFullEnum)
+    {
+    #if SPA_SENSOR_SOURCE == SPA_SENSOR_SOURCE_NATIVE
+        return OneWireNativeEnumLoop(Results, ResultsSize, IsFullEnum);
+    #else
+        return OneWireCoProcEnumLoop(Results, ResultsSize, IsFullEnum);
+    #endif
+    }
+    void UpdateSamplingPolicy(const TempertureState& State, const TempSensorIds& Sensors);
+    void SendSamplingPolicyToCoProc();
+    void UpdateDiscoveredSensors(const array<DiscoveredTempSensor, 5>& Results, uint8_t ResultsSize);
+    void PushSensorEvent(SensorEvent::Type Type, uint64_t Id);
 
     virtual void setup() override final;
     virtual void loop() override final;
@@ -253,7 +358,14 @@ private:
 private:
     static constexpr uint8_t    _heaterControlPin = 4;
     static constexpr uint8_t    _heaterActiveLedPin = 13;
-    vector<uint64_t>            _sensors;
+    static constexpr uint8_t    _oneWireBusPin = 2;         // SPA_SENSOR_SOURCE_NATIVE only
+    TempSensorEntry             _discoveredSensors[MaxTempSensors];
+    uint8_t                     _discoveredSensorCount;
+    uint32_t                    _discoverySequence;     // incremented on each change to the discovered set
+    SensorEvent                 _sensorEvents[8];       // ring: _sensorEventHead == _sensorEventTail when empty
+    uint8_t                     _sensorEventHead;
+    uint8_t                     _sensorEventTail;
+    uint32_t                    _sensorEventOverflows;
     TempSensorIds               _sensorIds; 
     StateMachineState           _state;
     TargetTemps                 _targetTemps;
@@ -262,6 +374,21 @@ private:
     Command                     _command;
     OneWireBusStats             _oneWireStats;
     BoilerMode                  _boilerMode;
+    SamplingMode                _samplingMode;
+    SamplingPolicy              _samplingPolicy;
+    SamplingStats               _samplingStats[(int)SamplingMode::Count];
+    uint32_t                    _lastHeaterSwitchTimeInMS;
+#if SPA_SENSOR_SOURCE == SPA_SENSOR_SOURCE_NATIVE
+    OneWireNative               _oneWire;
+#endif
+
+    // Sampling policy tuning
+    static constexpr float      _nearThresholdBandInC = 0.5;                // boilerIn within this of a threshold is "near"
+    static constexpr uint32_t   _heaterSwitchSettleTimeInMS = 30 * 1000;    // stay at the fast rate this long after a switch
+    static constexpr uint32_t   _policyRefreshTimeInMS = 30 * 1000;         // resend the policy this often (co-proc may reset)
+
+    // Sensor discovery tuning
+    static constexpr uint8_t    _sensorRemoveMissCount = 3;     // full enumerations a sensor must miss before it is removed
 };
 
 //* Temperture Sensor Config Record - In persistant storage
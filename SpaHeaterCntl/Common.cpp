@@ -14,14 +14,22 @@
  * @brief Causes the program to fail fast and enter an infinite loop.
  * 
  * This function is used to indicate a critical error in the program and halt its execution.
- * It prints the file name and line number where the error occurred, sets the built-in LED pin as an output,
- * and enters an infinite loop, toggling the LED state at approx 10 times/sec.
+ * It writes out the log records still queued for Serial (typically the Critical record explaining the
+ * failure), prints the file name and line number where the error occurred, sets the built-in LED pin as
+ * an output, and enters an infinite loop, toggling the LED state at approx 10 times/sec.
  * 
  * @param FileName The name of the file where the error occurred.
  * @param LineNumber The line number where the error occurred.
  */
 void __attribute__ ((noinline)) FailFast(const char* FileName, int LineNumber)
 {
+    static bool isFailing = false;
+    if (!isFailing)
+    {
+        isFailing = true;               // a failure while draining must not recurse
+        FailFastDrainLog();
+    }
+
     Serial.print("\n\r**** FAIL FAST ----- at line: ");
     Serial.print(LineNumber);
     Serial.print(" in file: '");
@@ -90,28 +98,235 @@ char const *const UInt64ToString(uint64_t Value)
     return &buffer[i + 1]; // Adjust the pointer to skip any unused positions
 }
 
+//** MonotonicClock implementation
+// Consistent snapshot of the 64-bit tick count and the cycles into the current tick
+bool MonotonicClock::ReadTicks(uint64_t& Ticks, uint32_t& SubTickCycles, uint32_t& CyclesPerTick)
+{
+    if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED)
+    {
+        return false;
+    }
+
+    TimeOut_t timeOut;
+    uint32_t valBefore;
+    uint32_t valAfter;
+    bool tickPending;
+
+    taskENTER_CRITICAL();
+    {
+        vTaskSetTimeOutState(&timeOut);             // tick count and overflow count - read together by the kernel
+        valBefore = SysTick->VAL;
+        tickPending = (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0;
+        valAfter = SysTick->VAL;
+        CyclesPerTick = SysTick->LOAD + 1;
+    }
+    taskEXIT_CRITICAL();
+
+    Ticks = ((uint64_t)(uint32_t)timeOut.xOverflowCount << 32) | timeOut.xTimeOnEntering;
+
+    // SysTick counts down. If it reloaded before the pending flag was read, the tick interrupt has not yet
+    // counted that tick (it is held off by the critical section) - count it here and use the reading
+    // taken after the reload.
+    if (tickPending)
+    {
+        Ticks++;
+        SubTickCycles = CyclesPerTick - 1 - valAfter;
+    }
+    else
+    {
+        SubTickCycles = CyclesPerTick - 1 - valBefore;
+    }
+
+    return true;
+}
+
+uint64_t MonotonicClock::NowInUSecs()
+{
+    uint64_t ticks;
+    uint32_t subTickCycles;
+    uint32_t cyclesPerTick;
+
+    if (!ReadTicks(ticks, subTickCycles, cyclesPerTick))
+    {
+        return 0;
+    }
+
+    constexpr uint32_t uSecsPerTick = 1000000 / configTICK_RATE_HZ;
+    return (ticks * uSecsPerTick) + ((subTickCycles * uSecsPerTick) / cyclesPerTick);
+}
+
+uint64_t MonotonicClock::NowInMSecs()
+{
+    if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED)
+    {
+        return 0;
+    }
+
+    TimeOut_t timeOut;
+    vTaskSetTimeOutState(&timeOut);
+
+    uint64_t const ticks = ((uint64_t)(uint32_t)timeOut.xOverflowCount << 32) | timeOut.xTimeOnEntering;
+    return (ticks * 1000) / configTICK_RATE_HZ;
+}
+
 // system us resolution clock
 USecClock uSecSystemClock;
 
 // Percounters functions
-void PerfCounter::Print(Stream &ToStream, int IndentBy)
+void PrintPerfCounter(Stream &ToStream, int IndentBy, uint64_t Samples, uint64_t TotalInUSecs, uint64_t MaxInUSecs, uint64_t MinInUSecs)
 {
     for (int i = 0; i < IndentBy; i++) ToStream.print(" ");
     ToStream.print("Avg: ");
-    ToStream.print(UInt64ToString(_totalTimeInUSecs / _totalSamples));
+    ToStream.print(UInt64ToString(TotalInUSecs / Samples));
     ToStream.println("us");
 
     for (int i = 0; i < IndentBy; i++) ToStream.print(" ");
     ToStream.print("Max: ");
-    ToStream.print(UInt64ToString(_maxTimeInUSecs));
+    ToStream.print(UInt64ToString(MaxInUSecs));
     ToStream.println("us");
 
     for (int i = 0; i < IndentBy; i++) ToStream.print(" ");
     ToStream.print("Min: ");
-    ToStream.print(UInt64ToString(_minTimeInUSecs));
+    ToStream.print(UInt64ToString(MinInUSecs));
     ToStream.println("us");
 
     for (int i = 0; i < IndentBy; i++) ToStream.print(" ");
     ToStream.print("Samples: ");
-    ToStream.println(UInt64ToString(_totalSamples));
+    ToStream.println(UInt64ToString(Samples));
+}
+
+// Priority inheritance mutex functions
+InstrumentedMutex*  InstrumentedMutex::_first = nullptr;
+TaskHandle_t        InstrumentedMutex::_watchedTask = nullptr;
+
+InstrumentedMutex::InstrumentedMutex(char const *const Name)
+    :   _name(Name),
+        _lock(nullptr),
+        _holdStart(0)
+{
+    memset(&_stats, 0, sizeof(_stats));
+    synchronized
+    {
+        _next = _first;
+        _first = this;
+    }
+}
+
+void InstrumentedMutex::Create()
+{
+    synchronized
+    {
+        if (_lock == nullptr)
+        {
+#if SPA_STATIC_RTOS
+            _lock = xSemaphoreCreateMutexStatic(&_lockBuffer);
+#else
+            _lock = xSemaphoreCreateMutex();
+#endif
+        }
+    }
+    $Assert(_lock != nullptr);
+}
+
+bool InstrumentedMutex::Take()
+{
+    if (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING)
+    {   // scheduler not running yet, no locks - Use with care!
+        return false;
+    }
+    if (_lock == nullptr)
+    {
+        Create();
+    }
+
+    DefaultPerfClockSource::Ticks const waitStart = DefaultPerfClockSource::Now();
+    bool const contended = (xSemaphoreTake(_lock, 0) != pdTRUE);
+    if (contended)
+    {
+        $Assert(xSemaphoreTake(_lock, portMAX_DELAY) == pdTRUE);
+    }
+    DefaultPerfClockSource::Ticks const now = DefaultPerfClockSource::Now();
+
+    // Have the lock - update stats
+    _stats._acquisitions++;
+    if (contended)
+    {
+        uint64_t const wait = (DefaultPerfClockSource::Ticks)(now - waitStart);
+        _stats._contended++;
+        _stats._totalWaitInUSecs += wait;
+        if (wait > _stats._maxWaitInUSecs)
+        {
+            _stats._maxWaitInUSecs = wait;
+        }
+        if ((_watchedTask != nullptr) && (xTaskGetCurrentTaskHandle() == _watchedTask))
+        {
+            _stats._watchedContended++;
+            if (wait > _stats._watchedMaxWaitInUSecs)
+            {
+                _stats._watchedMaxWaitInUSecs = wait;
+            }
+        }
+    }
+    _holdStart = now;
+
+    return true;
+}
+
+void InstrumentedMutex::Give()
+{
+    $Assert(_lock != nullptr);
+
+    uint64_t const hold = (DefaultPerfClockSource::Ticks)(DefaultPerfClockSource::Now() - (DefaultPerfClockSource::Ticks)_holdStart);
+    _stats._totalHoldInUSecs += hold;
+    if (hold > _stats._maxHoldInUSecs)
+    {
+        _stats._maxHoldInUSecs = hold;
+    }
+
+    $Assert(xSemaphoreGive(_lock) == pdTRUE);
+}
+
+void InstrumentedMutex::GetStats(Stats& Result)
+{
+    bool const locked = (_lock != nullptr) && Take();
+    Result = _stats;
+    if (locked)
+    {   // exclude this sample
+        Result._acquisitions--;
+        Give();
+    }
+
+    Result._totalWaitInUSecs = DefaultPerfClockSource::ToUSecs(Result._totalWaitInUSecs);
+    Result._maxWaitInUSecs = DefaultPerfClockSource::ToUSecs(Result._maxWaitInUSecs);
+    Result._totalHoldInUSecs = DefaultPerfClockSource::ToUSecs(Result._totalHoldInUSecs);
+    Result._maxHoldInUSecs = DefaultPerfClockSource::ToUSecs(Result._maxHoldInUSecs);
+    Result._watchedMaxWaitInUSecs = DefaultPerfClockSource::ToUSecs(Result._watchedMaxWaitInUSecs);
+}
+
+void InstrumentedMutex::ResetStats()
+{
+    bool const locked = (_lock != nullptr) && Take();
+    memset(&_stats, 0, sizeof(_stats));
+    if (locked)
+    {
+        Give();
+    }
+}
+
+int InstrumentedMutex::GetCount()
+{
+    int count = 0;
+    for (InstrumentedMutex* mutex = _first; mutex != nullptr; mutex = mutex->_next)
+    {
+        count++;
+    }
+    return count;
+}
+
+void InstrumentedMutex::ResetAllStats()
+{
+    for (InstrumentedMutex* mutex = _first; mutex != nullptr; mutex = mutex->_next)
+    {
+        mutex->ResetStats();
+    }
 }
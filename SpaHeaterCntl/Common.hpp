@@ -7,20 +7,99 @@
 
 #include <Arduino.h>
 #include <Arduino_FreeRTOS.h>
+#if !defined(ARDUINO)
+#include <time.h>
+#endif
+
+//** freeRTOS object allocation - selected at build time (e.g. -DSPA_STATIC_RTOS=1)
+//   0: thread stacks, TCBs and semaphores come from the freeRTOS heap (configTOTAL_HEAP_SIZE)
+//   1: they are laid out at compile time (xTaskCreateStatic() etc.) - the freeRTOS heap is left to the network
+//      stack. Needs configSUPPORT_STATIC_ALLOCATION in the Arduino_FreeRTOS config, which then also provides
+//      the idle/timer task memory.
+#if !defined(SPA_STATIC_RTOS)
+#define SPA_STATIC_RTOS             0
+#endif
+#if SPA_STATIC_RTOS && (configSUPPORT_STATIC_ALLOCATION != 1)
+#error "SPA_STATIC_RTOS=1 requires configSUPPORT_STATIC_ALLOCATION=1 in the Arduino_FreeRTOS FreeRTOSConfig.h"
+#endif
 
 //** Hard Fault primitives 
 extern void FailFast(const char* FileName, int LineNumber);
+extern void FailFastDrainLog();         // Logger - write out queued Serial records before halting
 #define $Assert(c) if (!(c)) FailFast(__FILE__, __LINE__);
 #define $FailFast() FailFast(__FILE__, __LINE__);
 
 
+/**
+ * @brief Priority inheritance mutex with wait and hold time instrumentation.
+ * 
+ * Wraps a FreeRTOS mutex (xSemaphoreCreateMutex) so a lower priority holder is boosted while a higher
+ * priority thread waits on it - a binary semaphore has no priority inheritance. The mutex is created on
+ * first use once the scheduler is running; before that Take() does nothing and returns false so
+ * initialization code can run unlocked (use with care!).
+ * 
+ * Every mutex registers itself in a static list, so all of them can be reported on (see the 'locks'
+ * console command). The watched task (the boiler control thread) has its waits recorded separately so 
+ * its worst case wait is not lost in the totals. Stats are updated while the mutex is held.
+ */
+class InstrumentedMutex
+{
+public:
+    struct Stats
+    {
+        uint64_t    _acquisitions;
+        uint64_t    _contended;             // acquisitions that had to wait
+        uint64_t    _totalWaitInUSecs;
+        uint64_t    _maxWaitInUSecs;
+        uint64_t    _totalHoldInUSecs;
+        uint64_t    _maxHoldInUSecs;
+        uint64_t    _watchedContended;      // as above for the watched task
+        uint64_t    _watchedMaxWaitInUSecs;
+    };
+
+    InstrumentedMutex() = delete;
+    InstrumentedMutex(const InstrumentedMutex&) = delete;
+    InstrumentedMutex &operator=(const InstrumentedMutex &) = delete;
+
+    InstrumentedMutex(char const *const Name);
+
+    bool Take();                            // false if the scheduler is not running yet - lock not taken
+    void Give();
+
+    void GetStats(Stats& Result);
+    void ResetStats();
+    __inline char const* GetName() { return _name; }
+    __inline InstrumentedMutex* GetNext() { return _next; }
+
+    static __inline InstrumentedMutex* GetFirst() { return _first; }
+    static int GetCount();
+    static __inline void SetWatchedTask(TaskHandle_t Task) { _watchedTask = Task; }
+    static void ResetAllStats();
+
+private:
+    void Create();
+
+private:
+    static InstrumentedMutex*   _first;
+    static TaskHandle_t         _watchedTask;
+
+    InstrumentedMutex*          _next;
+    char const *const           _name;
+    SemaphoreHandle_t volatile  _lock;
+#if SPA_STATIC_RTOS
+    StaticSemaphore_t           _lockBuffer;
+#endif
+    uint64_t                    _holdStart;     // clock source ticks
+    Stats                       _stats;         // in clock source ticks - converted by GetStats()
+};
+
 /**
  * @brief Template class for a shared buffer with singleton behavior.
  * 
  * The SharedBuffer class provides a template implementation for a shared buffer with singleton behavior.
  * It allows multiple instances of the buffer to be created, each with a specified size (TSize).
  * The buffer is accessed through a Handle object, which provides a pointer to the buffer.
- * The buffer is protected by a semaphore lock to ensure thread-safe access.
+ * The buffer is protected by a priority inheritance mutex to ensure thread-safe access.
  * 
  * @tparam TSize The size of the buffer.
  */
@@ -29,7 +108,7 @@ class SharedBuffer
 {
 private:
     static uint8_t _buffer[TSize]; // The shared buffer
-    static SemaphoreHandle_t _lock; // Semaphore lock for thread-safe access
+    static InstrumentedMutex _lock; // Priority inheritance lock for thread-safe access
 
 public:
     /**
@@ -92,7 +171,7 @@ template <int TSize>
 uint8_t SharedBuffer<TSize>::_buffer[TSize] = {0};
 
 template <int TSize>
-SemaphoreHandle_t SharedBuffer<TSize>::_lock = NULL;
+InstrumentedMutex SharedBuffer<TSize>::_lock("SharedBuffer");
 
 template <int TSize>
 SharedBuffer<TSize>::SharedBuffer()
@@ -113,12 +192,10 @@ typename SharedBuffer<TSize>::Handle SharedBuffer<TSize>::GetHandle()
 /**
  * @brief Constructor for the Handle class.
  * 
- * The constructor initializes the semaphore lock if it has not been initialized before.
- * It uses a static volatile flag to ensure that the initialization is performed only once.
- * The constructor also takes the semaphore lock to ensure exclusive access to the shared buffer.
+ * The constructor takes the buffer's priority inheritance mutex to ensure exclusive access to the shared buffer.
  * 
  * Handle has two modes of operation: with and without locks depedning on the scheduler state.
- * If the scheduler is running, the constructor takes the semaphore lock. Otherwise, it does not and
+ * If the scheduler is running, the constructor takes the lock. Otherwise, it does not and
  * the implementation is not thread-safe. This is useful for initialization code that runs before
  * the scheduler is started.
  * 
@@ -127,39 +204,13 @@ typename SharedBuffer<TSize>::Handle SharedBuffer<TSize>::GetHandle()
 template <int TSize>
 SharedBuffer<TSize>::Handle::Handle()
 {
-    static volatile bool initialized = false;
-
-    if (!initialized)
-    {
-        if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)
-        {
-            synchronized
-            {
-                if (!initialized)
-                {
-                    SharedBuffer<TSize>::_lock = xSemaphoreCreateBinary();
-                    xSemaphoreGive(SharedBuffer<TSize>::_lock); // give the semaphore so it is available first time
-                    initialized = true;
-                }
-            }
-        }
-        else
-        {   // scheduler not running yet, just return a handle without locks
-            // Use with care!
-            _locked = false;
-            return;
-        }
-    }
-
-    $Assert(SharedBuffer<TSize>::_lock != NULL);
-    $Assert(xSemaphoreTake(SharedBuffer<TSize>::_lock, portMAX_DELAY) == pdTRUE);
-    _locked = true;
+    _locked = SharedBuffer<TSize>::_lock.Take();
 }
 
 /**
  * @brief Destructor for the Handle class.
  * 
- * The destructor releases the semaphore lock to allow other threads to access the shared buffer.
+ * The destructor releases the lock to allow other threads to access the shared buffer.
  * 
  * @tparam TSize The size of the buffer.
  */
@@ -168,12 +219,10 @@ SharedBuffer<TSize>::Handle::~Handle()
 {
     if (_locked)
     {
-        $Assert(SharedBuffer<TSize>::_lock != NULL);
-        $Assert(xSemaphoreGive(SharedBuffer<TSize>::_lock) == pdTRUE);
+        SharedBuffer<TSize>::_lock.Give();
     }
 }
 
-
 //* Common support functions
 
 //* Thread-safe shared buffers
@@ -184,150 +233,229 @@ extern int printf(Stream& ToStream, const char* Format, ...);
 #define $PRIX64 "08X%08X"
 #define To$PRIX64(v) ((uint32_t)(v >> 32)),((uint32_t)v)
 
-//* Variable arguments access support
-//
-// Usage: 
-//
-//      void MyFunc(void* NotVarArg, ...)
-//      {
-//          uint32_t*   args = VarArgsBase(NotVarArg);  // first var arg
-//              -- or --
-//          uint32_t (*args)[0] = VarArgsBase(&NotVarArg);
-//
-constexpr uint32_t (* VarArgsBase(void* BaseMinusOne)) [0]
-{
-    return ((uint32_t (*)[0])(((uint32_t*)BaseMinusOne) + 1));
-}
-
 //* uint64_t to string conversion
 char const *const UInt64ToString(uint64_t Value);
 
 
 //** Time/Timer support
+/**
+ * @brief Wrap-safe 64-bit monotonic time base - used by all timing code (Timer, USecClock, PerfCounter).
+ * 
+ * The FreeRTOS tick count, extended to 64 bits by the kernel's own tick overflow count, refined to uSecs
+ * with the SysTick down counter. The extension is maintained by the tick interrupt so, unlike extending
+ * millis() or micros() in software, there is no minimum rate at which it has to be read. Reads are safe
+ * from any thread. Before the scheduler starts it reads as zero.
+ */
+class MonotonicClock
+{
+public:
+    static uint64_t NowInUSecs();
+    static uint64_t NowInMSecs();
+
+private:
+    static bool ReadTicks(uint64_t& Ticks, uint32_t& SubTickCycles, uint32_t& CyclesPerTick);
+};
+
 class Timer
 {
 public:
     static constexpr uint32_t FOREVER = UINT32_MAX;
 
     __inline Timer() : _alarmTime(0) {}
-    __inline Timer(uint32_t AlarmInMs) { _alarmTime = millis() + AlarmInMs; }
-    __inline void SetAlarm(uint32_t AlarmInMs) { (_alarmTime = (AlarmInMs == FOREVER) ? FOREVER : millis() + AlarmInMs); }
-    __inline bool IsAlarmed() { return ((_alarmTime == FOREVER) ? false : (millis() >= _alarmTime)); }
+    __inline Timer(uint32_t AlarmInMs) { SetAlarm(AlarmInMs); }
+    __inline void SetAlarm(uint32_t AlarmInMs) { _alarmTime = (AlarmInMs == FOREVER) ? _forever : (MonotonicClock::NowInMSecs() + AlarmInMs); }
+    __inline bool IsAlarmed() { return ((_alarmTime == _forever) ? false : (MonotonicClock::NowInMSecs() >= _alarmTime)); }
 private:
-    uint32_t    _alarmTime;         // msecs
+    static constexpr uint64_t _forever = UINT64_MAX;
+    uint64_t    _alarmTime;         // msecs
 };
 
 //** uSec resolution clock and performance counter support
 class USecClock
 {
 public:
-    __inline uint64_t Now()     // in uSecs
+    __inline uint64_t Now()     // in uSecs since the last Reset()
     { 
-        Accumulate();
-        return _accumulated; 
+        return MonotonicClock::NowInUSecs() - _origin;
     }
 
     __inline USecClock()
+        : _origin(0)
     {
-        Reset();
     }
 
     __inline void Reset()
     {
-        _accumulated = 0;
-        _lastAccumulateTimeInMs = millis();
-        _lastAccumulateTimeInUs = micros();
+        _origin = MonotonicClock::NowInUSecs();
     }
 
 private:
-    // must be called at least once every 60 minutes or a FailFast will occur
-    __inline void Accumulate()
+    uint64_t _origin;
+};
+
+extern USecClock uSecSystemClock;
+
+//** PerfCounter clock sources
+//
+// A clock source is a class with static members only:
+//
+//      typedef <unsigned integral> Ticks;              // raw reading, differences are wrap-safe in this type
+//      static void Begin();                            // one time initialization, idempotent
+//      static Ticks Now();                             // as cheap as possible - it is all PerfCounter::Start() does
+//      static uint64_t ToUSecs(uint64_t TickCount);    // only used when the counter is read
+//
+
+/**
+ * @brief Clock source on the wrap-safe 64-bit MonotonicClock. Use for sections that can run longer than the
+ * cycle counter's wrap period.
+ */
+class MonotonicClockSource
+{
+public:
+    typedef uint64_t Ticks;
+    static __inline void Begin() {}
+    static __inline Ticks Now() { return MonotonicClock::NowInUSecs(); }
+    static __inline uint64_t ToUSecs(uint64_t TickCount) { return TickCount; }
+};
+
+#if defined(ARDUINO_UNOR4_WIFI) || defined(ARDUINO_UNOR4_MINIMA)
+/**
+ * @brief Clock source on the Cortex-M4 DWT cycle counter - a single register read per Start()/Stop().
+ * 
+ * The counter is 32 bits at the core clock so a single sample must be shorter than its wrap period 
+ * (~89 seconds at 48MHz). It only counts while the core is running.
+ */
+class CycleCounterClockSource
+{
+public:
+    typedef uint32_t Ticks;
+
+    static __inline void Begin()
     {
-        uint32_t now = micros();
-        uint32_t nowMs = millis();
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
 
-        $Assert(nowMs <= (_lastAccumulateTimeInMs + (60000 * 60)));
-        _lastAccumulateTimeInMs = nowMs;
+    static __inline Ticks Now() { return DWT->CYCCNT; }
+    static __inline uint64_t ToUSecs(uint64_t TickCount) { return TickCount / (SystemCoreClock / 1000000); }
+};
 
-        if (now >= _lastAccumulateTimeInUs)
-        {
-            _accumulated += int64_t(now - _lastAccumulateTimeInUs);
-        }
-        else
-        {
-            _accumulated += uint64_t((1000000 - _lastAccumulateTimeInUs) + now);
-        }
-        _lastAccumulateTimeInUs = now;
+typedef CycleCounterClockSource DefaultPerfClockSource;
+
+#elif !defined(ARDUINO)
+/**
+ * @brief Clock source for host builds (the tests in Tests/) on clock_gettime(CLOCK_MONOTONIC), in nSecs.
+ */
+class HostClockSource
+{
+public:
+    typedef uint64_t Ticks;
+
+    static __inline void Begin() {}
+
+    static __inline Ticks Now()
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return ((uint64_t)now.tv_sec * 1000000000) + now.tv_nsec;
     }
 
-private:
-    uint32_t _lastAccumulateTimeInMs;
-    uint64_t _accumulated;
-    uint32_t _lastAccumulateTimeInUs;
+    static __inline uint64_t ToUSecs(uint64_t TickCount) { return TickCount / 1000; }
 };
 
-extern USecClock uSecSystemClock;
+typedef HostClockSource DefaultPerfClockSource;
 
-class PerfCounter
+#else
+typedef MonotonicClockSource DefaultPerfClockSource;
+#endif
+
+extern void PrintPerfCounter(Stream &ToStream, int IndentBy, uint64_t Samples, uint64_t TotalInUSecs, uint64_t MaxInUSecs, uint64_t MinInUSecs);
+
+/**
+ * @brief Sample count and total/max/min elapsed time of a code section, timed with the TClockSource.
+ * 
+ * Start() and Stop() only read the clock and accumulate raw ticks; the conversion to uSecs is done when 
+ * the counter is read, so instrumenting a short section does not distort its numbers.
+ * 
+ * @tparam TClockSource The clock source (see above).
+ */
+template <typename TClockSource>
+class BasicPerfCounter
 {
 private:
-    USecClock &_clock;
-    uint64_t _lastSampleStartInUSecs;
+    typename TClockSource::Ticks _lastSampleStart;
     uint64_t _totalSamples;
-    uint64_t _totalTimeInUSecs;
-    uint64_t _maxTimeInUSecs;
-    uint64_t _minTimeInUSecs;
+    uint64_t _totalTicks;
+    uint64_t _maxTicks;
+    uint64_t _minTicks;
+    uint64_t _recentMaxTicks;
 
 public:
-    PerfCounter() = delete;
-    __inline PerfCounter(USecClock &ClockToUse)
-        : _clock(ClockToUse)
+    __inline BasicPerfCounter()
     {
+        TClockSource::Begin();
         Reset();
     }
 
     __inline void Reset()
     {
         _totalSamples = 0;
-        _totalTimeInUSecs = 0;
-        _maxTimeInUSecs = 0;
-        _minTimeInUSecs = UINT64_MAX;
+        _totalTicks = 0;
+        _maxTicks = 0;
+        _minTicks = UINT64_MAX;
+        _recentMaxTicks = 0;
     }
 
     __inline void Start()
     {
-        _lastSampleStartInUSecs = _clock.Now();
+        _lastSampleStart = TClockSource::Now();
     }
 
     __inline void Stop()
     {
-        uint64_t now = _clock.Now();
-        uint64_t elapsed = now - _lastSampleStartInUSecs;
+        typename TClockSource::Ticks const elapsed = TClockSource::Now() - _lastSampleStart;
         _totalSamples++;
-        _totalTimeInUSecs += elapsed;
-        if (elapsed > _maxTimeInUSecs)
+        _totalTicks += elapsed;
+        if (elapsed > _maxTicks)
         {
-            _maxTimeInUSecs = elapsed;
+            _maxTicks = elapsed;
         }
-        if (elapsed < _minTimeInUSecs)
+        if (elapsed < _minTicks)
         {
-            _minTimeInUSecs = elapsed;
+            _minTicks = elapsed;
+        }
+        if (elapsed > _recentMaxTicks)
+        {
+            _recentMaxTicks = elapsed;
         }
     }
 
     __inline uint64_t TotalSamples() { return _totalSamples; }
-    __inline uint64_t TotalTimeInUSecs() { return _totalTimeInUSecs; }
-    __inline uint64_t MaxTimeInUSecs() { return _maxTimeInUSecs; }
-    __inline uint64_t MinTimeInUSecs() { return _minTimeInUSecs; }
+    __inline uint64_t TotalTimeInUSecs() { return TClockSource::ToUSecs(_totalTicks); }
+    __inline uint64_t MaxTimeInUSecs() { return TClockSource::ToUSecs(_maxTicks); }
+    __inline uint64_t MinTimeInUSecs() { return (_minTicks == UINT64_MAX) ? UINT64_MAX : TClockSource::ToUSecs(_minTicks); }
 
-    void Print(Stream &ToStream, int IndentBy = 0);
+    // Max since the previous call - for periodic views (e.g. 'top'); a single reader is assumed
+    __inline uint64_t TakeRecentMaxTimeInUSecs()
+    {
+        uint64_t const recentMax = _recentMaxTicks;
+        _recentMaxTicks = 0;
+        return TClockSource::ToUSecs(recentMax);
+    }
+
+    __inline void Print(Stream &ToStream, int IndentBy = 0)
+    {
+        PrintPerfCounter(ToStream, IndentBy, TotalSamples(), TotalTimeInUSecs(), MaxTimeInUSecs(), MinTimeInUSecs());
+    }
 };
 
+typedef BasicPerfCounter<DefaultPerfClockSource> PerfCounter;
+
 //** Generalized Arduino processing task class
 class ArduinoTask
 {
 public:
-    __inline ArduinoTask() : _taskPerfCounter(uSecSystemClock) {}
+    __inline ArduinoTask() {}
     __inline void Setup()    { _taskPerfCounter.Reset(); setup(); }
     __inline void Loop()     { _taskPerfCounter.Start(); loop(); _taskPerfCounter.Stop(); } 
     __inline PerfCounter& GetPerfCounter() { return _taskPerfCounter; }
@@ -9,12 +9,14 @@ ConsoleTask     consoleTask(Serial);
 
 
 ConsoleTask::ConsoleTask(Stream &StreamToUse)
-    :   _stream(&StreamToUse)
+    :   _stream(&StreamToUse),
+        _liveView(nullptr)
 {  
 }
 
 ConsoleTask::ConsoleTask() 
-    :   _stream(nullptr)
+    :   _stream(nullptr),
+        _liveView(nullptr)
 { 
 }
 
@@ -25,6 +27,7 @@ ConsoleTask::~ConsoleTask()
 void ConsoleTask::SetStream(Stream &StreamToUse) 
 {
     _stream = &StreamToUse;
+    _liveView = nullptr;
 }
 
 void ConsoleTask::Push(CmdLine::ProcessorDesc &Descs, int NbrOfDescs, char const *ContextStr)
@@ -59,7 +62,7 @@ void ConsoleTask::Pop()
 
 void ConsoleTask::setup()
 {   
-    logger.Printf(Logger::RecType::Info, "ConsoleTask is Active");
+    $Log(Console, Info, "ConsoleTask is Active");
 }
 
 void ConsoleTask::begin(CmdLine::ProcessorDesc *Descs, int NbrOfDescs, char const *ContextStr)
@@ -67,7 +70,32 @@ void ConsoleTask::begin(CmdLine::ProcessorDesc *Descs, int NbrOfDescs, char cons
     Push(*Descs, NbrOfDescs, ContextStr);
 }
 
+void ConsoleTask::StartLiveView(LiveView View, uint32_t RefreshInMs)
+{
+    _liveView = View;
+    _liveViewFirstTime = true;
+    _liveViewRefreshInMs = RefreshInMs;
+    _liveViewTimer.SetAlarm(0);
+}
+
 void ConsoleTask::loop() 
 {
+    if (_liveView != nullptr)
+    {
+        if (_stream->available() > 0)
+        {   // any key ends the view and returns to the command line
+            while (_stream->available() > 0) _stream->read();
+            _liveView = nullptr;
+            _stream->print("\r\n");
+        }
+        else if (_liveViewTimer.IsAlarmed())
+        {
+            _liveViewTimer.SetAlarm(_liveViewRefreshInMs);
+            _liveView(*_stream, _liveViewFirstTime);
+            _liveViewFirstTime = false;
+        }
+        return;
+    }
+
     _cmdLine.IsReady();
 }
@@ -22,6 +22,10 @@ public:
     void Push(CmdLine::ProcessorDesc &Descs, int NbrOfDescs, char const *ContextStr = "");
     void Pop();
 
+    // Live (refresh in place) views - the view is called every RefreshInMs until a key is pressed
+    typedef void (*LiveView)(Stream &ToStream, bool FirstTime);
+    void StartLiveView(LiveView View, uint32_t RefreshInMs);
+
     void StartBoilerConfig();
     void EndBoilerConfig();
     void StartBoilerControl();
@@ -44,6 +48,11 @@ private:
     };
 
     Stack<ProcessorDesc, 4> _cmdLineStack; // maximum of 4 stacked command processors
+
+    LiveView    _liveView;
+    bool        _liveViewFirstTime;
+    uint32_t    _liveViewRefreshInMs;
+    Timer       _liveViewTimer;
 };
 
 //** Cross module references
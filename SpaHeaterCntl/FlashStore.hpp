@@ -24,11 +24,21 @@ constexpr uint16_t PS_BoilerConfigBase = PS_MQTTBrokerConfigBase + PS_MQTTBroker
 constexpr uint16_t PS_BoilerConfigBlkSize = 64;
 constexpr uint16_t PS_NetworkConfigBase = PS_BoilerConfigBase + PS_BoilerConfigBlkSize;
 constexpr uint16_t PS_NetworkConfigBlkSize = 64;
+constexpr uint16_t PS_LoggerConfigBase = PS_NetworkConfigBase + PS_NetworkConfigBlkSize;
+constexpr uint16_t PS_LoggerConfigBlkSize = 16;
 
-constexpr uint16_t PS_TotalConfigSize = PS_NetworkConfigBase + PS_NetworkConfigBlkSize;
+constexpr uint16_t PS_TotalConfigSize = PS_LoggerConfigBase + PS_LoggerConfigBlkSize;
 
-constexpr uint16_t PS_TotalDiagStoreSize = (8 * 1024) - PS_TotalConfigSize;
-constexpr uint16_t PS_DiagStoreBase = PS_TotalDiagStoreSize;
+//* Bytes at the end of the diag region set aside for MQTT store and forward spill - 0: RAM queue only
+#if !defined(SPA_MQTT_SPILL_SIZE)
+#define SPA_MQTT_SPILL_SIZE         0
+#endif
+
+constexpr uint16_t PS_DiagStoreBase = PS_TotalConfigSize;
+constexpr uint16_t PS_TotalDiagStoreSize = (8 * 1024) - PS_TotalConfigSize - SPA_MQTT_SPILL_SIZE;
+constexpr uint16_t PS_MqttSpillBase = PS_DiagStoreBase + PS_TotalDiagStoreSize;
+constexpr uint16_t PS_MqttSpillSize = SPA_MQTT_SPILL_SIZE;
+    static_assert(PS_TotalDiagStoreSize >= 1024, "MQTT spill leaves too little of the diag region for the logger");
 
 
 // The first bytes of the EEPROM are used to store the configuration for this device
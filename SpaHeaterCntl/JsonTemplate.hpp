@@ -0,0 +1,234 @@
+// SPA Heater Controller for Maxie HA system 2024 (c)TinyBus
+// Compiled (constexpr) JSON template support
+
+#pragma once
+#include "common.hpp"
+#include <type_traits>
+
+//** JSON templates are compiled into segment tables at compile time. A template is plain text in which
+//   %0..%9 are argument slots, %% is a literal '%' and ' stands for " (so templates stay readable C strings).
+//   Compilation resolves the ' and %% escapes and splits the text into literal runs, each followed by an
+//   optional argument slot. Expansion is then one bulk write() per run and per argument, and the expanded
+//   size is computed in closed form: literal length + sum(uses of argument N * strlen(argument N)).
+//   The number of arguments a template uses is part of its compiled type, so passing too few is a compile
+//   error - directly, and through a JsonTemplate<N> view (stored in tables), which only accepts templates
+//   that use at most N arguments and is always expanded with exactly N.
+//
+// Usage:
+//
+//      static constexpr char TopicTemplate[] = "TinyBus/%0/avail";
+//      static constexpr auto topicJson = $CompileJsonTemplate(TopicTemplate);
+//      ...
+//      size_t size = topicJson.Size(deviceName);
+//      topicJson.Expand(printer, deviceName);
+//
+//      JsonTemplate<2> const view(topicJson);      // %0 and %1 are passed, %1 is unused
+//      view.Expand(printer, deviceName, "");
+//
+
+//* One literal run (stored consecutively in the compiled text) followed by an argument slot
+struct JsonSegment
+{
+    uint16_t    _textLength;
+    int8_t      _arg;               // -1: none (last segment)
+};
+
+static constexpr int JsonTemplateMaxArgs = 10;
+
+template <int TArgCount> class JsonTemplate;
+
+//* Storage for a compiled template - TTextSize, TSegmentCount and TArgCount are derived from the template text
+template <size_t TTextSize, size_t TSegmentCount, int TArgCount>
+struct CompiledJsonTemplate
+{
+    static constexpr int ArgCount = TArgCount;     // highest argument slot + 1
+
+    char        _text[TTextSize];
+    JsonSegment _segments[TSegmentCount];
+    uint16_t    _literalLength;
+    uint8_t     _argUses[JsonTemplateMaxArgs];
+
+    template <typename... TArgs>
+    __inline size_t Size(TArgs... Args) const { return JsonTemplate<sizeof...(TArgs)>(*this).Size(Args...); }
+
+    template <typename... TArgs>
+    __inline size_t Expand(Print& To, TArgs... Args) const { return JsonTemplate<sizeof...(TArgs)>(*this).Expand(To, Args...); }
+};
+
+//* Not constexpr - reaching it while compiling a template makes the compile fail
+void InvalidJsonTemplateSpecifier();
+
+template <size_t TTextSize>
+constexpr int JsonTemplateArgCount(char const (&Template)[TTextSize])
+{
+    int count = 0;
+    for (size_t ix = 0; (ix < TTextSize) && (Template[ix] != 0); ix++)
+    {
+        if (Template[ix] == '%')
+        {
+            ix++;
+            if ((Template[ix] >= '0') && (Template[ix] <= '9') && ((Template[ix] - '0') >= count))
+            {
+                count = Template[ix] - '0' + 1;
+            }
+        }
+    }
+    return count;
+}
+
+template <size_t TTextSize>
+constexpr size_t JsonTemplateSegmentCount(char const (&Template)[TTextSize])
+{
+    size_t count = 1;
+    for (size_t ix = 0; (ix < TTextSize) && (Template[ix] != 0); ix++)
+    {
+        if (Template[ix] == '%')
+        {
+            ix++;
+            if (Template[ix] != '%')
+            {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+template <size_t TSegmentCount, int TArgCount, size_t TTextSize>
+constexpr CompiledJsonTemplate<TTextSize, TSegmentCount, TArgCount> CompileJsonTemplate(char const (&Template)[TTextSize])
+{
+    CompiledJsonTemplate<TTextSize, TSegmentCount, TArgCount> result{};
+    size_t textIx = 0;
+    size_t segmentIx = 0;
+    uint16_t run = 0;
+
+    for (size_t ix = 0; (ix < TTextSize) && (Template[ix] != 0); ix++)
+    {
+        char c = Template[ix];
+        if (c == '%')
+        {
+            c = Template[++ix];
+            if (c == '%')
+            {
+                result._text[textIx++] = '%';
+                run++;
+            }
+            else if ((c >= '0') && (c <= '9'))
+            {
+                int8_t const arg = c - '0';
+                result._segments[segmentIx++] = JsonSegment{run, arg};
+                result._argUses[arg]++;
+                run = 0;
+            }
+            else
+            {
+                InvalidJsonTemplateSpecifier();
+            }
+        }
+        else
+        {
+            result._text[textIx++] = (c == '\'') ? '"' : c;
+            run++;
+        }
+    }
+
+    result._segments[segmentIx] = JsonSegment{run, -1};
+    result._literalLength = textIx;
+    return result;
+}
+
+#define $CompileJsonTemplate(Template) CompileJsonTemplate<JsonTemplateSegmentCount(Template), JsonTemplateArgCount(Template)>(Template)
+
+
+//* Size independent part of a view of a compiled template
+class JsonTemplateBase
+{
+protected:
+    char const*         _text;
+    JsonSegment const*  _segments;
+    uint8_t const*      _argUses;
+    uint16_t            _literalLength;
+    uint8_t             _argCount;
+
+    constexpr JsonTemplateBase(char const* Text, JsonSegment const* Segments, uint8_t const* ArgUses, uint16_t LiteralLength, uint8_t ArgCount)
+        :   _text(Text),
+            _segments(Segments),
+            _argUses(ArgUses),
+            _literalLength(LiteralLength),
+            _argCount(ArgCount)
+    {}
+
+    template <typename... TArgs>
+    struct AreCStrings : std::true_type {};
+
+    template <typename TArg, typename... TArgs>
+    struct AreCStrings<TArg, TArgs...>
+        : std::integral_constant<bool, std::is_convertible<TArg, char const*>::value && AreCStrings<TArgs...>::value> {};
+
+    //* Closed form expanded size (excluding any terminating null) - Args holds at least _argCount arguments
+    size_t SizeOf(char const* const* Args) const
+    {
+        size_t size = _literalLength;
+        for (int ix = 0; ix < _argCount; ix++)
+        {
+            if (_argUses[ix] != 0)
+            {
+                size += _argUses[ix] * strlen(Args[ix]);
+            }
+        }
+        return size;
+    }
+
+    //* Expand into To - returns the number of bytes written
+    size_t ExpandInto(Print& To, char const* const* Args) const
+    {
+        size_t result = 0;
+        char const* text = _text;
+        for (JsonSegment const* segment = _segments; ; segment++)
+        {
+            if (segment->_textLength != 0)
+            {
+                result += To.write((uint8_t const*)text, segment->_textLength);
+                text += segment->_textLength;
+            }
+            if (segment->_arg < 0)
+            {
+                break;
+            }
+            char const* const arg = Args[segment->_arg];
+            result += To.write((uint8_t const*)arg, strlen(arg));
+        }
+        return result;
+    }
+};
+
+//* View of any compiled template that uses at most TArgCount arguments; it is expanded with exactly TArgCount
+template <int TArgCount>
+class JsonTemplate : public JsonTemplateBase
+{
+public:
+    template <size_t TTextSize, size_t TSegmentCount, int TCompiledArgCount>
+    constexpr JsonTemplate(CompiledJsonTemplate<TTextSize, TSegmentCount, TCompiledArgCount> const& Compiled)
+        :   JsonTemplateBase(Compiled._text, Compiled._segments, Compiled._argUses, Compiled._literalLength, TCompiledArgCount)
+    {
+        static_assert(TCompiledArgCount <= TArgCount, "JSON template uses more arguments than are passed to it");
+    }
+
+    template <typename... TArgs>
+    __inline size_t Size(TArgs... Args) const
+    {
+        static_assert(AreCStrings<TArgs...>::value, "JSON template arguments must be C strings");
+        static_assert(sizeof...(TArgs) == TArgCount, "JSON template expanded with the wrong number of arguments");
+        char const* const args[] = {Args...};
+        return SizeOf(args);
+    }
+
+    template <typename... TArgs>
+    __inline size_t Expand(Print& To, TArgs... Args) const
+    {
+        static_assert(AreCStrings<TArgs...>::value, "JSON template arguments must be C strings");
+        static_assert(sizeof...(TArgs) == TArgCount, "JSON template expanded with the wrong number of arguments");
+        char const* const args[] = {Args...};
+        return ExpandInto(To, args);
+    }
+};
@@ -4,15 +4,33 @@
 #include "SpaHeaterCntl.hpp"
 
 
+//* Sink queues
+static uint8_t  serialSinkQueue[1024];
+static uint8_t  telnetSinkQueue[512];
+static uint8_t  mqttSinkQueue[512];
+static uint8_t  flashSinkQueue[256];
+
 Logger          logger(Serial);
+FlashStore<LoggerConfig, PS_LoggerConfigBase> loggerConfig;
+    static_assert(PS_LoggerConfigBlkSize >= sizeof(FlashStore<LoggerConfig, PS_LoggerConfigBase>));
+
+constexpr Logger::Budget Logger::_budgets[];
+
+// Room left in front of the record body for its header - see FormatHeader()
+static constexpr int    maxHeaderLength = 56;
 
 
 Logger::Logger(Stream &ToStream)
-    : _out(ToStream),
+    : _serialSink(&ToStream, serialSinkQueue, sizeof(serialSinkQueue), RecType::Info, 64),
+      _telnetSink(nullptr, telnetSinkQueue, sizeof(telnetSinkQueue), RecType::Progress, 64),
+      _mqttSink(mqttSinkQueue, sizeof(mqttSinkQueue), RecType::Warning),
+      _flashSink(flashSinkQueue, sizeof(flashSinkQueue), RecType::Warning),
       _logSeq(0),
       _instanceSeq(0xFFFFFFFF),
-      _highFilterType(Logger::RecType::Info)
+      _sites(nullptr),
+      _totalSuppressed(0)
 {
+    memset(&_moduleLevels[0], (uint8_t)RecType::Info, sizeof(_moduleLevels));
 }
 
 Logger::~Logger()
@@ -20,10 +38,88 @@ Logger::~Logger()
     $FailFast();
 }
 
-void Logger::SetFilter(Logger::RecType HighFilterType)
+void Logger::SetLevel(Logger::Module Module, uint8_t Level)
+{
+    $Assert(Module < Module::Count);
+    _moduleLevels[(uint8_t)Module] = Level;
+}
+
+// Apply the persisted module levels - defaults (Info) are kept if there is no valid config
+void Logger::SetLevelsFromConfig()
+{
+    loggerConfig.Begin();
+    if (!loggerConfig.IsValid())
+    {
+        return;
+    }
+
+    for (int ix = 0; ix < (int)Module::Count; ix++)
+    {
+        uint8_t const level = loggerConfig.GetRecord()._moduleLevels[ix];
+        if ((level >= (uint8_t)RecType::Info) && (level <= LevelOff))
+        {
+            _moduleLevels[ix] = level;
+        }
+    }
+
+    for (int ix = 0; ix < (int)SinkId::Count; ix++)
+    {
+        uint8_t const level = loggerConfig.GetRecord()._sinkLevels[ix];
+        if ((level >= (uint8_t)RecType::Info) && (level <= LevelOff))
+        {
+            GetSink((SinkId)ix).SetLevel(level);
+        }
+    }
+}
+
+// Persist the complete set of module and sink levels
+static void SaveLevelsToConfig()
+{
+    for (int ix = 0; ix < (int)Logger::Module::Count; ix++)
+    {
+        loggerConfig.GetRecord()._moduleLevels[ix] = logger.GetLevel((Logger::Module)ix);
+    }
+    for (int ix = 0; ix < (int)Logger::SinkId::Count; ix++)
+    {
+        loggerConfig.GetRecord()._sinkLevels[ix] = logger.GetSink((Logger::SinkId)ix).GetLevel();
+    }
+    loggerConfig.Write();
+}
+
+Logger::Sink& Logger::GetSink(Logger::SinkId Sink)
+{
+    switch (Sink)
+    {
+        case SinkId::Serial:
+            return _serialSink;
+        case SinkId::Telnet:
+            return _telnetSink;
+        case SinkId::MQTT:
+            return _mqttSink;
+        case SinkId::Flash:
+            return _flashSink;
+        default:
+            $FailFast();
+    }
+}
+
+const char* Logger::LevelToString(uint8_t Level)
+{
+    return (Level == LevelOff) ? "OFF" : ToString((RecType)Level);
+}
+
+bool Logger::LevelFromString(const char* From, uint8_t& Level)
 {
-    _highFilterType = HighFilterType;
-}   
+    for (uint8_t level = (uint8_t)RecType::Info; level <= LevelOff; level++)
+    {
+        if (strcasecmp(From, LevelToString(level)) == 0)
+        {
+            Level = level;
+            return true;
+        }
+    }
+    return false;
+}
 
 const char* Logger::ToString(Logger::RecType From)
 {
@@ -61,19 +157,88 @@ const char* Logger::ToString(Logger::RecType From)
 void Logger::Begin(uint32_t InstanceSeq)
 {
     _instanceSeq = InstanceSeq;
+    _flashSink.Begin();
+
     RTCTime currentTime;
     $Assert(RTC.getTime(currentTime));
 
     Printf(RecType::Start, "%s", currentTime.toString().c_str());
 }
 
+// Formats the record header into To - returns its length. The stamp is monotonic uSecs since boot as
+// <secs>.<usecs>; NtpRef records map it to UTC.
+int Logger::FormatHeader(char* To, int Size, Logger::RecType Type)
+{
+    uint64_t const nowInUSecs = timeService.MonotonicNow();
+    int const length = snprintf(To, Size, "%s:%u:%u:%u.%06u:", ToString(Type), _instanceSeq, _logSeq,
+                                (uint32_t)(nowInUSecs / 1000000), (uint32_t)(nowInUSecs % 1000000));
+    _logSeq++;
+    $Assert((length > 0) && (length < Size));
+    return length;
+}
+
+/**
+ * @brief Terminates a formatted record and queues it to each sink that accepts its type.
+ * 
+ * Record is Length bytes (clipped to fit) in a buffer of Size bytes. Sinks that are full drop the
+ * record - this never waits on a sink's consumer.
+ */
+void Logger::Emit(Logger::RecType Type, char* Record, int Length, int Size)
+{
+    if (Length > (Size - 3))
+    {
+        Length = Size - 3;
+    }
+    Record[Length++] = '\r';
+    Record[Length++] = '\n';
+    Record[Length] = 0;
+
+    for (int ix = 0; ix < (int)SinkId::Count; ix++)
+    {
+        Sink& sink = GetSink((SinkId)ix);
+        if (sink.Accepts(Type))
+        {
+            sink.Enqueue(Record, Length);
+        }
+    }
+}
+
+// Note: records are filtered by the $Log() macros before this is called
 int Logger::Printf(Logger::RecType Type, const char *Format, ...)
 {
-    if (Type < _highFilterType)
+    int size;
+    va_list args;
+
+    va_start(args, Format);
+
     {
-        return 0;
+        auto handle = sharedPrintfBuffer.GetHandle();
+        char* buffer = (char *)handle.GetBuffer();
+
+        size = vsnprintf(&buffer[maxHeaderLength], handle.GetSize() - maxHeaderLength, Format, args);
+
+        // The header is formatted last and placed just in front of the body
+        char header[maxHeaderLength];
+        int const headerLength = FormatHeader(header, sizeof(header), Type);
+        char* record = &buffer[maxHeaderLength - headerLength];
+        memcpy(record, header, headerLength);
+
+        Emit(Type, record, headerLength + ((size > 0) ? size : 0), handle.GetSize() - (maxHeaderLength - headerLength));
     }
 
+    va_end(args);
+
+    return size;
+}
+
+/**
+ * @brief Printf for a rate limited call site ($LogLimited) - the site has already been admitted by its budget.
+ * 
+ * A record identical to the last one emitted by the site within _dedupWindowInMS is suppressed. Otherwise
+ * the record is emitted along with the count of the site's records suppressed since its last emitted one.
+ */
+int Logger::Printf(Logger::CallSite& Site, Logger::RecType Type, const char *Format, ...)
+{
     int size;
     va_list args;
 
@@ -82,21 +247,552 @@ int Logger::Printf(Logger::RecType Type, const char *Format, ...)
     {
         auto handle = sharedPrintfBuffer.GetHandle();
         char* buffer = (char *)handle.GetBuffer();
+        char* body = &buffer[maxHeaderLength];
+        int const bodySize = handle.GetSize() - maxHeaderLength;
+
+        size = vsnprintf(body, bodySize, Format, args);
+
+        // FNV-1a hash of the formatted record for the dedup check
+        uint32_t hash = 2166136261;
+        for (const char* c = body; *c != 0; c++)
+        {
+            hash = (hash ^ (uint8_t)*c) * 16777619;
+        }
+
+        uint32_t const nowInMS = millis();
+        uint32_t suppressedCount;
+        bool isDuplicate;
+
+        synchronized
+        {
+            isDuplicate = (hash == Site._lastHash) && (Type == Site._lastType) && ((nowInMS - Site._lastEmitTimeInMS) < _dedupWindowInMS);
+            if (isDuplicate)
+            {
+                Site._suppressedCount++;
+            }
+            else
+            {
+                suppressedCount = Site._suppressedCount;
+                _totalSuppressed += suppressedCount;
+                Site._suppressedCount = 0;
+                Site._lastHash = hash;
+                Site._lastType = Type;
+                Site._lastEmitTimeInMS = nowInMS;
+            }
+        }
+
+        if (!isDuplicate)
+        {
+            int length = strlen(body);
+            if (suppressedCount > 0)
+            {
+                length += snprintf(&body[length], bodySize - length, " [suppressed %u times]", suppressedCount);
+            }
+
+            char header[maxHeaderLength];
+            int const headerLength = FormatHeader(header, sizeof(header), Type);
+            char* record = body - headerLength;
+            memcpy(record, header, headerLength);
 
-        size = vsnprintf(buffer, handle.GetSize(), Format, args);
-        _out.print(ToString(Type));
-        _out.print(":");
-        _out.print(_instanceSeq);
-        _out.print(":");
-        _out.print(_logSeq);
-        _out.print(":");
-        _out.print(millis());
-        _out.print(":");
-        _out.println(buffer);
-        _logSeq++;
+            Emit(Type, record, headerLength + length, bodySize + headerLength);
+        }
     }
 
     va_end(args);
 
     return size;
 }
+
+void Logger::CallSite::Register(const char* Format, Budget const& Budget, uint32_t NowInMS)
+{
+    // Caller is synchronized
+    _format = Format;
+    _tokens = Budget._burst;
+    _lastRefillTimeInMS = NowInMS;
+    _lastEmitTimeInMS = NowInMS;
+    _next = logger._sites;
+    logger._sites = this;
+}
+
+/**
+ * @brief Emits a "suppressed N times" summary for each site with suppressed records that has been quiet
+ * for _dedupWindowInMS - otherwise a burst that ends in suppression would never be reported.
+ * Called periodically from the main loop.
+ */
+void Logger::Flush()
+{
+    static Timer flushTimer(_dedupWindowInMS);
+    if (!flushTimer.IsAlarmed())
+    {
+        return;
+    }
+    flushTimer.SetAlarm(_dedupWindowInMS);
+
+    CallSite* site;
+    synchronized
+    {
+        site = _sites;
+    }
+
+    for (; site != nullptr; site = site->_next)             // sites are only ever added at the head
+    {
+        uint32_t const nowInMS = millis();
+        uint32_t suppressedCount = 0;
+        RecType type;
+
+        synchronized
+        {
+            if ((site->_suppressedCount > 0) && ((nowInMS - site->_lastEmitTimeInMS) >= _dedupWindowInMS))
+            {
+                suppressedCount = site->_suppressedCount;
+                _totalSuppressed += suppressedCount;
+                site->_suppressedCount = 0;
+                site->_lastHash = 0;
+                site->_lastEmitTimeInMS = nowInMS;
+                type = (site->_lastType == (RecType)0) ? RecType::Info : site->_lastType;
+            }
+        }
+
+        if (suppressedCount > 0)
+        {
+            auto handle = sharedPrintfBuffer.GetHandle();
+            char* buffer = (char *)handle.GetBuffer();
+
+            int length = FormatHeader(buffer, handle.GetSize(), type);
+            length += snprintf(&buffer[length], handle.GetSize() - length, "Logger: suppressed %u times: %s", suppressedCount, site->_format);
+            Emit(type, buffer, length, handle.GetSize());
+        }
+    }
+}
+
+uint32_t Logger::GetTotalSuppressed()
+{
+    synchronized
+    {
+        return _totalSuppressed;
+    }
+}
+
+/**
+ * @brief Moves queued records to the Serial, Telnet and Flash sinks - a bounded amount of work per sink per
+ * call. Called from the main loop; the MQTT sink is drained by the MQTT client when it is connected.
+ */
+void Logger::Drain()
+{
+    _serialSink.Drain();
+    _telnetSink.Drain();
+    _flashSink.Drain();
+}
+
+
+//* Called by FailFast() - so the Critical record logged just before a $FailFast() is seen
+void FailFastDrainLog()
+{
+    logger.DrainSerialForFailFast();
+}
+
+
+//** Logger::Sink implementation
+Logger::Sink::Sink(uint8_t* Queue, uint16_t QueueSize, RecType Level)
+    : _queue(Queue),
+      _queueSize(QueueSize),
+      _head(0),
+      _used(0),
+      _headOffset(0),
+      _highWater(0),
+      _records(0),
+      _dropped(0),
+      _level((uint8_t)Level),
+      _enabled(true)
+{
+}
+
+// Queue a complete record - false if it was dropped for lack of room. Callable from any thread.
+bool Logger::Sink::Enqueue(const char* Record, uint16_t Length)
+{
+    uint16_t const needed = Length + sizeof(uint16_t);
+
+    synchronized
+    {
+        if (needed > (_queueSize - _used))
+        {
+            _dropped++;
+            return false;
+        }
+
+        uint16_t ix = _head + _used;
+        At(ix++) = (uint8_t)Length;
+        At(ix++) = (uint8_t)(Length >> 8);
+
+        uint16_t const start = (ix < _queueSize) ? ix : (ix - _queueSize);
+        uint16_t const firstPart = ((_queueSize - start) < Length) ? (_queueSize - start) : Length;
+        memcpy(&_queue[start], Record, firstPart);
+        memcpy(&_queue[0], Record + firstPart, Length - firstPart);
+
+        _used += needed;
+        _records++;
+        if (_used > _highWater)
+        {
+            _highWater = _used;
+        }
+    }
+
+    return true;
+}
+
+uint16_t Logger::Sink::PeekRecordLength()
+{
+    // Only the draining thread moves _head; producers only ever grow _used
+    if (_used == 0)
+    {
+        return 0;
+    }
+    return At(_head) | (At(_head + 1) << 8);
+}
+
+uint16_t Logger::Sink::Peek(const uint8_t*& Bytes)
+{
+    uint16_t const length = PeekRecordLength();
+    if (length == 0)
+    {
+        return 0;
+    }
+
+    uint16_t start = _head + sizeof(uint16_t) + _headOffset;
+    start = (start < _queueSize) ? start : (start - _queueSize);
+    uint16_t const remaining = length - _headOffset;
+
+    Bytes = &_queue[start];
+    return ((_queueSize - start) < remaining) ? (_queueSize - start) : remaining;
+}
+
+void Logger::Sink::Consume(uint16_t Length)
+{
+    uint16_t const length = PeekRecordLength();
+    _headOffset += Length;
+    $Assert(_headOffset <= length);
+
+    if (_headOffset == length)
+    {
+        uint16_t const recordSize = length + sizeof(uint16_t);
+        synchronized
+        {
+            _head = ((_head + recordSize) < _queueSize) ? (_head + recordSize) : (_head + recordSize - _queueSize);
+            _used -= recordSize;
+        }
+        _headOffset = 0;
+    }
+}
+
+void Logger::Sink::GetStats(Stats& Stats)
+{
+    synchronized
+    {
+        Stats._records = _records;
+        Stats._dropped = _dropped;
+        Stats._queued = _used;
+        Stats._highWater = _highWater;
+        Stats._queueSize = _queueSize;
+    }
+}
+
+
+//** Logger::StreamSink implementation
+Logger::StreamSink::StreamSink(Print* To, uint8_t* Queue, uint16_t QueueSize, RecType Level, uint16_t MaxBytesPerDrain)
+    : Sink(Queue, QueueSize, Level),
+      _out(To),
+      _maxBytesPerDrain(MaxBytesPerDrain)
+{
+    SetEnabled(To != nullptr);
+}
+
+void Logger::StreamSink::SetStream(Print* To)
+{
+    SetEnabled(To != nullptr);
+    _out = To;
+
+    if (To == nullptr)
+    {
+        // Discard what was queued for the old stream
+        const uint8_t* bytes;
+        uint16_t length;
+        while ((length = Peek(bytes)) > 0)
+        {
+            Consume(length);
+        }
+    }
+}
+
+void Logger::StreamSink::Drain()
+{
+    if (_out == nullptr)
+    {
+        return;
+    }
+
+    int budget = _maxBytesPerDrain;
+    int const room = _out->availableForWrite();
+    if ((room > 0) && (room < budget))
+    {
+        budget = room;
+    }
+
+    while (budget > 0)
+    {
+        const uint8_t* bytes;
+        int length = Peek(bytes);
+        if (length == 0)
+        {
+            break;
+        }
+        length = (length < budget) ? length : budget;
+
+        int const written = _out->write(bytes, length);
+        Consume(written);
+        budget -= length;
+
+        if (written < length)
+        {
+            break;      // Stream is backed up - try again next pass
+        }
+    }
+}
+
+// Write out everything queued, ignoring the per pass budget - the system is halting, so the usual single
+// draining thread rule no longer matters
+void Logger::StreamSink::DrainAll()
+{
+    if (_out == nullptr)
+    {
+        return;
+    }
+
+    const uint8_t* bytes;
+    uint16_t length;
+    while ((length = Peek(bytes)) > 0)
+    {
+        size_t const written = _out->write(bytes, length);
+        if (written == 0)
+        {
+            break;
+        }
+        Consume(written);
+    }
+    _out->flush();
+}
+
+
+//** Logger::FlashSink implementation
+Logger::FlashSink::FlashSink(uint8_t* Queue, uint16_t QueueSize, RecType Level)
+    : Sink(Queue, QueueSize, Level),
+      _writeIx(0)
+{
+    SetEnabled(false);          // until Begin() has found the end of the store
+}
+
+void Logger::FlashSink::Begin()
+{
+    _writeIx = 0;
+    for (uint16_t ix = 0; ix < PS_TotalDiagStoreSize; ix++)
+    {
+        if (EEPROM.read(PS_DiagStoreBase + ix) == 0)
+        {
+            _writeIx = ix;
+            SetEnabled(true);
+            return;
+        }
+    }
+
+    // Never used (or no end marker) - start at the beginning
+    EEPROM.update(PS_DiagStoreBase, 0);
+    SetEnabled(true);
+}
+
+void Logger::FlashSink::Drain()
+{
+    int budget = _maxBytesPerDrain;
+    bool wrote = false;
+
+    while (budget > 0)
+    {
+        const uint8_t* bytes;
+        int length = Peek(bytes);
+        if (length == 0)
+        {
+            break;
+        }
+        length = (length < budget) ? length : budget;
+
+        for (int ix = 0; ix < length; ix++)
+        {
+            EEPROM.update(PS_DiagStoreBase + _writeIx, bytes[ix]);
+            _writeIx = ((_writeIx + 1) < PS_TotalDiagStoreSize) ? (_writeIx + 1) : 0;
+        }
+        Consume(length);
+        budget -= length;
+        wrote = true;
+    }
+
+    if (wrote)
+    {
+        EEPROM.update(PS_DiagStoreBase + _writeIx, 0);      // new end marker
+    }
+}
+
+// Print the stored records, oldest first - the partial record just after the end marker is skipped
+void Logger::FlashSink::Dump(Print& To)
+{
+    bool inSync = false;
+    uint16_t ix = _writeIx;
+
+    for (uint16_t count = 1; count < PS_TotalDiagStoreSize; count++)
+    {
+        ix = ((ix + 1) < PS_TotalDiagStoreSize) ? (ix + 1) : 0;
+        uint8_t const c = EEPROM.read(PS_DiagStoreBase + ix);
+
+        if (!inSync)
+        {
+            inSync = (c == '\n') || (c == 0) || (c == 0xFF);
+            continue;
+        }
+
+        if (((c >= ' ') && (c < 0x7F)) || (c == '\r') || (c == '\n'))
+        {
+            To.write(c);
+        }
+    }
+}
+
+void Logger::FlashSink::Erase()
+{
+    for (uint16_t ix = 0; ix < PS_TotalDiagStoreSize; ix++)
+    {
+        EEPROM.update(PS_DiagStoreBase + ix, 0xFF);
+    }
+    _writeIx = 0;
+    EEPROM.update(PS_DiagStoreBase, 0);
+}
+
+
+//** Logger Console methods
+// logLevel                         - show the level of each module
+// logLevel <module>|all <level>    - set and persist; level is INFO, PROG, WARN, CRIT or OFF
+CmdLine::Status LogLevelProcessor(Stream &CmdStream, int Argc, char const **Args, void *Context)
+{
+    if (Argc == 1)
+    {
+        printf(CmdStream, "Log Levels (build floor: %s):\n", Logger::LevelToString(SPA_LOG_FLOOR));
+        for (int ix = 0; ix < (int)Logger::Module::Count; ix++)
+        {
+            printf(CmdStream, "    %s: %s\n", Logger::GetModuleDescription((Logger::Module)ix), Logger::LevelToString(logger.GetLevel((Logger::Module)ix)));
+        }
+        return CmdLine::Status::Ok;
+    }
+
+    if (Argc != 3)
+    {
+        printf(CmdStream, "Show or set log levels. Usage: logLevel [<module>|all INFO|PROG|WARN|CRIT|OFF]\n");
+        return CmdLine::Status::UnexpectedParameterCount;
+    }
+
+    uint8_t level;
+    if (!Logger::LevelFromString(Args[2], level))
+    {
+        CmdStream.println("Invalid level");
+        return CmdLine::Status::CommandFailed;
+    }
+
+    bool const all = (strcasecmp(Args[1], "all") == 0);
+    bool found = false;
+    for (int ix = 0; ix < (int)Logger::Module::Count; ix++)
+    {
+        if (all || (strcasecmp(Args[1], Logger::GetModuleDescription((Logger::Module)ix)) == 0))
+        {
+            logger.SetLevel((Logger::Module)ix, level);
+            found = true;
+        }
+    }
+
+    if (!found)
+    {
+        CmdStream.println("Invalid module");
+        return CmdLine::Status::CommandFailed;
+    }
+
+    SaveLevelsToConfig();
+
+    return CmdLine::Status::Ok;
+}
+
+// logSink                          - show the level and queue state of each sink
+// logSink <sink> <level>           - set and persist; level is INFO, PROG, WARN, CRIT or OFF
+CmdLine::Status LogSinkProcessor(Stream &CmdStream, int Argc, char const **Args, void *Context)
+{
+    if (Argc == 1)
+    {
+        printf(CmdStream, "Log Sinks:\n");
+        for (int ix = 0; ix < (int)Logger::SinkId::Count; ix++)
+        {
+            Logger::Sink::Stats stats;
+            logger.GetSink((Logger::SinkId)ix).GetStats(stats);
+            printf(CmdStream, "    %s: %s; Queued: %u of %u; High water: %u; Records: %u; Dropped: %u\n",
+                   Logger::GetSinkDescription((Logger::SinkId)ix),
+                   Logger::LevelToString(logger.GetSink((Logger::SinkId)ix).GetLevel()),
+                   stats._queued, stats._queueSize, stats._highWater, stats._records, stats._dropped);
+        }
+        return CmdLine::Status::Ok;
+    }
+
+    if (Argc != 3)
+    {
+        printf(CmdStream, "Show or set log sink levels. Usage: logSink [<sink> INFO|PROG|WARN|CRIT|OFF]\n");
+        return CmdLine::Status::UnexpectedParameterCount;
+    }
+
+    uint8_t level;
+    if (!Logger::LevelFromString(Args[2], level))
+    {
+        CmdStream.println("Invalid level");
+        return CmdLine::Status::CommandFailed;
+    }
+
+    int ix;
+    for (ix = 0; ix < (int)Logger::SinkId::Count; ix++)
+    {
+        if (strcasecmp(Args[1], Logger::GetSinkDescription((Logger::SinkId)ix)) == 0)
+        {
+            break;
+        }
+    }
+
+    if (ix == (int)Logger::SinkId::Count)
+    {
+        CmdStream.println("Invalid sink");
+        return CmdLine::Status::CommandFailed;
+    }
+
+    logger.GetSink((Logger::SinkId)ix).SetLevel(level);
+    SaveLevelsToConfig();
+
+    return CmdLine::Status::Ok;
+}
+
+// diagLog                          - dump the records in the flash diag region
+// diagLog erase                    - erase them
+CmdLine::Status DiagLogProcessor(Stream &CmdStream, int Argc, char const **Args, void *Context)
+{
+    if (Argc == 1)
+    {
+        logger.DumpFlashSink(CmdStream);
+        return CmdLine::Status::Ok;
+    }
+
+    if ((Argc == 2) && (strcmp(Args[1], "erase") == 0))
+    {
+        logger.EraseFlashSink();
+        return CmdLine::Status::Ok;
+    }
+
+    printf(CmdStream, "Dump or erase the flash diag log. Usage: diagLog [erase]\n");
+    return CmdLine::Status::UnexpectedParameterCount;
+}
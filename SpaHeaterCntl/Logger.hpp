@@ -5,6 +5,12 @@
 #include "SpaHeaterCntl.hpp"
 #include "Logger.hpp"
 
+//** Build time log floor - $Log() records with a RecType below this are compiled out entirely
+//   (e.g. -DSPA_LOG_FLOOR=3 keeps only Warning and Critical records)
+#if !defined(SPA_LOG_FLOOR)
+#define SPA_LOG_FLOOR               1       // Info: everything
+#endif
+
 //* System Logger
 class Logger
 {
@@ -19,22 +25,303 @@ public:
         Critical = 4,
     };
 
+    // Runtime level of a module: records with a RecType >= the level are logged; LevelOff disables the module
+    static constexpr uint8_t LevelOff = (uint8_t)RecType::Critical + 1;
+
+    // Modules with their own runtime log level
+    enum class Module : uint8_t
+    {
+        Main,
+        Boiler,
+        MQTT,
+        Network,
+        NTP,
+        WiFiJoinAp,
+        Console,
+        Count           // Number of modules - must be last
+    };
+    static constexpr const char* GetModuleDescription(Module module)
+    {
+        switch (module)
+        {
+            case Module::Main:
+                return PSTR("Main");
+            case Module::Boiler:
+                return PSTR("Boiler");
+            case Module::MQTT:
+                return PSTR("MQTT");
+            case Module::Network:
+                return PSTR("Network");
+            case Module::NTP:
+                return PSTR("NTP");
+            case Module::WiFiJoinAp:
+                return PSTR("WiFiJoinAp");
+            case Module::Console:
+                return PSTR("Console");
+            default:
+                return PSTR("Unknown");
+        }
+    }
+
+    // Per RecType rate limit - a token bucket of _burst records refilled one token per _refillPeriodInMS
+    struct Budget
+    {
+        uint8_t     _burst;                 // zero: not rate limited
+        uint16_t    _refillPeriodInMS;
+    };
+
+    // State of one rate limited / deduplicated call site - see $LogLimited(). Sites register themselves
+    // with the logger on first use so pending suppression summaries can be flushed.
+    class CallSite
+    {
+    public:
+        // Token bucket check - done before the record is formatted so a suppressed call costs almost nothing
+        __inline bool Admit(RecType Type, const char* Format)
+        {
+            Budget const& budget = GetBudget(Type);
+            uint32_t const nowInMS = millis();
+
+            synchronized
+            {
+                if (_format == nullptr)
+                {
+                    Register(Format, budget, nowInMS);
+                }
+
+                if (budget._burst == 0)
+                {
+                    return true;
+                }
+
+                uint32_t const refills = (nowInMS - _lastRefillTimeInMS) / budget._refillPeriodInMS;
+                if (refills > 0)
+                {
+                    uint32_t const tokens = _tokens + refills;
+                    _tokens = (tokens > budget._burst) ? budget._burst : tokens;
+                    _lastRefillTimeInMS += refills * budget._refillPeriodInMS;
+                }
+
+                if (_tokens == 0)
+                {
+                    _suppressedCount++;
+                    return false;
+                }
+
+                _tokens--;
+            }
+            return true;
+        }
+
+    private:
+        friend class Logger;
+        void Register(const char* Format, Budget const& Budget, uint32_t NowInMS);
+
+        CallSite*   _next;
+        const char* _format;                // identifies the site in suppression summaries
+        uint32_t    _lastRefillTimeInMS;
+        uint32_t    _lastEmitTimeInMS;
+        uint32_t    _lastHash;              // of the last emitted record - for dedup
+        uint32_t    _suppressedCount;       // since the last emitted record or summary
+        uint8_t     _tokens;
+        RecType     _lastType;
+    };
+
+    //** Log sinks - every emitted record is formatted once and then queued to each sink whose level admits it.
+    //   Each sink has its own bounded queue; a record that does not fit is dropped (and counted) rather than
+    //   waiting, so a slow consumer can never stall the thread doing the logging. Queues are drained from the
+    //   main thread only.
+    enum class SinkId : uint8_t
+    {
+        Serial,
+        Telnet,         // The active telnet console session - if any
+        MQTT,           // Published to the MQTT log topic by the MQTT client
+        Flash,          // Circular record store in the EEPROM diag region
+        Count           // Number of sinks - must be last
+    };
+    static constexpr const char* GetSinkDescription(SinkId sink)
+    {
+        switch (sink)
+        {
+            case SinkId::Serial:
+                return PSTR("Serial");
+            case SinkId::Telnet:
+                return PSTR("Telnet");
+            case SinkId::MQTT:
+                return PSTR("MQTT");
+            case SinkId::Flash:
+                return PSTR("Flash");
+            default:
+                return PSTR("Unknown");
+        }
+    }
+
+    // A sink's queue of complete records - each is held as a 16 bit length followed by its bytes. Any thread
+    // may Enqueue(); only the draining (main) thread may Peek() and Consume().
+    class Sink
+    {
+    public:
+        struct Stats
+        {
+            uint32_t    _records;           // queued
+            uint32_t    _dropped;           // queue full (or record larger than the queue)
+            uint16_t    _queued;            // bytes currently queued
+            uint16_t    _highWater;         // max bytes ever queued
+            uint16_t    _queueSize;
+        };
+
+        Sink() = delete;
+        Sink(uint8_t* Queue, uint16_t QueueSize, RecType Level);
+
+        __inline bool Accepts(RecType Type) { return _enabled && ((uint8_t)Type >= _level); }
+        bool Enqueue(const char* Record, uint16_t Length);
+
+        uint16_t PeekRecordLength();                // of the record at the head of the queue; zero if empty
+        uint16_t Peek(const uint8_t*& Bytes);       // next contiguous unconsumed bytes of the head record
+        void Consume(uint16_t Length);              // of the head record; it is dequeued once fully consumed
+
+        virtual void Drain() {}                     // called from the main loop by Logger::Drain()
+
+        __inline uint8_t GetLevel() { return _level; }
+        __inline void SetLevel(uint8_t Level) { _level = Level; }
+        __inline void SetEnabled(bool Enabled) { _enabled = Enabled; }
+        void GetStats(Stats& Stats);
+
+    private:
+        __inline uint8_t& At(uint16_t Ix) { return _queue[(Ix < _queueSize) ? Ix : (Ix - _queueSize)]; }
+
+    private:
+        uint8_t* const      _queue;
+        uint16_t const      _queueSize;
+        uint16_t            _head;              // first byte of the head record's length
+        uint16_t            _used;
+        uint16_t            _headOffset;        // bytes of the head record already consumed
+        uint16_t            _highWater;
+        uint32_t            _records;
+        uint32_t            _dropped;
+        uint8_t             _level;
+        volatile bool       _enabled;
+    };
+
+    // Sink drained to a Stream - at most _maxBytesPerDrain (and no more than the stream will take without
+    // blocking, when it reports that) per main loop pass
+    class StreamSink : public Sink
+    {
+    public:
+        StreamSink(Print* To, uint8_t* Queue, uint16_t QueueSize, RecType Level, uint16_t MaxBytesPerDrain);
+        void SetStream(Print* To);                  // nullptr: detached - records are not queued
+        virtual void Drain() override;
+        void DrainAll();                            // everything queued, blocking on the stream - FailFast() only
+
+    private:
+        Print*              _out;
+        uint16_t const      _maxBytesPerDrain;
+    };
+
+    // Sink drained into the EEPROM diag region - a circular store of records with a zero byte marking the
+    // end of the newest record (so no separately persisted write position is needed)
+    class FlashSink : public Sink
+    {
+    public:
+        FlashSink(uint8_t* Queue, uint16_t QueueSize, RecType Level);
+        void Begin();                               // find the end of the store; enables the sink
+        virtual void Drain() override;
+        void Dump(Print& To);                       // oldest to newest
+        void Erase();
+
+    private:
+        static constexpr uint16_t   _maxBytesPerDrain = 16;         // EEPROM writes are slow
+        uint16_t            _writeIx;               // offset in the diag region of the end marker
+    };
+
     Logger() = delete;
     Logger(Stream &ToStream);
     ~Logger();
 
     void Begin(uint32_t InstanceSeq);
     int Printf(Logger::RecType Type, const char *Format, ...);
-    void SetFilter(Logger::RecType HighFilterType);
+    int Printf(Logger::CallSite& Site, Logger::RecType Type, const char *Format, ...);
+    // Single load and compare - Module and Type are constants at every $Log() site
+    __inline bool IsEnabled(Logger::Module Module, Logger::RecType Type) { return (uint8_t)Type >= _moduleLevels[(uint8_t)Module]; }
+    __inline uint8_t GetLevel(Logger::Module Module) { return _moduleLevels[(uint8_t)Module]; }
+    void SetLevel(Logger::Module Module, uint8_t Level);
+    void SetLevelsFromConfig();
+    static const char* LevelToString(uint8_t Level);
+    static bool LevelFromString(const char* From, uint8_t& Level);
+    void Flush();                           // Emit summaries for sites whose suppressed records have gone quiet
+    uint32_t GetTotalSuppressed();
+
+    void Drain();                           // Move queued records to the Serial, Telnet and Flash sinks - main thread only
+    __inline void DrainSerialForFailFast() { _serialSink.DrainAll(); }     // see FailFastDrainLog()
+    Sink& GetSink(Logger::SinkId Sink);
+    __inline void SetTelnetStream(Print* To) { _telnetSink.SetStream(To); }
+    __inline void DumpFlashSink(Print& To) { _flashSink.Dump(To); }
+    __inline void EraseFlashSink() { _flashSink.Erase(); }
 
     static const char *ToString(Logger::RecType From);
+    static __inline Budget const& GetBudget(Logger::RecType Type)
+    {
+        return ((uint8_t)Type < (sizeof(_budgets) / sizeof(_budgets[0]))) ? _budgets[(uint8_t)Type] : _budgets[0];
+    }
 
 private:
-    Stream &_out;
+    int FormatHeader(char* To, int Size, Logger::RecType Type);
+    void Emit(Logger::RecType Type, char* Record, int Length, int Size);
+
+private:
+    static constexpr Budget     _budgets[] =
+    {
+        {0, 0},         // Start, NtpRef and any other reserved types: never limited
+        {5, 2000},      // Info
+        {5, 2000},      // Progress
+        {10, 1000},     // Warning
+        {10, 500},      // Critical
+    };
+    static constexpr uint32_t   _dedupWindowInMS = 60 * 1000;   // identical records from a site are collapsed for this long
+
+    StreamSink _serialSink;
+    StreamSink _telnetSink;
+    Sink _mqttSink;
+    FlashSink _flashSink;
     uint32_t _logSeq;
     uint32_t _instanceSeq;
-    RecType _highFilterType; // Only log records with a type >= this
+    uint8_t _moduleLevels[(int)Module::Count];     // Only log records with a type >= the module's level
+    CallSite* _sites;        // all registered call sites
+    uint32_t _totalSuppressed;
+};
+
+//** Logging - Module and Type are the bare Logger::Module and Logger::RecType names (e.g. $Log(MQTT, Warning, ...)).
+//   Records below SPA_LOG_FLOOR compile away; otherwise the module's level is checked before any of the
+//   arguments are evaluated or formatted.
+#define $Log(M, T, Format, ...)                                                                             \
+    do                                                                                                      \
+    {                                                                                                       \
+        if (((uint8_t)Logger::RecType::T >= SPA_LOG_FLOOR) && logger.IsEnabled(Logger::Module::M, Logger::RecType::T))   \
+            logger.Printf(Logger::RecType::T, Format, ##__VA_ARGS__);                                      \
+    } while (0)
+
+//** Rate limited and deduplicated logging - as $Log() but each use is its own call site with its own budget
+//   and dedup state. The budget check is also done before any of the arguments are evaluated or formatted.
+#define $LogLimited(M, T, Format, ...)                                                                      \
+    do                                                                                                      \
+    {                                                                                                       \
+        static Logger::CallSite __logSite;                                                                  \
+        if (((uint8_t)Logger::RecType::T >= SPA_LOG_FLOOR) && logger.IsEnabled(Logger::Module::M, Logger::RecType::T) && \
+            __logSite.Admit(Logger::RecType::T, Format))                                                    \
+            logger.Printf(__logSite, Logger::RecType::T, Format, ##__VA_ARGS__);                           \
+    } while (0)
+
+//* Logger Config Record - In persistant storage
+#pragma pack(push, 1)
+struct LoggerConfig
+{
+    uint8_t     _moduleLevels[(int)Logger::Module::Count];
+    uint8_t     _sinkLevels[(int)Logger::SinkId::Count];
 };
+#pragma pack(pop)
 
 //** Cross module references
 extern class Logger logger;
+extern class FlashStore<LoggerConfig, PS_LoggerConfigBase> loggerConfig;
+extern CmdLine::Status LogLevelProcessor(Stream &CmdStream, int Argc, char const **Args, void *Context);
+extern CmdLine::Status LogSinkProcessor(Stream &CmdStream, int Argc, char const **Args, void *Context);
+extern CmdLine::Status DiagLogProcessor(Stream &CmdStream, int Argc, char const **Args, void *Context);
@@ -5,11 +5,29 @@
 #include <ArduinoMqttClient.h>
 #include <functional>
 #include "MQTT_HA.hpp"
+#include "JsonTemplate.hpp"
 
 namespace TinyBus
 {
     namespace HA_Mqtt
     {
+        //* Published properties that have a publish policy - the names are the state document keys
+        enum class PublishItem : uint8_t
+        {
+            BoilerInTemp,           // water_heater current temperature and the BoilerInTemp sensor
+            BoilerOutTemp,
+            AmbientTemp,
+            Hysterisis,
+            SetPoint,
+            HeaterState,
+            BoilerState,
+            FaultReason,
+            BoilerMode,
+            Count                   // Number of items - must be last
+        };
+        static constexpr const char* _publishItemNames[] = {"in", "out", "amb", "hyst", "sp", "heat", "state", "fault", "mode"};
+            static_assert((sizeof(_publishItemNames) / sizeof(_publishItemNames[0])) == (size_t)PublishItem::Count, "name each PublishItem");
+
         //* MQTT Configuration record
         #pragma pack(push, 1)
         struct HA_MqttConfig
@@ -32,6 +50,29 @@ namespace TinyBus
             char _baseHATopic[_maxBaseHATopicLen];
             char _haDeviceName[_maxHaDeviceNameLen];
 
+            // Publish policy per PublishItem - added after the fields above; see MigrateConfig()
+            struct PublishPolicy
+            {
+                float       _deadband;              // absolute change needed to publish; native units (°C) - 0: any change
+                uint16_t    _minIntervalInSecs;     // least time between publishes of changes - 0: none
+                uint16_t    _maxIntervalInSecs;     // heartbeat - republish even if unchanged - 0: never
+            };
+            PublishPolicy _publishPolicy[(int)PublishItem::Count];
+
+            // CRC of the discovery (/config) messages last sent - retained by the broker; see MigrateConfig()
+            uint32_t _discoveryFingerprint;
+
+            void SetDefaultPublishPolicies()
+            {
+                for (int ix = 0; ix < (int)PublishItem::Count; ix++)
+                {
+                    bool const isTemp = (ix <= (int)PublishItem::AmbientTemp);
+                    _publishPolicy[ix]._deadband = isTemp ? 0.2 : 0.0;
+                    _publishPolicy[ix]._minIntervalInSecs = isTemp ? 10 : 0;
+                    _publishPolicy[ix]._maxIntervalInSecs = 300;
+                }
+            }
+
             bool IsFullyConfigured() const
             {
                 return  (_brokerIP != 0) && 
@@ -45,7 +86,7 @@ namespace TinyBus
         };
         #pragma pack(pop)
 
-        //* Utility class for determining the size of an Expanded JSON string template
+        //* Utility class for determining the size of a message before streaming it
         class PrintOutputCounter : public Print
         {
         private:
@@ -64,7 +105,6 @@ namespace TinyBus
                 return size;
             }
             int GetCount() const { return _count; }
-            void Reset() { _count = 0; }
         };
 
         //* Utility class for expanding a JSON string template into a buffer
@@ -112,59 +152,42 @@ namespace TinyBus
             return bytesToCopy;
         }
 
-        //* Utility function for expanding a JSON template string using passed parameters into a Print object
-        //  For example this function is used to expand a JSON template string direct;ly into a MqttClient 
-        //  message stream
-        size_t ExpandJson(Print &To, const char *JsonFormat, ...)
+        //* Utility class for computing the CRC-32 of everything printed to it - without buffering it
+        class CrcPrinter : public Print
         {
-            uint32_t(*va_list)[0] = VarArgsBase(&JsonFormat);
-            size_t result = 0;
+        private:
+            uint32_t _crc;
 
-            char *p = (char *)JsonFormat;
-            while (*p)
-            {
-                if (*p == '%')
-                {
-                    p++;
+        public:
+            CrcPrinter() : _crc(0xFFFFFFFFUL) {}
 
-                    if (isdigit(*p))
-                    {
-                        int index = *p - '0';
-                        if ((index <= 9) && (index >= 0))
-                        {
-                            result += To.print((char *)((*va_list)[index]));
-                        }
-                    }
-                    else if (*p == '%')
-                    {
-                        result += To.print('%');
-                    }
-                    else
-                    {
-                        Serial.print("Error: Invalid format specifier: ");
-                        return 0;
-                    }
-                }
-                else if (*p == '\'')
+            virtual size_t write(uint8_t c) override final
+            {
+                _crc ^= c;
+                for (int bit = 0; bit < 8; bit++)
                 {
-                    result += To.print('"');
+                    _crc = (_crc >> 1) ^ (0xEDB88320UL & (0 - (_crc & 1)));
                 }
-                else
+                return 1;
+            }
+            virtual size_t write(const uint8_t *buffer, size_t size) override final
+            {
+                for (size_t ix = 0; ix < size; ix++)
                 {
-                    result += To.print(*p);
+                    write(buffer[ix]);
                 }
-                p++;
+                return size;
             }
+            uint32_t GetCrc() const { return ~_crc; }
+        };
 
-            return result;
-        }
-
-        
         //*** Home Assistant MQTT Namespace Names definitions
         static constexpr char _defaultBaseTopic[] = "homeassistant";
         static constexpr char _haAvailTopicSuffix[] = "status";
             static constexpr char _haAvailOnline[] = "online";
             static constexpr char _haAvailOffline[] = "offline";
+            static constexpr char _availOnlinePayload[] = "\"online\"";       // as JSON - see avty_tpl
+            static constexpr char _availOfflinePayload[] = "\"offline\"";
 
         static constexpr char _defaultDeviceName[] = "SpaHeater";
         static constexpr char _defaultBoilerName[] = "Boiler"; 
@@ -180,13 +203,65 @@ namespace TinyBus
         static constexpr char _defaultRebootButtonName[] = "RebootButton";
         static constexpr char _defaultHysterisisName[] = "Hysterisis";
 
+        //* Full topic from a base topic and a suffix
+        static constexpr char _topicJoinTemplate[] = "%0%1";                      // %0=Base Topic, %1=Suffix
+        static constexpr auto _topicJoinJson = $CompileJsonTemplate(_topicJoinTemplate);
+        static constexpr int MaxTopicLen = 95;          // longest joined topic - checked in setup()
+
         //* HA MQTT Intg Topic strings
         static constexpr char _haIntgAvailSuffix[] = "/status";
 
         //* Common Avail Topic for all entities
         static constexpr char _commonAvailTopicTemplate[] = "TinyBus/%0/avail";     // %0=Device Name
+        static constexpr auto _commonAvailTopicJson = $CompileJsonTemplate(_commonAvailTopicTemplate);
         char*   commonAvailTopic;      // Common Avail Topic expanded string
 
+        //* CRC of every expanded /config topic and message - computed in setup(); reconnects skip sending discovery
+        //  while it (with the broker - see BrokerDiscoveryFingerprint()) matches that of the retained messages last sent
+        uint32_t discoveryFingerprint;
+
+        //* Reconnect statistics - connect is the start of the broker connect; online is the /avail "online" publish.
+        //  A birth is Home Assistant's "online" status - handled without dropping the session
+        struct ConnectStats
+        {
+            uint32_t    _connects;
+            uint32_t    _discoverySkipped;
+            uint32_t    _lastToOnlineInMs;
+            uint32_t    _minToOnlineInMs;
+            uint32_t    _maxToOnlineInMs;
+            uint32_t    _haBirths;
+            uint32_t    _lastBirthToOnlineInMs;
+            uint32_t    _maxBirthToOnlineInMs;
+        };
+        ConnectStats connectStats = {0, 0, 0, UINT32_MAX, 0, 0, 0, 0};
+
+        //* Log Topic - records queued to the logger's MQTT sink are published here
+        static constexpr char _logTopicTemplate[] = "TinyBus/%0/log";             // %0=Device Name
+        static constexpr auto _logTopicJson = $CompileJsonTemplate(_logTopicTemplate);
+        char*   logTopic;              // Log Topic expanded string
+
+        //* Diag Topic - memory (stack and heap) usage is published here periodically as JSON
+        static constexpr char _diagTopicTemplate[] = "TinyBus/%0/diag";           // %0=Device Name
+        static constexpr auto _diagTopicJson = $CompileJsonTemplate(_diagTopicTemplate);
+        char*   diagTopic;             // Diag Topic expanded string
+        static constexpr uint32_t _diagPublishIntervalInMs = 60 * 1000;
+
+        //* Property changes captured while offline are replayed on their own state topics at this rate once reconnected
+        static constexpr uint32_t _replayIntervalInMs = 100;
+
+        //* Command Topics (SPA_MQTT_WILDCARD_SUBSCRIBE) - incoming commands for every entity arrive under this namespace;
+        //  a single wildcard subscription covers them all and the dispatcher routes each one
+        static constexpr char _commandBaseTopicTemplate[] = "TinyBus/%2/cmd/%1";  // %1=Entity Name, %2=Device Name
+        static constexpr auto _commandBaseTopicJson = $CompileJsonTemplate(_commandBaseTopicTemplate);
+        static constexpr char _commandWildcardTopicTemplate[] = "TinyBus/%0/cmd/#"; // %0=Device Name
+        static constexpr auto _commandWildcardTopicJson = $CompileJsonTemplate(_commandWildcardTopicTemplate);
+        char*   commandWildcardTopic;  // Command Wildcard Topic expanded string
+
+        //* State Topic - the JSON state document (SPA_MQTT_STATE_TOPIC) is published here
+        static constexpr char _stateTopicTemplate[] = "TinyBus/%0/state";         // %0=Device Name
+        static constexpr auto _stateTopicJson = $CompileJsonTemplate(_stateTopicTemplate);
+        char*   stateTopic;            // State Topic expanded string
+
         //* MQTT Topic suffixes for Home Assistant MQTT supported entity platforms
         // Common
         static constexpr char _haConfig[] = "/config";
@@ -219,9 +294,35 @@ namespace TinyBus
         
         //* JSON templates for Home Assistant MQTT configuration and base topic strings
 
+        // Where an entity's state comes from - its own ~<Suffix> topic; or with SPA_MQTT_STATE_TOPIC, field <Key> of the
+        // state document on %4. Keys must match the fields SendStateDoc publishes; "%5" takes the key from the entity.
+        //* Template views stored in the entity and topic tables - topics are expanded with <base_topic>, <entity-name>,
+        //  <device-name>; /config messages with <base_topic>, <device-name>, <entity-name>, <avail-topic>,
+        //  <state-topic>, <state-key>
+        typedef JsonTemplate<3> HaTopicJsonTemplate;
+        typedef JsonTemplate<6> HaConfigJsonTemplate;
+
+        // Where an entity's commands go - its own ~<Suffix> topic; or with SPA_MQTT_WILDCARD_SUBSCRIBE, <Suffix> under
+        // the entity's command base topic (see _commandBaseTopicTemplate)
+        #if SPA_MQTT_WILDCARD_SUBSCRIBE
+        #define $HaCommandTopic(Suffix)     "'TinyBus/%1/cmd/%2" Suffix "'"
+        #define $HaCommandBaseTopicJson(BaseTopicJson) _commandBaseTopicJson
+        #else
+        #define $HaCommandTopic(Suffix)     "'~" Suffix "'"
+        #define $HaCommandBaseTopicJson(BaseTopicJson) BaseTopicJson
+        #endif
+
+        #if SPA_MQTT_STATE_TOPIC
+        #define $HaStateTopic(Suffix)       "'%4'"
+        #define $HaValueTemplate(Key)       "'{{ value_json." Key " }}'"
+        #else
+        #define $HaStateTopic(Suffix)       "'~" Suffix "'"
+        #define $HaValueTemplate(Key)       "'{{ value_json }}'"
+        #endif
+
         // Home Assistant MQTT water_heater templates
         static constexpr char BoilerConfigJsonTemplate[] =
-            "{\n" // Parms: <base_topic>, <device-name>, <entity-name>, commonAvailTopic
+            "{\n" // Parms: <base_topic>, <device-name>, <entity-name>, commonAvailTopic, stateTopic
                 "'~' : '%0/water_heater/%2',\n"
                 "'name': '%2',\n"
                 "'modes': [\n"
@@ -232,12 +333,14 @@ namespace TinyBus
 
                 "'avty_t' : '%3',\n"
                 "'avty_tpl' : '{{ value_json }}',\n"
-                "'mode_stat_t': '~/mode',\n"
-                "'mode_stat_tpl' : '{{ value_json }}',\n"
-                "'mode_cmd_t': '~/mode/set',\n"
-                "'temp_stat_t': '~/temperature',\n"
-                "'temp_cmd_t': '~/temperature/set',\n"
-                "'curr_temp_t': '~/current_temperature',\n"
+                "'mode_stat_t': " $HaStateTopic("/mode") ",\n"
+                "'mode_stat_tpl' : " $HaValueTemplate("mode") ",\n"
+                "'mode_cmd_t': " $HaCommandTopic("/mode/set") ",\n"
+                "'temp_stat_t': " $HaStateTopic("/temperature") ",\n"
+                "'temp_stat_tpl' : " $HaValueTemplate("sp") ",\n"
+                "'temp_cmd_t': " $HaCommandTopic("/temperature/set") ",\n"
+                "'curr_temp_t': " $HaStateTopic("/current_temperature") ",\n"
+                "'curr_temp_tpl' : " $HaValueTemplate("in") ",\n"
                 "'power_command_topic' : '~/power/set',\n"
                 "'max_temp' : '160',\n"
                 "'min_temp' : '65',\n"
@@ -252,23 +355,26 @@ namespace TinyBus
                     "'name' : '%1'\n"
                 "}\n"
             "}\n";
+        static constexpr auto boilerConfigJson = $CompileJsonTemplate(BoilerConfigJsonTemplate);
 
         // JSON template for Home Assistant MQTT base topic for water_heater
         static constexpr char BoilerBaseTopicJsonTemplate[] = "%0/water_heater/%1";   // Parms: <base_topic>, <entity-name>
+        static constexpr auto boilerBaseTopicJson = $CompileJsonTemplate(BoilerBaseTopicJsonTemplate);
         char*   boilerBaseTopic;      // Boiler Base Topic expanded string
         int expandedMsgSizeOfBoilerConfigJson;
 
 
         // Template for Home Assistant MQTT sensor (temperature) configuration
         static constexpr char ThermometerConfigJsonTemplate[] =
-            "{\n" // Parms: <base_topic>, <device-name>, <entity-name>, commonAvailTopic
+            "{\n" // Parms: <base_topic>, <device-name>, <entity-name>, commonAvailTopic, stateTopic, <state-key>
                 "'~' : '%0/sensor/%2',\n"
                 "'name': '%2',\n"
                 "'dev_cla' : 'temperature',\n"
                 "'unit_of_meas' : '°F',\n"
                 "'avty_t' : '%3',\n"
                 "'avty_tpl' : '{{ value_json }}',\n"
-                "'stat_t' : '~/temperature',\n"    
+                "'stat_t' : " $HaStateTopic("/temperature") ",\n"
+                "'val_tpl' : " $HaValueTemplate("%5") ",\n"
                 "'uniq_id' : '%2',\n"
                 "'dev':\n"
                 "{\n"
@@ -276,9 +382,11 @@ namespace TinyBus
                     "'name' : '%1'\n"
                 "}\n"
             "}\n";
+        static constexpr auto thermometerConfigJson = $CompileJsonTemplate(ThermometerConfigJsonTemplate);
 
         // JSON template for Home Assistant MQTT base topic for sensor (temperature) topics
         static constexpr char ThermometerBaseTopicJsonTemplate[] = "%0/sensor/%1"; // Parms: <base_topic>, <entity-name>
+        static constexpr auto thermometerBaseTopicJson = $CompileJsonTemplate(ThermometerBaseTopicJsonTemplate);
 
         // Our three thermometers
         char*   ambientThermometerBaseTopic;          // Ambient Thermometer Base Topic expanded string
@@ -290,13 +398,13 @@ namespace TinyBus
 
         // Template for Home Assistant MQTT binary_sensor (running) configuration
         static constexpr char BinarySensorConfigJsonTemplate[] =
-            "{\n" // Parms: <base_topic>, <device-name>, <entity-name>, commonAvailTopic
+            "{\n" // Parms: <base_topic>, <device-name>, <entity-name>, commonAvailTopic, stateTopic, <state-key>
                 "'~' : '%0/binary_sensor/%2',\n"
                 "'name': '%2',\n"
                 "'avty_t' : '%3',\n"
                 "'avty_tpl' : '{{ value_json }}',\n"
-                "'stat_t' : '~/state',\n"
-                "'val_tpl' : '{{ value_json }}',\n"
+                "'stat_t' : " $HaStateTopic("/state") ",\n"
+                "'val_tpl' : " $HaValueTemplate("%5") ",\n"
                 "'pl_on' : 'On',\n"
                 "'pl_off' : 'Off',\n"
                 "'uniq_id' : '%2',\n"
@@ -306,9 +414,11 @@ namespace TinyBus
                     "'name' : '%1'\n"
                 "}\n"
             "}\n";
+        static constexpr auto binarySensorConfigJson = $CompileJsonTemplate(BinarySensorConfigJsonTemplate);
 
         // JSON template for Home Assistant MQTT base topic for binary_sensor (running) topics
         static constexpr char BinarySensorBaseTopicJsonTemplate[] = "%0/binary_sensor/%1"; // Parms: <base_topic>, <entity-name>
+        static constexpr auto binarySensorBaseTopicJson = $CompileJsonTemplate(BinarySensorBaseTopicJsonTemplate);
 
         char*   heaterStateBinarySensorBaseTopic;           // Heater State Binary Sensor Base Topic expanded string
         int     expandedMsgSizeOfHeaterBinarySensorConfigJson;
@@ -317,14 +427,14 @@ namespace TinyBus
         // Template for Home Assistant MQTT sensor (enum) configuration. This for any "sensor" that wants to just publish
         // a value that is an enum (e.g. "ON" or "OFF")
         static constexpr char EnumTextSensorConfigJsonTemplate[] =
-            "{\n" // Parms: <base_topic>, <device-name>, <entity-name>, , commonAvailTopic
+            "{\n" // Parms: <base_topic>, <device-name>, <entity-name>, , commonAvailTopic, stateTopic, <state-key>
                 "'~' : '%0/sensor/%2',\n"
                 "'name': '%2',\n"
                 "'device_class' : 'enum',\n"
                 "'avty_t' : '%3',\n"
                 "'avty_tpl' : '{{ value_json }}',\n"
-                "'stat_t' : '~/state',\n"
-                "'val_tpl' : '{{ value_json }}',\n"
+                "'stat_t' : " $HaStateTopic("/state") ",\n"
+                "'val_tpl' : " $HaValueTemplate("%5") ",\n"
                 "'uniq_id' : '%2',\n"
                 "'dev':\n"
                 "{\n"
@@ -332,9 +442,11 @@ namespace TinyBus
                     "'name' : '%1'\n"
                 "}\n"
             "}\n";
+        static constexpr auto enumTextSensorConfigJson = $CompileJsonTemplate(EnumTextSensorConfigJsonTemplate);
 
         // JSON template for Home Assistant MQTT base topic for sensor (enum) topic
         static constexpr char EnumTextSensorBaseTopicJsonTemplate[] = "%0/sensor/%1"; // Parms: <base_topic>, <entity-name>
+        static constexpr auto enumTextSensorBaseTopicJson = $CompileJsonTemplate(EnumTextSensorBaseTopicJsonTemplate);
         char* boilerStateSensorBaseTopic;           // Boiler State Sensor Base Topic expanded string
         int expandedMsgSizeOfBoilerStateSensorConfigJson;
 
@@ -348,7 +460,7 @@ namespace TinyBus
                 "'name': '%2',\n"
                 "'avty_t' : '%3',\n"
                 "'avty_tpl' : '{{ value_json }}',\n"
-                "'command_topic' : '~/cmd',\n"
+                "'command_topic' : " $HaCommandTopic("/cmd") ",\n"
                 "'device_class' : 'restart',\n"
                 "'uniq_id' : '%2',\n"
                 "'dev':\n"
@@ -357,10 +469,12 @@ namespace TinyBus
                     "'name' : '%1'\n"
                 "}\n"
             "}\n";
+        static constexpr auto buttonConfigJson = $CompileJsonTemplate(ButtonConfigJsonTemplate);
 
 
         // JSON template for Home Assistant MQTT base topic for button topics
         static constexpr char ButtonBaseTopicJsonTemplate[] = "%0/button/%1"; // Parms: <base_topic>, <entity-name>
+        static constexpr auto buttonBaseTopicJson = $CompileJsonTemplate(ButtonBaseTopicJsonTemplate);
         char*   resetButtonBaseTopic;           // Reset Button Base Topic expanded string
         int expandedMsgSizeOfResetButtonConfigJson;
         char*   startButtonBaseTopic;           // Start Button Base Topic expanded string
@@ -373,15 +487,16 @@ namespace TinyBus
 
         // JSON template for Home Assistant MQTT numeric (Hysterisis) configuration
         static constexpr char HysterisisConfigJsonTemplate[] =
-            "{\n" // Parms: <base_topic>, <device-name>, <entity-name>, commonAvailTopic
+            "{\n" // Parms: <base_topic>, <device-name>, <entity-name>, commonAvailTopic, stateTopic, <state-key>
                 "'~' : '%0/number/%2',\n"
                 "'name': '%2',\n"
                 "'device_class' : 'temperature',\n"
                 "'unit_of_meas' : '°F',\n"
                 "'avty_t' : '%3',\n"
                 "'avty_tpl' : '{{ value_json }}',\n"
-                "'stat_t' : '~/state',\n"
-                "'command_topic' : '~/set',\n"
+                "'stat_t' : " $HaStateTopic("/state") ",\n"
+                "'val_tpl' : " $HaValueTemplate("%5") ",\n"
+                "'command_topic' : " $HaCommandTopic("/set") ",\n"
                 "'min' : 0.01,\n"
                 "'max' : 5.0,\n"
                 "'step' : 0.01,\n"
@@ -392,9 +507,11 @@ namespace TinyBus
                     "'name' : '%1'\n"
                 "}\n"
             "}\n";
+        static constexpr auto hysterisisConfigJson = $CompileJsonTemplate(HysterisisConfigJsonTemplate);
 
         // JSON template for Home Assistant MQTT base topic for numeric (Hysterisis) topic
         static constexpr char HysterisisBaseTopicJsonTemplate[] = "%0/number/%1"; // Parms: <base_topic>, <entity-name>
+        static constexpr auto hysterisisBaseTopicJson = $CompileJsonTemplate(HysterisisBaseTopicJsonTemplate);
         char*   hysterisisBaseTopic;           // Hysterisis Base Topic expanded string
         int expandedMsgSizeOfHysterisisConfigJson;
 
@@ -404,14 +521,16 @@ namespace TinyBus
         {
         public:
             const char* const _EntityName;
-            const char* const _ConfigJsonTemplate;
-            const char* const _BaseTopicJsonTemplate;
+            const char* const _StateKey;        // field of the state document (SPA_MQTT_STATE_TOPIC)
+            HaConfigJsonTemplate const _ConfigJsonTemplate;
+            HaTopicJsonTemplate const _BaseTopicJsonTemplate;
             char** _BaseTopicResult;
             int* _ExpandedMsgSizeResult;
         
             HaEntityDesc() = delete;
-            HaEntityDesc(const char* EntityName, const char* ConfigJsonTemplate, const char* BaseTopicJsonTemplate, char** BaseTopicResult, int* ExpandedMsgSizeResult) :
+            HaEntityDesc(const char* EntityName, const char* StateKey, HaConfigJsonTemplate ConfigJsonTemplate, HaTopicJsonTemplate BaseTopicJsonTemplate, char** BaseTopicResult, int* ExpandedMsgSizeResult) :
                 _EntityName(EntityName), 
+                _StateKey(StateKey),
                 _ConfigJsonTemplate(ConfigJsonTemplate), 
                 _BaseTopicJsonTemplate(BaseTopicJsonTemplate), 
                 _BaseTopicResult(BaseTopicResult), 
@@ -422,24 +541,587 @@ namespace TinyBus
         // Describes all Home Assistant entities - for building the /config and /avail messages
         HaEntityDesc _entityDescs[] = 
         {
-            HaEntityDesc(_defaultBoilerName, BoilerConfigJsonTemplate, BoilerBaseTopicJsonTemplate, &boilerBaseTopic, &expandedMsgSizeOfBoilerConfigJson),
-            HaEntityDesc(_defaultAmbientTempName, ThermometerConfigJsonTemplate, ThermometerBaseTopicJsonTemplate, &ambientThermometerBaseTopic, &expandedMsgSizeOfAmbientThermometerConfigJson),
-            HaEntityDesc(_defaultBoilerInTempName, ThermometerConfigJsonTemplate, ThermometerBaseTopicJsonTemplate, &boilerInThermometerBaseTopic, &expandedMsgSizeOfBoilerInThermometerConfigJson),
-            HaEntityDesc(_defaultBoilerOutTempName, ThermometerConfigJsonTemplate, ThermometerBaseTopicJsonTemplate, &boilerOutThermometerBaseTopic, &expandedMsgSizeOfBoilerOutThermometerConfigJson),
-            HaEntityDesc(_defaultHeaterStateName, BinarySensorConfigJsonTemplate, BinarySensorBaseTopicJsonTemplate, &heaterStateBinarySensorBaseTopic, &expandedMsgSizeOfHeaterBinarySensorConfigJson),
-            HaEntityDesc(_defaultBoilerStateName, EnumTextSensorConfigJsonTemplate, EnumTextSensorBaseTopicJsonTemplate, &boilerStateSensorBaseTopic, &expandedMsgSizeOfBoilerStateSensorConfigJson),
-            HaEntityDesc(_defaultFaultReasonName, EnumTextSensorConfigJsonTemplate, EnumTextSensorBaseTopicJsonTemplate, &faultReasonSensorBaseTopic, &expandedMsgSizeOfFaultReasonSensorConfigJson),
-            HaEntityDesc(_defaultResetButtonName, ButtonConfigJsonTemplate, ButtonBaseTopicJsonTemplate, &resetButtonBaseTopic, &expandedMsgSizeOfResetButtonConfigJson),
-            HaEntityDesc(_defaultStartButtonName, ButtonConfigJsonTemplate, ButtonBaseTopicJsonTemplate, &startButtonBaseTopic, &expandedMsgSizeOfStartButtonConfigJson),
-            HaEntityDesc(_defaultRebootButtonName, ButtonConfigJsonTemplate, ButtonBaseTopicJsonTemplate, &rebootButtonBaseTopic, &expandedMsgSizeOfRebootButtonConfigJson),
-            HaEntityDesc(_defaultStopButtonName, ButtonConfigJsonTemplate, ButtonBaseTopicJsonTemplate, &stopButtonBaseTopic, &expandedMsgSizeOfStopButtonConfigJson),
-            HaEntityDesc(_defaultHysterisisName, HysterisisConfigJsonTemplate, HysterisisBaseTopicJsonTemplate, &hysterisisBaseTopic, &expandedMsgSizeOfHysterisisConfigJson)
+            HaEntityDesc(_defaultBoilerName, "", boilerConfigJson, boilerBaseTopicJson, &boilerBaseTopic, &expandedMsgSizeOfBoilerConfigJson),
+            HaEntityDesc(_defaultAmbientTempName, "amb", thermometerConfigJson, thermometerBaseTopicJson, &ambientThermometerBaseTopic, &expandedMsgSizeOfAmbientThermometerConfigJson),
+            HaEntityDesc(_defaultBoilerInTempName, "in", thermometerConfigJson, thermometerBaseTopicJson, &boilerInThermometerBaseTopic, &expandedMsgSizeOfBoilerInThermometerConfigJson),
+            HaEntityDesc(_defaultBoilerOutTempName, "out", thermometerConfigJson, thermometerBaseTopicJson, &boilerOutThermometerBaseTopic, &expandedMsgSizeOfBoilerOutThermometerConfigJson),
+            HaEntityDesc(_defaultHeaterStateName, "heat", binarySensorConfigJson, binarySensorBaseTopicJson, &heaterStateBinarySensorBaseTopic, &expandedMsgSizeOfHeaterBinarySensorConfigJson),
+            HaEntityDesc(_defaultBoilerStateName, "state", enumTextSensorConfigJson, enumTextSensorBaseTopicJson, &boilerStateSensorBaseTopic, &expandedMsgSizeOfBoilerStateSensorConfigJson),
+            HaEntityDesc(_defaultFaultReasonName, "fault", enumTextSensorConfigJson, enumTextSensorBaseTopicJson, &faultReasonSensorBaseTopic, &expandedMsgSizeOfFaultReasonSensorConfigJson),
+            HaEntityDesc(_defaultResetButtonName, "", buttonConfigJson, buttonBaseTopicJson, &resetButtonBaseTopic, &expandedMsgSizeOfResetButtonConfigJson),
+            HaEntityDesc(_defaultStartButtonName, "", buttonConfigJson, buttonBaseTopicJson, &startButtonBaseTopic, &expandedMsgSizeOfStartButtonConfigJson),
+            HaEntityDesc(_defaultRebootButtonName, "", buttonConfigJson, buttonBaseTopicJson, &rebootButtonBaseTopic, &expandedMsgSizeOfRebootButtonConfigJson),
+            HaEntityDesc(_defaultStopButtonName, "", buttonConfigJson, buttonBaseTopicJson, &stopButtonBaseTopic, &expandedMsgSizeOfStopButtonConfigJson),
+            HaEntityDesc(_defaultHysterisisName, "hyst", hysterisisConfigJson, hysterisisBaseTopicJson, &hysterisisBaseTopic, &expandedMsgSizeOfHysterisisConfigJson)
         };
         int _entityDescCount = sizeof(_entityDescs) / sizeof(HaEntityDesc);
 
+        //* Full publish topics (<entity base topic><property suffix>) - built once in setup() so publishing a property
+        //  needs no string work and no lock
+        char*   boilerCurrTempTopic;
+        char*   boilerSetpointTopic;
+        char*   boilerModeTopic;
+        char*   boilerInThermometerTempTopic;
+        char*   boilerOutThermometerTempTopic;
+        char*   ambientThermometerTempTopic;
+        char*   hysterisisStateTopic;
+        char*   heaterStateTopic;
+        char*   boilerStateTopic;
+        char*   faultReasonTopic;
+
+        #if !SPA_MQTT_STATE_TOPIC
+        //* The full publish topics of each PublishItem - BoilerInTemp is both the water_heater's current temperature and
+        //  the BoilerInTemp sensor
+        struct PublishItemTopic
+        {
+            PublishItem     _item;
+            char**          _topic;
+        };
+        static constexpr PublishItemTopic _publishItemTopics[] =
+        {
+            {PublishItem::BoilerInTemp, &boilerCurrTempTopic},
+            {PublishItem::BoilerInTemp, &boilerInThermometerTempTopic},
+            {PublishItem::BoilerOutTemp, &boilerOutThermometerTempTopic},
+            {PublishItem::AmbientTemp, &ambientThermometerTempTopic},
+            {PublishItem::Hysterisis, &hysterisisStateTopic},
+            {PublishItem::SetPoint, &boilerSetpointTopic},
+            {PublishItem::HeaterState, &heaterStateTopic},
+            {PublishItem::BoilerState, &boilerStateTopic},
+            {PublishItem::FaultReason, &faultReasonTopic},
+            {PublishItem::BoilerMode, &boilerModeTopic},
+        };
+        #endif
+
+        //* Full command (subscribed) topics - also built once in setup()
+        char*   haIntgStatusTopic;
+        char*   boilerModeSetTopic;
+        char*   boilerSetpointSetTopic;
+        char*   resetButtonCmdTopic;
+        char*   startButtonCmdTopic;
+        char*   stopButtonCmdTopic;
+        char*   rebootButtonCmdTopic;
+        char*   hysterisisSetTopic;
+
+        //* Describes a published or subscribed (entity, property) topic
+        class HaPropertyTopicDesc
+        {
+        public:
+            const char* const _EntityName;
+            HaTopicJsonTemplate const _BaseTopicJsonTemplate;
+            const char* const _PropertySuffix;
+            char** _TopicResult;
+
+            HaPropertyTopicDesc() = delete;
+            HaPropertyTopicDesc(const char* EntityName, HaTopicJsonTemplate BaseTopicJsonTemplate, const char* PropertySuffix, char** TopicResult) :
+                _EntityName(EntityName),
+                _BaseTopicJsonTemplate(BaseTopicJsonTemplate),
+                _PropertySuffix(PropertySuffix),
+                _TopicResult(TopicResult)
+            {}
+        };
+
+        HaPropertyTopicDesc _propertyTopicDescs[] =
+        {
+            HaPropertyTopicDesc(_defaultBoilerName, boilerBaseTopicJson, _haWHCurrTemp, &boilerCurrTempTopic),
+            HaPropertyTopicDesc(_defaultBoilerName, boilerBaseTopicJson, _haWHSetpoint, &boilerSetpointTopic),
+            HaPropertyTopicDesc(_defaultBoilerName, boilerBaseTopicJson, _haWHMode, &boilerModeTopic),
+            HaPropertyTopicDesc(_defaultBoilerInTempName, thermometerBaseTopicJson, _haSensorTemp, &boilerInThermometerTempTopic),
+            HaPropertyTopicDesc(_defaultBoilerOutTempName, thermometerBaseTopicJson, _haSensorTemp, &boilerOutThermometerTempTopic),
+            HaPropertyTopicDesc(_defaultAmbientTempName, thermometerBaseTopicJson, _haSensorTemp, &ambientThermometerTempTopic),
+            HaPropertyTopicDesc(_defaultHysterisisName, hysterisisBaseTopicJson, _haNumericState, &hysterisisStateTopic),
+            HaPropertyTopicDesc(_defaultHeaterStateName, binarySensorBaseTopicJson, _haBinarySensorState, &heaterStateTopic),
+            HaPropertyTopicDesc(_defaultBoilerStateName, enumTextSensorBaseTopicJson, _haSensorEnum, &boilerStateTopic),
+            HaPropertyTopicDesc(_defaultFaultReasonName, enumTextSensorBaseTopicJson, _haSensorEnum, &faultReasonTopic),
+
+            HaPropertyTopicDesc(_defaultBoilerName, $HaCommandBaseTopicJson(boilerBaseTopicJson), _haWHModeSet, &boilerModeSetTopic),
+            HaPropertyTopicDesc(_defaultBoilerName, $HaCommandBaseTopicJson(boilerBaseTopicJson), _haWHSetpointSet, &boilerSetpointSetTopic),
+            HaPropertyTopicDesc(_defaultResetButtonName, $HaCommandBaseTopicJson(buttonBaseTopicJson), _haButtonCmd, &resetButtonCmdTopic),
+            HaPropertyTopicDesc(_defaultStartButtonName, $HaCommandBaseTopicJson(buttonBaseTopicJson), _haButtonCmd, &startButtonCmdTopic),
+            HaPropertyTopicDesc(_defaultStopButtonName, $HaCommandBaseTopicJson(buttonBaseTopicJson), _haButtonCmd, &stopButtonCmdTopic),
+            HaPropertyTopicDesc(_defaultRebootButtonName, $HaCommandBaseTopicJson(buttonBaseTopicJson), _haButtonCmd, &rebootButtonCmdTopic),
+            HaPropertyTopicDesc(_defaultHysterisisName, $HaCommandBaseTopicJson(hysterisisBaseTopicJson), _haNumericCmd, &hysterisisSetTopic)
+        };
+        int _propertyTopicDescCount = sizeof(_propertyTopicDescs) / sizeof(HaPropertyTopicDesc);
+
+        //* Bump arena that all topic strings are carved from - one allocation in setup(), never freed. It is used
+        //  in two passes: a sizing pass (before Allocate(); Carve() only totals sizes and returns nullptr) and then
+        //  the real pass over the same sequence of Carve() calls.
+        class StringArena
+        {
+        private:
+            char*   _buffer;
+            size_t  _size;
+            size_t  _used;
+
+        public:
+            StringArena() : _buffer(nullptr), _size(0), _used(0) {}
+
+            char* Carve(size_t Size)
+            {
+                if (_buffer == nullptr)
+                {
+                    _size += Size;
+                    return nullptr;
+                }
+                $Assert((_used + Size) <= _size);
+                char* result = &_buffer[_used];
+                _used += Size;
+                return result;
+            }
+
+            void Allocate()
+            {
+                $Assert(_buffer == nullptr);
+                _buffer = new char[_size];
+                $Assert(_buffer != nullptr);     // Out of memory
+            }
+
+            bool IsAllocated() const { return _buffer != nullptr; }
+            size_t GetSize() const { return _size; }
+        };
+        StringArena topicArena;
+
+        //* A subscription notification handler function type
+        using NotificationHandler = InplaceFunction<bool(const char *)>;
+
+        //* Dispatches incoming messages to the handler of their (full) topic. Topics are FNV-1a hashed when added
+        //  and looked up through a small open addressed index - so the cost of a dispatch does not grow with the
+        //  number of subscriptions. Each handler's dispatches are counted and timed.
+        class TopicDispatcher
+        {
+        public:
+            static constexpr int MaxTopics = 8;
+
+        private:
+            static constexpr int _indexSize = 2 * MaxTopics;        // power of 2; at most half full
+            static_assert((_indexSize & (_indexSize - 1)) == 0, "index size must be a power of 2");
+
+            struct Entry
+            {
+                const char*             _topic;
+                uint32_t                _hash;
+                NotificationHandler*    _handler;
+                PerfCounter             _perf;
+            };
+
+            StaticVector<Entry, MaxTopics>  _entries;
+            int8_t                          _index[_indexSize];     // entry index; -1: empty
+            uint32_t                        _unmatched;
+
+        public:
+            TopicDispatcher() : _unmatched(0)
+            {
+                memset(_index, -1, sizeof(_index));
+            }
+
+            static uint32_t Hash(const char *Topic)
+            {
+                uint32_t hash = 2166136261UL;
+                while (*Topic != 0)
+                {
+                    hash ^= (uint8_t)*Topic++;
+                    hash *= 16777619UL;
+                }
+                return hash;
+            }
+
+            void Add(const char *Topic, NotificationHandler &Handler)
+            {
+                Entry entry;
+                entry._topic = Topic;
+                entry._hash = Hash(Topic);
+                entry._handler = &Handler;
+
+                int slot = entry._hash & (_indexSize - 1);
+                while (_index[slot] >= 0)
+                {
+                    $Assert(strcmp(_entries[_index[slot]]._topic, Topic) != 0);    // duplicate subscription
+                    slot = (slot + 1) & (_indexSize - 1);
+                }
+                _index[slot] = _entries.Size();
+                _entries.PushBack(entry);
+            }
+
+            //* Returns false if no handler is subscribed to Topic
+            bool Dispatch(const char *Topic, const char *Payload)
+            {
+                uint32_t const hash = Hash(Topic);
+                for (int slot = hash & (_indexSize - 1); _index[slot] >= 0; slot = (slot + 1) & (_indexSize - 1))
+                {
+                    Entry &entry = _entries[_index[slot]];
+                    if ((entry._hash == hash) && (strcmp(entry._topic, Topic) == 0))
+                    {
+                        entry._perf.Start();
+                        (*entry._handler)(Payload);
+                        entry._perf.Stop();
+                        return true;
+                    }
+                }
+                _unmatched++;
+                return false;
+            }
+
+            int GetCount() const { return _entries.Size(); }
+            const char *GetTopic(int Index) const { return _entries[Index]._topic; }
+
+            void PrintStats(Stream &ToStream, int IndentBy = 0)
+            {
+                for (Entry &entry : _entries)
+                {
+                    uint32_t const dispatches = (uint32_t)entry._perf.TotalSamples();
+                    printf(ToStream, "%*s%s: %u dispatches\n", IndentBy, "", entry._topic, dispatches);
+                    if (dispatches != 0)
+                    {
+                        entry._perf.Print(ToStream, IndentBy + 4);
+                    }
+                }
+                printf(ToStream, "%*sUnmatched topics: %u\n", IndentBy, "", _unmatched);
+            }
+
+            void ResetStats()
+            {
+                for (Entry &entry : _entries)
+                {
+                    entry._perf.Reset();
+                }
+                _unmatched = 0;
+            }
+        };
+        TopicDispatcher topicDispatcher;
+
+        //* Receive arena - incoming payloads are read here (never onto the stack) and handlers parse them in place
+        char        rxPayload[SPA_MQTT_MAX_PAYLOAD + 1];
+        uint32_t    rxLargestPayload;
+        uint32_t    rxOversizeDrops;
+        uint32_t    rxShortReads;
+
         //* Flash store for MQTT configuration
         FlashStore<HA_MqttConfig, PS_MQTTBrokerConfigBase> mqttConfig;
             static_assert(PS_MQTTBrokerConfigBlkSize >= sizeof(FlashStore<HA_MqttConfig, PS_MQTTBrokerConfigBase>));
+
+        //* The discovery fingerprint for the configured broker - another broker does not hold the retained messages
+        uint32_t BrokerDiscoveryFingerprint()
+        {
+            uint32_t const brokerIP = mqttConfig.GetRecord()._brokerIP;
+            uint16_t const brokerPort = mqttConfig.GetRecord()._brokerPort;
+
+            CrcPrinter fingerprint;
+            fingerprint.write((uint8_t const *)&discoveryFingerprint, sizeof(discoveryFingerprint));
+            fingerprint.write((uint8_t const *)&brokerIP, sizeof(brokerIP));
+            fingerprint.write((uint8_t const *)&brokerPort, sizeof(brokerPort));
+            return fingerprint.GetCrc();
+        }
+
+        //* Upgrade a record written by an earlier layout - each is a prefix of the current one with its CRC right after
+        //  its last field. Fields past the prefix get their defaults. Returns true if the record was upgraded and
+        //  rewritten.
+        bool MigrateConfig()
+        {
+            static constexpr size_t legacySizes[] =
+            {
+                offsetof(HA_MqttConfig, _publishPolicy),            // before publish policies
+                offsetof(HA_MqttConfig, _discoveryFingerprint)      // before the discovery fingerprint
+            };
+            uint8_t const* bytes = (uint8_t const*)&mqttConfig.GetRecord();
+
+            for (size_t legacySize : legacySizes)
+            {
+                uint32_t legacyCrc;
+                memcpy(&legacyCrc, &bytes[legacySize], sizeof(legacyCrc));
+
+                Arduino_CRC32 crc;
+                if (crc.calc(bytes, legacySize) == legacyCrc)
+                {
+                    if (legacySize <= offsetof(HA_MqttConfig, _publishPolicy))
+                    {
+                        mqttConfig.GetRecord().SetDefaultPublishPolicies();
+                    }
+                    mqttConfig.GetRecord()._discoveryFingerprint = 0;
+                    mqttConfig.Write();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        //* Publish policy state and statistics per PublishItem
+        struct PublishState
+        {
+            float       _published;             // value last published
+            uint64_t    _publishedAt;           // ms; 0: never published
+            uint32_t    _sent;
+            uint32_t    _suppressed;            // changed values held back by the deadband or min interval - each once
+            float       _held;                  // last value counted in _suppressed
+            bool        _isHolding;             // _held is valid - cleared by each publish
+        };
+        PublishState publishStates[(int)PublishItem::Count];
+
+        //* Last value queued per PublishItem while offline - kept apart from publishStates so capturing neither moves
+        //  the live publish baseline nor counts as sent or suppressed
+        struct CaptureState
+        {
+            float       _captured;
+            uint64_t    _capturedAt;            // ms; 0: nothing to compare against - capture the next value
+        };
+        CaptureState captureStates[(int)PublishItem::Count];
+
+        //* Store and forward queue of property changes captured while offline. The newest records are in RAM; when
+        //  that is full the oldest move to the flash spill (if configured) and when that is full the oldest are
+        //  dropped. Spilled records are older than any in RAM so replay drains the spill first. The spill's indexes
+        //  are RAM only - it does not survive a reboot.
+        class ForwardQueue
+        {
+        public:
+            #pragma pack(push, 1)
+            struct Record
+            {
+                uint32_t    _monotonicSecs;         // when captured
+                float       _value;
+                uint8_t     _item;                  // PublishItem
+            };
+            #pragma pack(pop)
+
+            struct Stats
+            {
+                uint32_t    _captured;
+                uint32_t    _replayed;
+                uint32_t    _spilled;
+                uint32_t    _dropped;
+                uint16_t    _highWater;
+            };
+
+        private:
+            static constexpr int _ramCapacity = SPA_MQTT_FORWARD_DEPTH;
+            static constexpr int _spillCapacity = PS_MqttSpillSize / sizeof(Record);
+            static constexpr int _spillModulus = (_spillCapacity > 0) ? _spillCapacity : 1;     // no spill: never used
+
+            Record      _ram[_ramCapacity];
+            uint16_t    _ramHead;                   // oldest
+            uint16_t    _ramCount;
+            uint16_t    _spillHead;
+            uint16_t    _spillCount;
+            Stats       _stats;
+
+            static uint16_t SpillAddress(int Index) { return PS_MqttSpillBase + ((Index % _spillModulus) * sizeof(Record)); }
+
+        public:
+            ForwardQueue() : _ramHead(0), _ramCount(0), _spillHead(0), _spillCount(0) { ResetStats(); }
+
+            void Push(Record const &ToQueue)
+            {
+                if (_ramCount == _ramCapacity)
+                {
+                    Record const &oldest = _ram[_ramHead];
+                    if (_spillCapacity > 0)
+                    {
+                        if (_spillCount == _spillCapacity)
+                        {
+                            _spillHead = (_spillHead + 1) % _spillModulus;
+                            _spillCount--;
+                            _stats._dropped++;
+                        }
+                        EEPROM.put(SpillAddress(_spillHead + _spillCount), oldest);
+                        _spillCount++;
+                        _stats._spilled++;
+                    }
+                    else
+                    {
+                        _stats._dropped++;
+                    }
+                    _ramHead = (_ramHead + 1) % _ramCapacity;
+                    _ramCount--;
+                }
+
+                _ram[(_ramHead + _ramCount) % _ramCapacity] = ToQueue;
+                _ramCount++;
+                _stats._captured++;
+                if (GetDepth() > _stats._highWater)
+                {
+                    _stats._highWater = GetDepth();
+                }
+            }
+
+            //* Oldest record - false if empty
+            bool Peek(Record &Oldest)
+            {
+                if (_spillCount != 0)
+                {
+                    EEPROM.get(SpillAddress(_spillHead), Oldest);
+                    return true;
+                }
+                if (_ramCount != 0)
+                {
+                    Oldest = _ram[_ramHead];
+                    return true;
+                }
+                return false;
+            }
+
+            void Pop()
+            {
+                if (_spillCount != 0)
+                {
+                    _spillHead = (_spillHead + 1) % _spillModulus;
+                    _spillCount--;
+                }
+                else if (_ramCount != 0)
+                {
+                    _ramHead = (_ramHead + 1) % _ramCapacity;
+                    _ramCount--;
+                }
+                else
+                {
+                    return;
+                }
+                _stats._replayed++;
+            }
+
+            bool IsEmpty() const { return (_ramCount + _spillCount) == 0; }
+            uint16_t GetDepth() const { return _ramCount + _spillCount; }
+            int GetCapacity() const { return _ramCapacity + _spillCapacity; }
+            Stats const &GetStats() const { return _stats; }
+            void ResetStats() { memset(&_stats, 0, sizeof(_stats)); }
+        };
+        ForwardQueue forwardQueue;
+
+        //* Apply Item's policy to its current Value - returns true if it should be published now (and records that)
+        bool ShouldPublish(PublishItem Item, float Value, bool Force)
+        {
+            HA_MqttConfig::PublishPolicy const &policy = mqttConfig.GetRecord()._publishPolicy[(int)Item];
+            PublishState &state = publishStates[(int)Item];
+            uint64_t const now = MonotonicClock::NowInMSecs();
+            uint64_t const sinceLast = now - state._publishedAt;
+
+            bool publish = Force || (state._publishedAt == 0);
+            if (!publish)
+            {
+                bool const changed = (policy._deadband > 0) ? (fabsf(Value - state._published) >= policy._deadband) : (Value != state._published);
+                if (changed)
+                {
+                    publish = (sinceLast >= (policy._minIntervalInSecs * 1000ULL));
+                }
+                else
+                {
+                    publish = (policy._maxIntervalInSecs != 0) && (sinceLast >= (policy._maxIntervalInSecs * 1000ULL));
+                }
+
+                // Checked every second - a held value is counted once, not each time it is checked
+                if (!publish && (Value != state._published) && (!state._isHolding || (Value != state._held)))
+                {
+                    state._suppressed++;
+                    state._held = Value;
+                    state._isHolding = true;
+                }
+            }
+
+            if (publish)
+            {
+                state._published = Value;
+                state._publishedAt = (now != 0) ? now : 1;
+                state._sent++;
+                state._isHolding = false;
+            }
+            return publish;
+        }
+
+        //* Apply Item's deadband and min interval to a Value sampled while offline - true if it should be queued (and
+        //  records that). There is no heartbeat: an unchanged value is never queued.
+        bool ShouldCapture(PublishItem Item, float Value)
+        {
+            HA_MqttConfig::PublishPolicy const &policy = mqttConfig.GetRecord()._publishPolicy[(int)Item];
+            CaptureState &state = captureStates[(int)Item];
+            uint64_t const now = MonotonicClock::NowInMSecs();
+
+            if (state._capturedAt != 0)
+            {
+                bool const changed = (policy._deadband > 0) ? (fabsf(Value - state._captured) >= policy._deadband) : (Value != state._captured);
+                if (!changed || ((now - state._capturedAt) < (policy._minIntervalInSecs * 1000ULL)))
+                {
+                    return false;
+                }
+            }
+
+            state._captured = Value;
+            state._capturedAt = (now != 0) ? now : 1;
+            return true;
+        }
+
+        //* While offline, capture property changes (as their deadband and min interval allow) for replay once
+        //  reconnected. IsFirst starts an outage - changes are then relative to what was last published.
+        void CaptureOfflineChanges(bool IsFirst)
+        {
+            static Timer timer;
+            if (IsFirst)
+            {
+                for (int ix = 0; ix < (int)PublishItem::Count; ix++)
+                {
+                    captureStates[ix]._captured = publishStates[ix]._published;
+                    captureStates[ix]._capturedAt = publishStates[ix]._publishedAt;
+                }
+                timer.SetAlarm(1000);
+            }
+            if (!timer.IsAlarmed())
+            {
+                return;
+            }
+            timer.SetAlarm(1000);
+
+            BoilerControllerTask::TempertureState tempState;
+            BoilerControllerTask::TargetTemps targetTemps;
+            boilerControllerTask.GetTempertureState(tempState);
+            boilerControllerTask.GetTargetTemps(targetTemps);
+
+            float values[(int)PublishItem::Count];
+            values[(int)PublishItem::BoilerInTemp] = tempState._boilerInTemp;
+            values[(int)PublishItem::BoilerOutTemp] = tempState._boilerOutTemp;
+            values[(int)PublishItem::AmbientTemp] = tempState._ambiantTemp;
+            values[(int)PublishItem::Hysterisis] = tempState._hysteresis;
+            values[(int)PublishItem::SetPoint] = targetTemps._setPoint;
+            values[(int)PublishItem::HeaterState] = tempState._heaterOn ? 1.0 : 0.0;
+            values[(int)PublishItem::BoilerState] = (float)(int)boilerControllerTask.GetStateMachineState();
+            values[(int)PublishItem::FaultReason] = (float)(int)boilerControllerTask.GetFaultReason();
+            values[(int)PublishItem::BoilerMode] = (float)(int)boilerControllerTask.GetMode();
+
+            uint32_t const now = (uint32_t)(MonotonicClock::NowInMSecs() / 1000);
+            for (int ix = 0; ix < (int)PublishItem::Count; ix++)
+            {
+                if (ShouldCapture((PublishItem)ix, values[ix]))
+                {
+                    forwardQueue.Push(ForwardQueue::Record{now, values[ix], (uint8_t)ix});
+                }
+            }
+        }
+
+        //* Print a property value as published (°F, or the state/mode description)
+        void PrintPropertyValue(Stream &ToStream, PublishItem Item, float Value)
+        {
+            switch (Item)
+            {
+                case PublishItem::BoilerInTemp:
+                case PublishItem::BoilerOutTemp:
+                case PublishItem::AmbientTemp:
+                case PublishItem::SetPoint:
+                    printf(ToStream, "%0.2f", $CtoF(Value));
+                    break;
+                case PublishItem::Hysterisis:
+                    printf(ToStream, "%0.2f", $CDiffToF(Value));
+                    break;
+                case PublishItem::HeaterState:
+                    printf(ToStream, "\"%s\"", (Value != 0) ? "On" : "Off");
+                    break;
+                case PublishItem::BoilerState:
+                    printf(ToStream, "\"%s\"", BoilerControllerTask::GetStateMachineStateDescription((BoilerControllerTask::StateMachineState)(int)Value));
+                    break;
+                case PublishItem::FaultReason:
+                    printf(ToStream, "\"%s\"", BoilerControllerTask::GetFaultReasonDescription((BoilerControllerTask::FaultReason)(int)Value));
+                    break;
+                case PublishItem::BoilerMode:
+                    printf(ToStream, "\"%s\"", BoilerControllerTask::GetBoilerModeDescription((BoilerControllerTask::BoilerMode)(int)Value));
+                    break;
+                default:
+                    $FailFast();
+            }
+        }
     } // namespace HA_Mqtt
 } // namespace TinyBus
 
@@ -468,7 +1150,7 @@ CmdLine::Status ShowMqttConfig(Stream &CmdStream, int Argc, char const **Args, v
     }
 
     printf(CmdStream, "MQTT Broker IP: %s; Port#: %d\n",
-           IPAddress(mqttConfig.GetRecord()._brokerIP).toString().c_str(),
+           NetworkTask::IPToString(IPAddress(mqttConfig.GetRecord()._brokerIP)).c_str(),
            mqttConfig.GetRecord()._brokerPort);
     printf(CmdStream, "Client ID: '%s'; Username: '%s'; Password: '%s'\n",
            mqttConfig.GetRecord()._clientId,
@@ -521,11 +1203,13 @@ CmdLine::Status SetConfigVar(Stream &CmdStream, int Argc, char const **Args, voi
     if (strcmp(Args[1], "ip") == 0)
     {
         mqttConfig.GetRecord()._brokerIP = IPAddress(Args[2]);
+        mqttConfig.GetRecord()._discoveryFingerprint = 0;        // resend discovery
         mqttConfig.Write();
     }
     else if (strcmp(Args[1], "port") == 0)
     {
         mqttConfig.GetRecord()._brokerPort = atoi(Args[2]);
+        mqttConfig.GetRecord()._discoveryFingerprint = 0;        // resend discovery
         mqttConfig.Write();
     }
     else if (strcmp(Args[1], "id") == 0)
@@ -546,11 +1230,13 @@ CmdLine::Status SetConfigVar(Stream &CmdStream, int Argc, char const **Args, voi
     else if (strcmp(Args[1], "topic") == 0)
     {
         strncpy(mqttConfig.GetRecord()._baseHATopic, Args[2], sizeof(mqttConfig.GetRecord()._baseHATopic));
+        mqttConfig.GetRecord()._discoveryFingerprint = 0;        // resend discovery
         mqttConfig.Write();
     }
     else if (strcmp(Args[1], "name") == 0)
     {
         strncpy(mqttConfig.GetRecord()._haDeviceName, Args[2], sizeof(mqttConfig.GetRecord()._haDeviceName));
+        mqttConfig.GetRecord()._discoveryFingerprint = 0;        // resend discovery
         mqttConfig.Write();
     }
     else
@@ -562,9 +1248,76 @@ CmdLine::Status SetConfigVar(Stream &CmdStream, int Argc, char const **Args, voi
     return CmdLine::Status::Ok;
 }
 
+CmdLine::Status SetPublishPolicy(Stream &CmdStream, int Argc, char const **Args, void *Context)
+{
+    if ((Argc != 1) && (Argc != 5))
+    {
+        printf(CmdStream, "Usage: policy [<property> <deadband> <min secs> <max secs>]\n");
+        return CmdLine::Status::UnexpectedParameterCount;
+    }
+
+    if (Argc == 5)
+    {
+        int ix;
+        for (ix = 0; ix < (int)PublishItem::Count; ix++)
+        {
+            if (strcmp(Args[1], _publishItemNames[ix]) == 0)
+            {
+                break;
+            }
+        }
+        if (ix == (int)PublishItem::Count)
+        {
+            printf(CmdStream, "Unknown property: %s\n", Args[1]);
+            return CmdLine::Status::InvalidParameter;
+        }
+
+        char *end;
+        float const deadband = strtod(Args[2], &end);
+        if ((*end != 0) || (end == Args[2]) || !(deadband >= 0) || isinf(deadband))
+        {
+            CmdStream.println("Invalid deadband - a number >= 0");
+            return CmdLine::Status::InvalidParameter;
+        }
+
+        long intervals[2];
+        for (int argIx = 0; argIx < 2; argIx++)
+        {
+            intervals[argIx] = strtol(Args[3 + argIx], &end, 10);
+            if ((*end != 0) || (end == Args[3 + argIx]) || (intervals[argIx] < 0) || (intervals[argIx] > UINT16_MAX))
+            {
+                CmdStream.println("Invalid interval - secs from 0 to 65535");
+                return CmdLine::Status::InvalidParameter;
+            }
+        }
+        if ((intervals[1] != 0) && (intervals[0] > intervals[1]))
+        {
+            CmdStream.println("Invalid intervals - min secs is more than max secs");
+            return CmdLine::Status::InvalidParameter;
+        }
+
+        HA_MqttConfig::PublishPolicy &policy = mqttConfig.GetRecord()._publishPolicy[ix];
+        policy._deadband = deadband;
+        policy._minIntervalInSecs = intervals[0];
+        policy._maxIntervalInSecs = intervals[1];
+        mqttConfig.Write();
+    }
+
+    printf(CmdStream, "Property  Deadband  Min secs  Max secs\n");
+    for (int ix = 0; ix < (int)PublishItem::Count; ix++)
+    {
+        HA_MqttConfig::PublishPolicy const &policy = mqttConfig.GetRecord()._publishPolicy[ix];
+        printf(CmdStream, "%-8s  %8.2f  %8u  %8u\n",
+               _publishItemNames[ix], policy._deadband, policy._minIntervalInSecs, policy._maxIntervalInSecs);
+    }
+
+    return CmdLine::Status::Ok;
+}
+
 CmdLine::ProcessorDesc haMqttCmdProcessors[] =
     {
         {SetConfigVar, "set", "Set a MQTT/HA configuration variables - set <var> <value> -or- set ? for help"},
+        {SetPublishPolicy, "policy", "Show or set a property's publish policy - policy [<property> <deadband> <min secs> <max secs>]"},
         {EraseMqttConfig, "erase", "Erase the current MQTT/HA configuration"},
         {ShowMqttConfig, "show", "Show the current MQTT configuration"},
         {ExitConfigHAMqtt, "exit", "Exit to parent menu"},
@@ -574,17 +1327,81 @@ int const LengthOfHaMqttCmdProcessors = sizeof(haMqttCmdProcessors) / sizeof(haM
 
 
 
+//** HA_MqttClient class implementation - incoming topic dispatch statistics
+void HA_MqttClient::PrintDispatchStats(Stream &ToStream, int IndentBy)
+{
+    topicDispatcher.PrintStats(ToStream, IndentBy);
+    printf(ToStream, "%*sReceive: largest payload: %u of %u; oversize drops: %u; short reads: %u\n", IndentBy, "",
+           rxLargestPayload, SPA_MQTT_MAX_PAYLOAD, rxOversizeDrops, rxShortReads);
+}
+
+void HA_MqttClient::ResetDispatchStats()
+{
+    topicDispatcher.ResetStats();
+    rxLargestPayload = 0;
+    rxOversizeDrops = 0;
+    rxShortReads = 0;
+}
+
+void HA_MqttClient::PrintPublishStats(Stream &ToStream, int IndentBy)
+{
+    for (int ix = 0; ix < (int)PublishItem::Count; ix++)
+    {
+        printf(ToStream, "%*s%-6s sent: %u; suppressed: %u\n", IndentBy, "",
+               _publishItemNames[ix], publishStates[ix]._sent, publishStates[ix]._suppressed);
+    }
+
+    ForwardQueue::Stats const &stats = forwardQueue.GetStats();
+    printf(ToStream, "%*sStore and forward: depth: %u of %d (high water: %u); captured: %u; replayed: %u; spilled: %u; dropped: %u\n",
+           IndentBy, "", forwardQueue.GetDepth(), forwardQueue.GetCapacity(), stats._highWater,
+           stats._captured, stats._replayed, stats._spilled, stats._dropped);
+}
+
+void HA_MqttClient::PrintConnectStats(Stream &ToStream, int IndentBy)
+{
+    printf(ToStream, "%*sConnects: %u; discovery skipped (unchanged): %u; fingerprint: %08X\n", IndentBy, "",
+           connectStats._connects, connectStats._discoverySkipped, BrokerDiscoveryFingerprint());
+    if (connectStats._maxToOnlineInMs != 0)
+    {
+        printf(ToStream, "%*sConnect to online: last: %ums; min: %ums; max: %ums\n", IndentBy, "",
+               connectStats._lastToOnlineInMs, connectStats._minToOnlineInMs, connectStats._maxToOnlineInMs);
+    }
+    printf(ToStream, "%*sHA births (session kept): %u", IndentBy, "", connectStats._haBirths);
+    if (connectStats._haBirths != 0)
+    {
+        printf(ToStream, "; birth to online: last: %ums; max: %ums",
+               connectStats._lastBirthToOnlineInMs, connectStats._maxBirthToOnlineInMs);
+    }
+    printf(ToStream, "\n");
+}
+
+void HA_MqttClient::ResetPublishStats()
+{
+    for (PublishState &state : publishStates)
+    {
+        state._sent = 0;
+        state._suppressed = 0;
+    }
+    forwardQueue.ResetStats();
+}
+
+
 //** HA_MqttClient class implementation - Setup for the MQTT client task. 
 //   This function is called from the main setup() function
 void HA_MqttClient::setup()
 {
-    logger.Printf(Logger::RecType::Progress, "mqttClientTask: starting");
+    $Log(MQTT, Progress, "mqttClientTask: starting");
 
     // Initialize the MQTT configuration - if not already initialized
     mqttConfig.Begin();
+    if (!mqttConfig.IsValid() && MigrateConfig())
+    {
+        $Log(MQTT, Warning, "MQTT: Config upgraded - new fields set to defaults");
+    }
+
     if (!mqttConfig.IsValid())
     {
-        logger.Printf(Logger::RecType::Warning, "MQTT: Config not valid - initializing to defaults");
+        $Log(MQTT, Warning, "MQTT: Config not valid - initializing to defaults");
         mqttConfig.GetRecord()._brokerIP = (uint32_t)(IPAddress(192, 168, 3, 48));
         mqttConfig.GetRecord()._brokerPort = 1883;
         strcpy(mqttConfig.GetRecord()._clientId, "SpaHeater");
@@ -592,6 +1409,8 @@ void HA_MqttClient::setup()
         strcpy(mqttConfig.GetRecord()._password, "mqttpassword");
         strcpy(mqttConfig.GetRecord()._baseHATopic, _defaultBaseTopic);
         strcpy(mqttConfig.GetRecord()._haDeviceName, _defaultDeviceName);
+        mqttConfig.GetRecord().SetDefaultPublishPolicies();
+        mqttConfig.GetRecord()._discoveryFingerprint = 0;
 
         mqttConfig.Write();
         mqttConfig.Begin();
@@ -599,51 +1418,68 @@ void HA_MqttClient::setup()
     }
     else
     {
-        logger.Printf(Logger::RecType::Progress, "MQTT: Config valid");
+        $Log(MQTT, Progress, "MQTT: Config valid");
     }
 
     //** Build all expanded topic strings and compute sizes of the expanded HA entity /config JSON strings
     $Assert(mqttConfig.IsValid());
 
-    PrintOutputCounter counter;
-
-    //* Build the common avail topic string
-    int sizeNeeded = ExpandJson(counter, _commonAvailTopicTemplate, mqttConfig.GetRecord()._haDeviceName) + 1;
-    commonAvailTopic = new char[sizeNeeded];
-    $Assert(commonAvailTopic != nullptr);
+    //* Helper to build expanded topic strings (with an optional suffix) into the topic arena - the size is known up
+    //  front so each is expanded exactly once
+    static auto BuildTopicString = [](
+        HaTopicJsonTemplate Template,
+        char *&Result,
+        const char *Arg0,
+        const char *Arg1 = "",
+        const char *Suffix = "",
+        const char *Arg2 = "") -> int
+    {
+        size_t size = Template.Size(Arg0, Arg1, Arg2) + strlen(Suffix);
+        $Assert(size > 0);
 
-    BufferPrinter printer(commonAvailTopic, sizeNeeded);
-    $Assert(ExpandJson(printer, _commonAvailTopicTemplate, mqttConfig.GetRecord()._haDeviceName) == (sizeNeeded - 1));
-    $Assert(strlen(commonAvailTopic) == (sizeNeeded - 1));
+        Result = topicArena.Carve(size + 1); // Leave room for null terminator
+        if (Result != nullptr)
+        {
+            BufferPrinter printer(Result, size);
+            Template.Expand(printer, Arg0, Arg1, Arg2);
+            printer.write((const uint8_t *)Suffix, strlen(Suffix));
+            $Assert(printer.GetSize() == size);
+        }
+        return size;
+    };
 
-    //* Helper to build expanded topic strings
-    static auto BuildTopicString = [](
-        const char &Template, 
-        char *&Result, 
-        const char *BaseTopic, 
-        const char *EntityName) -> int
+    //* Every topic string - run once to size the arena and once to fill it
+    static auto BuildAllTopicStrings = []()
     {
-        PrintOutputCounter counter;
-        size_t size = ExpandJson(counter, &Template, BaseTopic, EntityName); // Get size of expanded string
-        $Assert(size > 0);                                                   // Error in template
+        HA_MqttConfig const &config = mqttConfig.GetRecord();
 
-        Result = new char[size + 1]; // Leave room for null terminator
-        $Assert(Result != nullptr);  // Out of memory
-        BufferPrinter printer(Result, size);
+        BuildTopicString(_commonAvailTopicJson, commonAvailTopic, config._haDeviceName);
+        BuildTopicString(_logTopicJson, logTopic, config._haDeviceName);
+        BuildTopicString(_diagTopicJson, diagTopic, config._haDeviceName);
+        BuildTopicString(_stateTopicJson, stateTopic, config._haDeviceName);
+        BuildTopicString(_topicJoinJson, haIntgStatusTopic, config._baseHATopic, _haIntgAvailSuffix);
+        BuildTopicString(_commandWildcardTopicJson, commandWildcardTopic, config._haDeviceName);
 
-        $Assert(ExpandJson(printer, &Template, BaseTopic, EntityName) == size); // Expand template into buffer
-        return size;
+        for (int i = 0; i < _entityDescCount; i++)
+        {
+            HaEntityDesc &desc = _entityDescs[i];
+            BuildTopicString(desc._BaseTopicJsonTemplate, *desc._BaseTopicResult, config._baseHATopic, desc._EntityName);
+        }
+
+        for (int i = 0; i < _propertyTopicDescCount; i++)
+        {
+            HaPropertyTopicDesc &desc = _propertyTopicDescs[i];
+            BuildTopicString(
+                desc._BaseTopicJsonTemplate, *desc._TopicResult, config._baseHATopic, desc._EntityName, desc._PropertySuffix, config._haDeviceName);
+        }
     };
 
-    //* Build each topic base string
-    for (int i = 0; i < _entityDescCount; i++)
+    if (!topicArena.IsAllocated())
     {
-        HaEntityDesc &desc = _entityDescs[i];
-        BuildTopicString(
-            *desc._BaseTopicJsonTemplate, 
-            *desc._BaseTopicResult, 
-            mqttConfig.GetRecord()._baseHATopic, 
-            desc._EntityName);
+        BuildAllTopicStrings();         // sizing pass
+        topicArena.Allocate();
+        BuildAllTopicStrings();
+        $Log(MQTT, Progress, "MQTT: Topic arena: %d bytes", (int)topicArena.GetSize());
     }
 
     //* Compute sizes of the expanded HA entity /config JSON strings - this allows the use of a streaming for of
@@ -653,15 +1489,35 @@ void HA_MqttClient::setup()
     {
         HaEntityDesc &desc = _entityDescs[i];
 
-        *desc._ExpandedMsgSizeResult = ExpandJson(
-            counter,
-            desc._ConfigJsonTemplate,
+        *desc._ExpandedMsgSizeResult = desc._ConfigJsonTemplate.Size(
             mqttConfig.GetRecord()._baseHATopic,
             mqttConfig.GetRecord()._haDeviceName,
             desc._EntityName,
-            commonAvailTopic);
+            commonAvailTopic,
+            stateTopic,
+            desc._StateKey);
         $Assert(*desc._ExpandedMsgSizeResult > 0);
     }
+
+    //* Fingerprint the discovery messages as they will be sent
+    CrcPrinter fingerprint;
+    for (int i = 0; i < _entityDescCount; i++)
+    {
+        HaEntityDesc &desc = _entityDescs[i];
+
+        $Assert(_topicJoinJson.Size(*desc._BaseTopicResult, _haConfig) <= MaxTopicLen);
+        _topicJoinJson.Expand(fingerprint, *desc._BaseTopicResult, _haConfig);
+        desc._ConfigJsonTemplate.Expand(
+            fingerprint,
+            mqttConfig.GetRecord()._baseHATopic,
+            mqttConfig.GetRecord()._haDeviceName,
+            desc._EntityName,
+            commonAvailTopic,
+            stateTopic,
+            desc._StateKey);
+    }
+    discoveryFingerprint = fingerprint.GetCrc();
+    $Log(MQTT, Progress, "MQTT: Discovery fingerprint: %08X", discoveryFingerprint);
 }
 
 
@@ -672,67 +1528,54 @@ void HA_MqttClient::loop()
     //** local support functions for the state machine
 
     //* Common beginMessage() function with topic expansion for all messages
-    static auto BeginMessage = [](MqttClient &MqttClient, const char *TopicPrefix, const char *Suffix, uint32_t ExpandedMsgSize = 0xffffffffL) -> int
+    static auto BeginMessage = [](MqttClient &MqttClient, const char *TopicPrefix, const char *Suffix, uint32_t ExpandedMsgSize = 0xffffffffL, bool Retain = false) -> int
     {
-        int status;
-        {
-            //* We use the shared buffer to build the full topic string and start the message
-            auto handle = sharedPrintfBuffer.GetHandle(); // take lock on shared buffer
-            char *buffer = (char *)handle.GetBuffer();
-            BufferPrinter printer(buffer, handle.GetSize()); // create a buffer printer into the shared buffer
-
-            size_t size = ExpandJson(printer, "%0%1", TopicPrefix, Suffix); // Append the /config topic suffix to the base topic
-            $Assert(size < sharedPrintfBuffer.GetSize());
+        //* The topic is built on the stack, not in the shared buffer - beginMessage(, MsgSize) sends the header to
+        //  the network at once, and the shared buffer must not be held across network writes
+        char topic[MaxTopicLen + 1];
+        BufferPrinter printer(topic, MaxTopicLen);
 
-            // Begin the message with the expanded topic string + /config
-            status = MqttClient.beginMessage((const char *)buffer, ExpandedMsgSize); // note: this form of beginMessage(, MsgSize) is used to avoid
-                                                                                     // the need to allocate a larger buffer for the JSON string
-        }
+        size_t size = _topicJoinJson.Expand(printer, TopicPrefix, Suffix); // Append the /config topic suffix to the base topic
+        $Assert(size <= MaxTopicLen);
 
-        return status;
+        // Begin the message with the expanded topic string + /config
+        return MqttClient.beginMessage((const char *)topic, ExpandedMsgSize, Retain); // note: this form of beginMessage(, MsgSize) is used to avoid
+                                                                                      // the need to allocate a larger buffer for the JSON string
     };
 
-    //* Send a /config JSON message to Home Assistant for a given entity (topic)
+    //* Send a /config JSON message to Home Assistant for a given entity (topic) - retained, so the broker hands it to
+    //  Home Assistant whenever it (re)starts
     static auto SendConfigJSON = [](
         MqttClient &MqttClient,
         const char *BaseTopic,
         const char *BaseEntityTopic,
         const char *DeviceName,
         const char *EntityName,
-        const char *ConfigJsonPrototype,
+        const char *StateKey,
+        HaConfigJsonTemplate ConfigJsonPrototype,
         uint32_t ExpandedMsgSize) -> bool
     {
-        int status = BeginMessage(MqttClient, BaseEntityTopic, _haConfig, ExpandedMsgSize);
+        int status = BeginMessage(MqttClient, BaseEntityTopic, _haConfig, ExpandedMsgSize, true);     // retained
         if (!status)
         {
-            logger.Printf(Logger::RecType::Warning, "MQTT: Failed to begin message");
+            $LogLimited(MQTT, Warning, "MQTT: Failed to begin message");
             return false;
         }
 
-        size_t expandedSize;
-        {
-            //* We use the shared buffer to build the full /config JSON string and start the message
-            auto handle = sharedPrintfBuffer.GetHandle(); // take lock on shared buffer
-            char *buffer = (char *)handle.GetBuffer();
-            BufferPrinter printer(buffer, handle.GetSize()); // create a buffer printer into the shared buffer
-
-            size_t size = ExpandJson(printer, ConfigJsonPrototype, BaseTopic, DeviceName, EntityName, commonAvailTopic); // Append the /config topic suffix to the base topic
-            $Assert(size < sharedPrintfBuffer.GetSize());
-
-            // Write the expanded /config message body JSON string directly into the message stream
-            expandedSize = MqttClient.write((const uint8_t *)buffer, size);
-        }
+        // Expand the /config message body JSON string directly into the message stream - no shared buffer is held
+        // across the network writes, which would block every other thread's logging behind the WiFi modem
+        size_t const expandedSize = ConfigJsonPrototype.Expand(MqttClient, BaseTopic, DeviceName, EntityName, commonAvailTopic, stateTopic, StateKey);
 
         if (expandedSize != ExpandedMsgSize)
         {
-            logger.Printf(Logger::RecType::Warning, "MQTT: Expanded size of /config message body JSON string is incorrect");
+            $LogLimited(MQTT, Warning, "MQTT: Expanded size of /config message body JSON string is incorrect");
             return false;
         }
 
         status = MqttClient.endMessage();
         if (!status)
         {
-            logger.Printf(Logger::RecType::Warning, "MQTT: endMessage() failed");
+            $LogLimited(MQTT, Warning, "MQTT: endMessage() failed");
             return false;
         }
 
@@ -742,41 +1585,40 @@ void HA_MqttClient::loop()
    //* Send a /avail message to Home Assistant
     static auto SendOnlineAvailMsg = [](MqttClient &MqttClient) -> bool
     {
-        int status = MqttClient.beginMessage(commonAvailTopic);
+        int status = MqttClient.beginMessage(commonAvailTopic, (uint32_t)strlen(_availOnlinePayload), true);    // retained - replaces the will
         if (!status)
         {
-            logger.Printf(Logger::RecType::Warning, "MQTT: Failed to begin message");
+            $LogLimited(MQTT, Warning, "MQTT: Failed to begin message");
             return false;
         }
 
-        size_t size = MqttClient.print("\"online\"");
+        size_t size = MqttClient.print(_availOnlinePayload);
         if (size == 0)
         {
-            logger.Printf(Logger::RecType::Warning, "MQTT: Failed to write /avail message body JSON string");
+            $LogLimited(MQTT, Warning, "MQTT: Failed to write /avail message body JSON string");
             return false;
         }
 
         status = MqttClient.endMessage();
         if (!status)
         {
-            logger.Printf(Logger::RecType::Warning, "MQTT: endMessage() failed");
+            $LogLimited(MQTT, Warning, "MQTT: endMessage() failed");
             return false;
         }
 
         return true;
     };
 
-    //* Send a float property message to Home Assistant for a given entity
+    //* Send a float property message to Home Assistant on a prebuilt property topic
     static auto SendPropertyMsg = [](
         MqttClient &MqttClient,
-        const char *BaseEntityTopic,
-        const char *PropertyName,
+        const char *PropertyTopic,
         float       PropertyValue) -> bool
     {
-        int status = BeginMessage(MqttClient, BaseEntityTopic, PropertyName);
+        int status = MqttClient.beginMessage(PropertyTopic);
         if (!status)
         {
-            logger.Printf(Logger::RecType::Warning, "MQTT: SendPropertyMsg: Failed to begin message");
+            $LogLimited(MQTT, Warning, "MQTT: SendPropertyMsg: Failed to begin message");
             return false;
         }
 
@@ -784,31 +1626,30 @@ void HA_MqttClient::loop()
         size_t size = printf(MqttClient, "%0.2f", PropertyValue);
         if (size == 0)
         {
-            logger.Printf(Logger::RecType::Warning, "MQTT: SendPropertyMsg: Failed to write property message body JSON string");
+            $LogLimited(MQTT, Warning, "MQTT: SendPropertyMsg: Failed to write property message body JSON string");
             return false;
         }
 
         status = MqttClient.endMessage();
         if (!status)
         {
-            logger.Printf(Logger::RecType::Warning, "MQTT: SendPropertyMsg: endMessage() failed");
+            $LogLimited(MQTT, Warning, "MQTT: SendPropertyMsg: endMessage() failed");
             return false;
         }
 
         return true;
     };
 
-    //* Send a string property message to Home Assistant for a given entity
+    //* Send a string property message to Home Assistant on a prebuilt property topic
     static auto SendPropertyMsgStr = [](
         MqttClient &MqttClient,
-        const char *BaseEntityTopic,
-        const char *PropertyName,
+        const char *PropertyTopic,
         const char *PropertyValue) -> bool
     {
-        int status = BeginMessage(MqttClient, BaseEntityTopic, PropertyName);
+        int status = MqttClient.beginMessage(PropertyTopic);
         if (!status)
         {
-            logger.Printf(Logger::RecType::Warning, "MQTT: SendPropertyMsg: Failed to begin message");
+            $LogLimited(MQTT, Warning, "MQTT: SendPropertyMsg: Failed to begin message");
             return false;
         }
 
@@ -816,22 +1657,172 @@ void HA_MqttClient::loop()
         size_t size = printf(MqttClient, "\"%s\"", PropertyValue);
         if (size == 0)
         {
-            logger.Printf(Logger::RecType::Warning, "MQTT: SendPropertyMsg: Failed to write property message body JSON string");
+            $LogLimited(MQTT, Warning, "MQTT: SendPropertyMsg: Failed to write property message body JSON string");
             return false;
         }
 
         status = MqttClient.endMessage();
         if (!status)
         {
-            logger.Printf(Logger::RecType::Warning, "MQTT: SendPropertyMsg: endMessage() failed");
+            $LogLimited(MQTT, Warning, "MQTT: SendPropertyMsg: endMessage() failed");
             return false;
         }
 
         return true;
     };
     
+    //* Send the JSON state document - every property in one message. The field names are the state keys the
+    //  /config templates reference (see $HaValueTemplate)
+    static auto SendStateDoc = [](
+        MqttClient &MqttClient,
+        BoilerControllerTask::TempertureState const &TempState,
+        BoilerControllerTask::StateMachineState HeaterState,
+        BoilerControllerTask::FaultReason FaultReason,
+        BoilerControllerTask::BoilerMode BoilerMode,
+        BoilerControllerTask::TargetTemps const &TargetTemps) -> bool
+    {
+        int status = MqttClient.beginMessage(stateTopic);
+        if (!status)
+        {
+            $LogLimited(MQTT, Warning, "MQTT: SendStateDoc: Failed to begin message");
+            return false;
+        }
+
+        size_t size = printf(MqttClient,
+            "{\"in\":%0.2f,\"out\":%0.2f,\"amb\":%0.2f,\"hyst\":%0.2f,\"sp\":%0.2f,"
+            "\"heat\":\"%s\",\"state\":\"%s\",\"fault\":\"%s\",\"mode\":\"%s\"}",
+            $CtoF(TempState._boilerInTemp), $CtoF(TempState._boilerOutTemp), $CtoF(TempState._ambiantTemp),
+            $CDiffToF(TempState._hysteresis), $CtoF(TargetTemps._setPoint),
+            TempState._heaterOn ? "On" : "Off",
+            BoilerControllerTask::GetStateMachineStateDescription(HeaterState),
+            BoilerControllerTask::GetFaultReasonDescription(FaultReason),
+            BoilerControllerTask::GetBoilerModeDescription(BoilerMode));
+        if (size == 0)
+        {
+            $LogLimited(MQTT, Warning, "MQTT: SendStateDoc: Failed to write state document");
+            return false;
+        }
+
+        status = MqttClient.endMessage();
+        if (!status)
+        {
+            $LogLimited(MQTT, Warning, "MQTT: SendStateDoc: endMessage() failed");
+            return false;
+        }
+
+        return true;
+    };
+
+    //* Publish the record at the head of the logger's MQTT sink to the log topic - at most one record per call.
+    //  The record is consumed even if the publish fails; it is never retried.
+    static auto SendLogRecord = [](MqttClient &MqttClient) -> bool
+    {
+        Logger::Sink& sink = logger.GetSink(Logger::SinkId::MQTT);
+        uint16_t length = sink.PeekRecordLength();
+        if (length == 0)
+        {
+            return true;
+        }
+
+        uint16_t const payloadLength = length - 2;         // without the record's trailing "\r\n"
+        bool ok = MqttClient.beginMessage(logTopic, (uint32_t)payloadLength);
+
+        uint16_t offset = 0;
+        while (offset < length)
+        {
+            const uint8_t* bytes;
+            uint16_t const size = sink.Peek(bytes);
+            uint16_t const toWrite = (offset >= payloadLength) ? 0 : (((payloadLength - offset) < size) ? (payloadLength - offset) : size);
+
+            ok = ok && (MqttClient.write(bytes, toWrite) == toWrite);
+            sink.Consume(size);
+            offset += size;
+        }
+
+        return ok && MqttClient.endMessage();
+    };
+
+    //* Publish the memory usage JSON to the diag topic
+    //  - sized from a snapshot then streamed from the same snapshot, so the size sent up front is exact
+    static auto SendDiag = [](MqttClient &MqttClient) -> bool
+    {
+        MemoryMonitor::Snapshot snapshot;
+        MemoryMonitor::GetSnapshot(snapshot);
+
+        PrintOutputCounter counter;
+        int const size = MemoryMonitor::PrintJson(counter, snapshot);
+
+        return MqttClient.beginMessage(diagTopic, (uint32_t)size) && 
+               (MemoryMonitor::PrintJson(MqttClient, snapshot) == size) &&
+               MqttClient.endMessage();
+    };
+
+    //* Replay the oldest property change captured while offline - published as the live path publishes it: on its
+    //  property topics, or (SPA_MQTT_STATE_TOPIC) as the state document with every other property as last published.
+    //  Home Assistant so gets the changes in order, each stamped with its arrival time. The record is only dequeued
+    //  once sent; it then is the property's last published value.
+    static auto SendReplayRecord = [](MqttClient &MqttClient) -> bool
+    {
+        ForwardQueue::Record record;
+        if (!forwardQueue.Peek(record))
+        {
+            return true;
+        }
+
+#if SPA_MQTT_STATE_TOPIC
+        if (!MqttClient.beginMessage(stateTopic))
+        {
+            $LogLimited(MQTT, Warning, "MQTT: SendReplayRecord: Failed to begin message");
+            return false;
+        }
+
+        for (int ix = 0; ix < (int)PublishItem::Count; ix++)
+        {
+            printf(MqttClient, "%c\"%s\":", (ix == 0) ? '{' : ',', _publishItemNames[ix]);
+            PrintPropertyValue(MqttClient, (PublishItem)ix, (ix == record._item) ? record._value : publishStates[ix]._published);
+        }
+        MqttClient.print('}');
+
+        if (!MqttClient.endMessage())
+        {
+            $LogLimited(MQTT, Warning, "MQTT: SendReplayRecord: endMessage() failed");
+            return false;
+        }
+#else
+        for (PublishItemTopic const &itemTopic : _publishItemTopics)
+        {
+            if ((uint8_t)itemTopic._item != record._item)
+            {
+                continue;
+            }
+
+            if (!MqttClient.beginMessage(*itemTopic._topic))
+            {
+                $LogLimited(MQTT, Warning, "MQTT: SendReplayRecord: Failed to begin message");
+                return false;
+            }
+            PrintPropertyValue(MqttClient, itemTopic._item, record._value);
+            if (!MqttClient.endMessage())
+            {
+                $LogLimited(MQTT, Warning, "MQTT: SendReplayRecord: endMessage() failed");
+                return false;
+            }
+        }
+#endif
+
+        uint64_t const now = MonotonicClock::NowInMSecs();
+        PublishState &published = publishStates[record._item];
+        published._published = record._value;
+        published._publishedAt = (now != 0) ? now : 1;
+        published._sent++;
+
+        forwardQueue.Pop();
+        return true;
+    };
+
     //* Monitor the Boiler State Machine for changes in state and send any changes to Home Assistant. All updated
-    //  properties are sent to Home Assistant as separate messages from this function.
+    //  properties are sent to Home Assistant as separate messages from this function - or, with SPA_MQTT_STATE_TOPIC,
+    //  together as one state document.
     static auto MonitorBoiler = [](MqttClient & MqttClient, bool DoForce = false) -> bool
     {
         // This nested state machine is used to control the sending of property messages to Home Assistant as
@@ -881,40 +1872,30 @@ void HA_MqttClient::loop()
             case State::CalcWork:
             {
                 static Timer timer(1000);
-                static uint32_t lastSeq = 0;
-
-                doBoilerInTemp = DoForce;
-                doBoilerThermometer = DoForce;
-                doBoilerOutTemp = DoForce;
-                doAmbientTemp = DoForce;
-                doHysterisis = DoForce;
-                doHeaterState = DoForce;
-                doBoilerState = DoForce;
-                doFaultReason = DoForce;
-                doSetPoint = DoForce;
-                doBoilerMode = DoForce;
-
-                //* Compute and low frequency work
+
+                doBoilerInTemp = false;
+                doBoilerThermometer = false;
+                doBoilerOutTemp = false;
+                doAmbientTemp = false;
+                doHysterisis = false;
+                doHeaterState = false;
+                doBoilerState = false;
+                doFaultReason = false;
+                doSetPoint = false;
+                doBoilerMode = false;
+
+                //* Compute and low frequency work - each property is published as its policy (deadband, min and max
+                //  interval) allows; DoForce publishes everything
                 if (timer.IsAlarmed() || DoForce)
                 {
-                    auto const seq = boilerControllerTask.GetHeaterStateSequence();
-                    bool force = (lastSeq == 0) || DoForce;
+                    boilerControllerTask.GetTempertureState(tempState);
 
-                    if ((seq != lastSeq) || force)
-                    {
-                        BoilerControllerTask::TempertureState newState;
-                        boilerControllerTask.GetTempertureState(newState);
-
-                        doBoilerInTemp = (force || (newState._boilerInTemp != tempState._boilerInTemp));
-                        doBoilerThermometer = doBoilerInTemp;
-                        doBoilerOutTemp = (force || (newState._boilerOutTemp != tempState._boilerOutTemp));
-                        doAmbientTemp = (force || (newState._ambiantTemp != tempState._ambiantTemp));
-                        doHysterisis = (force || (newState._hysteresis != tempState._hysteresis));
-                        doHeaterState = (force || (newState._heaterOn != tempState._heaterOn));
-
-                        tempState = newState;
-                        lastSeq = tempState._sequence;
-                    }
+                    doBoilerInTemp = ShouldPublish(PublishItem::BoilerInTemp, tempState._boilerInTemp, DoForce);
+                    doBoilerThermometer = doBoilerInTemp;
+                    doBoilerOutTemp = ShouldPublish(PublishItem::BoilerOutTemp, tempState._boilerOutTemp, DoForce);
+                    doAmbientTemp = ShouldPublish(PublishItem::AmbientTemp, tempState._ambiantTemp, DoForce);
+                    doHysterisis = ShouldPublish(PublishItem::Hysterisis, tempState._hysteresis, DoForce);
+                    doHeaterState = ShouldPublish(PublishItem::HeaterState, tempState._heaterOn ? 1.0 : 0.0, DoForce);
 
                     timer.SetAlarm(1000);
                 }
@@ -922,41 +1903,20 @@ void HA_MqttClient::loop()
                 //* Now compute any high frequency work
 
                 // Cause sending the boiler state if it has changed or if forced - translate the state to a string
-                BoilerControllerTask::StateMachineState currHeaterState = boilerControllerTask.GetStateMachineState();
-
-                if ((currHeaterState != lastHeaterState) || DoForce)
-                {
-                    doBoilerState = true;
-                    lastHeaterState = currHeaterState;
-                }
+                lastHeaterState = boilerControllerTask.GetStateMachineState();
+                doBoilerState = ShouldPublish(PublishItem::BoilerState, (float)(int)lastHeaterState, DoForce);
 
                 // Cause sending  the fault reason if it has changed or if forced - translate the fault reason to a string
-                BoilerControllerTask::FaultReason currFaultReason = boilerControllerTask.GetFaultReason();
-
-                if ((currFaultReason != lastFaultReason) || DoForce)
-                {
-                    doFaultReason = true;
-                    lastFaultReason = currFaultReason;
-                }
+                lastFaultReason = boilerControllerTask.GetFaultReason();
+                doFaultReason = ShouldPublish(PublishItem::FaultReason, (float)(int)lastFaultReason, DoForce);
 
                 // Cause sending the current boiler mode if needed
-                BoilerControllerTask::BoilerMode currBoilerMode = boilerControllerTask.GetMode();
-
-                if ((currBoilerMode != lastBoilerMode) || DoForce)
-                {
-                    doBoilerMode = true;
-                    lastBoilerMode = currBoilerMode;
-                }
+                lastBoilerMode = boilerControllerTask.GetMode();
+                doBoilerMode = ShouldPublish(PublishItem::BoilerMode, (float)(int)lastBoilerMode, DoForce);
 
                 // Cause sending the current setPoint temperature if it has changed or if forced
-                BoilerControllerTask::TargetTemps currTargetTemps;
-                boilerControllerTask.GetTargetTemps(currTargetTemps);
-
-                if ((currTargetTemps._setPoint != lastTargetTemps._setPoint) || DoForce)
-                {
-                    doSetPoint = true;
-                    lastTargetTemps._setPoint = currTargetTemps._setPoint;
-                }
+                boilerControllerTask.GetTargetTemps(lastTargetTemps);
+                doSetPoint = ShouldPublish(PublishItem::SetPoint, lastTargetTemps._setPoint, DoForce);
 
                 state.ChangeState(State::SendUpdates);
                 return(true);
@@ -965,6 +1925,20 @@ void HA_MqttClient::loop()
             // Send any planned updates to Home Assistant - computed in the previous state
             case State::SendUpdates:
             {
+#if SPA_MQTT_STATE_TOPIC
+                // One state document carries every property - sent once if anything changed
+                bool const doSend = doBoilerInTemp || doBoilerThermometer || doBoilerOutTemp || doAmbientTemp || doHysterisis ||
+                                    doHeaterState || doBoilerState || doFaultReason || doSetPoint || doBoilerMode;
+                doBoilerInTemp = doBoilerThermometer = doBoilerOutTemp = doAmbientTemp = doHysterisis = false;
+                doHeaterState = doBoilerState = doFaultReason = doSetPoint = doBoilerMode = false;
+
+                state.ChangeState(State::CalcWork);
+                if (doSend)
+                {
+                    return SendStateDoc(MqttClient, tempState, lastHeaterState, lastFaultReason, lastBoilerMode, lastTargetTemps);
+                }
+                return true;
+#else
                 enum class SendState    // sequence of property messages to send
                 {
                     SendBoilerInTemp,
@@ -996,7 +1970,7 @@ void HA_MqttClient::loop()
                         {
                             doBoilerInTemp = false;
                             sendState.ChangeState(SendState::SendBoilerThermometer);
-                            return SendPropertyMsg(MqttClient, boilerBaseTopic, _haWHCurrTemp, $CtoF(tempState._boilerInTemp));
+                            return SendPropertyMsg(MqttClient, boilerCurrTempTopic, $CtoF(tempState._boilerInTemp));
                         }
                     }
                     case SendState::SendBoilerThermometer:
@@ -1005,7 +1979,7 @@ void HA_MqttClient::loop()
                         {
                             doBoilerThermometer = false;
                             sendState.ChangeState(SendState::SendBoilerOutTemp);
-                            return SendPropertyMsg(MqttClient, boilerInThermometerBaseTopic, _haSensorTemp, $CtoF(tempState._boilerInTemp));
+                            return SendPropertyMsg(MqttClient, boilerInThermometerTempTopic, $CtoF(tempState._boilerInTemp));
                         }
                     }
                     case SendState::SendBoilerOutTemp:
@@ -1014,7 +1988,7 @@ void HA_MqttClient::loop()
                         {
                             doBoilerOutTemp = false;
                             sendState.ChangeState(SendState::SendAmbientTemp);
-                            return SendPropertyMsg(MqttClient, boilerOutThermometerBaseTopic, _haSensorTemp, $CtoF(tempState._boilerOutTemp));
+                            return SendPropertyMsg(MqttClient, boilerOutThermometerTempTopic, $CtoF(tempState._boilerOutTemp));
                         }
                     }
                     case SendState::SendAmbientTemp:
@@ -1023,7 +1997,7 @@ void HA_MqttClient::loop()
                         {
                             doAmbientTemp = false;
                             sendState.ChangeState(SendState::SendHysterisis);
-                            return SendPropertyMsg(MqttClient, ambientThermometerBaseTopic, _haSensorTemp, $CtoF(tempState._ambiantTemp));
+                            return SendPropertyMsg(MqttClient, ambientThermometerTempTopic, $CtoF(tempState._ambiantTemp));
                         }
                     }
                     case SendState::SendHysterisis:
@@ -1032,7 +2006,7 @@ void HA_MqttClient::loop()
                         {
                             doHysterisis = false;
                             sendState.ChangeState(SendState::SendHeaterState);
-                            return SendPropertyMsg(MqttClient, hysterisisBaseTopic, _haNumericState, $CDiffToF(tempState._hysteresis));
+                            return SendPropertyMsg(MqttClient, hysterisisStateTopic, $CDiffToF(tempState._hysteresis));
                         }
                     }
                     case SendState::SendHeaterState:
@@ -1041,7 +2015,7 @@ void HA_MqttClient::loop()
                         {
                             doHeaterState = false;
                             sendState.ChangeState(SendState::SendBoilerState);
-                            return SendPropertyMsgStr(MqttClient, heaterStateBinarySensorBaseTopic, _haBinarySensorState, tempState._heaterOn ? "On" : "Off");
+                            return SendPropertyMsgStr(MqttClient, heaterStateTopic, tempState._heaterOn ? "On" : "Off");
                         }
                     }
                     case SendState::SendBoilerState:
@@ -1050,7 +2024,7 @@ void HA_MqttClient::loop()
                         {
                             doBoilerState = false;
                             sendState.ChangeState(SendState::SendFaultReason);
-                            return SendPropertyMsgStr(MqttClient, boilerStateSensorBaseTopic, _haSensorEnum, BoilerControllerTask::GetStateMachineStateDescription(lastHeaterState));
+                            return SendPropertyMsgStr(MqttClient, boilerStateTopic, BoilerControllerTask::GetStateMachineStateDescription(lastHeaterState));
                         }
                     }
                     case SendState::SendFaultReason:
@@ -1059,7 +2033,7 @@ void HA_MqttClient::loop()
                         {
                             doFaultReason = false;
                             sendState.ChangeState(SendState::SendSetPoint);
-                            return SendPropertyMsgStr(MqttClient, faultReasonSensorBaseTopic, _haSensorEnum, BoilerControllerTask::GetFaultReasonDescription(lastFaultReason));
+                            return SendPropertyMsgStr(MqttClient, faultReasonTopic, BoilerControllerTask::GetFaultReasonDescription(lastFaultReason));
                         }
                     }
                     case SendState::SendSetPoint:
@@ -1068,7 +2042,7 @@ void HA_MqttClient::loop()
                         {
                             doSetPoint = false;
                             sendState.ChangeState(SendState::SendBoilerMode);
-                            return SendPropertyMsg(MqttClient, boilerBaseTopic, _haWHSetpoint, $CtoF(lastTargetTemps._setPoint));
+                            return SendPropertyMsg(MqttClient, boilerSetpointTopic, $CtoF(lastTargetTemps._setPoint));
                         }
                     }
                     case SendState::SendBoilerMode:
@@ -1077,7 +2051,7 @@ void HA_MqttClient::loop()
                         {
                             doBoilerMode = false;
                             sendState.ChangeState(SendState::Done);
-                            return SendPropertyMsgStr(MqttClient, boilerBaseTopic, _haWHMode, BoilerControllerTask::GetBoilerModeDescription(lastBoilerMode));
+                            return SendPropertyMsgStr(MqttClient, boilerModeTopic, BoilerControllerTask::GetBoilerModeDescription(lastBoilerMode));
                         }
                     }
                     case SendState::Done:
@@ -1090,6 +2064,7 @@ void HA_MqttClient::loop()
                         $FailFast();
                     }
                 }
+#endif
             }
             break;
 
@@ -1102,17 +2077,16 @@ void HA_MqttClient::loop()
     };
 
     //** Support for subscription notification and handling of Home Assistant topics
-    using NotificationHandler = std::function<bool(const char *)>;  // A subscription notification handler function type
 
     //* Notification handlers for each MQTT subscription topic
     // Mode Set command
     static NotificationHandler HandleWHModeSet = [](const char *Payload) -> bool
     {
-        logger.Printf(Logger::RecType::Info, "MQTT: Received WH Mode Set command: %s", Payload);
+        $Log(MQTT, Info, "MQTT: Received WH Mode Set command: %s", Payload);
         BoilerControllerTask::BoilerMode mode = BoilerControllerTask::GetBoilerModeFromDescription(Payload);
         if (mode == BoilerControllerTask::BoilerMode::Undefined)
         {
-            logger.Printf(Logger::RecType::Warning, "MQTT: Invalid WH Mode Set command value: %s", Payload);
+            $Log(MQTT, Warning, "MQTT: Invalid WH Mode Set command value: %s", Payload);
             return false;
         }
 
@@ -1122,7 +2096,7 @@ void HA_MqttClient::loop()
         boilerConfig.Begin();
         if (!boilerConfig.IsValid())
         {
-            logger.Printf(Logger::RecType::Warning, "MQTT: Failed to write WH Mode Set command value to config: %s", Payload);
+            $Log(MQTT, Warning, "MQTT: Failed to write WH Mode Set command value to config: %s", Payload);
             return false;
         }
 
@@ -1144,7 +2118,7 @@ void HA_MqttClient::loop()
         boilerConfig.Begin();
         if (!boilerConfig.IsValid())
         {
-            logger.Printf(Logger::RecType::Warning, "MQTT: SetTargetTemp: Failed to write to config");
+            $Log(MQTT, Warning, "MQTT: SetTargetTemp: Failed to write to config");
             return false;
         }
 
@@ -1157,7 +2131,7 @@ void HA_MqttClient::loop()
     // Setpoint Set command
     static NotificationHandler HandleWHSetpointSet = [](const char *Payload) -> bool
     {
-        logger.Printf(Logger::RecType::Info, "MQTT: Received WH Setpoint Set command: %s", Payload);
+        $Log(MQTT, Info, "MQTT: Received WH Setpoint Set command: %s", Payload);
         float setpoint = $FtoC(atof(Payload));
 
         return SetTargetTempAndHysterisis(setpoint, boilerConfig.GetRecord()._hysteresis);
@@ -1166,7 +2140,7 @@ void HA_MqttClient::loop()
     // Hysterisis Set command
     static NotificationHandler HandleHysterisisSetCmd = [](const char *Payload) -> bool
     {
-        logger.Printf(Logger::RecType::Info, "MQTT: Received Hysterisis Set command: %s", Payload);
+        $Log(MQTT, Info, "MQTT: Received Hysterisis Set command: %s", Payload);
         float hysterisis = $FDiffToC(atof(Payload));
 
         return SetTargetTempAndHysterisis(boilerConfig.GetRecord()._setPoint, hysterisis);
@@ -1175,7 +2149,7 @@ void HA_MqttClient::loop()
     // Reset Button command
     static NotificationHandler HandleResetButtonCmd = [](const char *Payload) -> bool
     {
-        logger.Printf(Logger::RecType::Info, "MQTT: Received Reset Button Event: %s", Payload);
+        $Log(MQTT, Info, "MQTT: Received Reset Button Event: %s", Payload);
         boilerControllerTask.ResetIfSafe();
         return true;
     };
@@ -1183,7 +2157,7 @@ void HA_MqttClient::loop()
     // Start Button command
     static NotificationHandler HandleStartButtonCmd = [](const char *Payload) -> bool
     {
-        logger.Printf(Logger::RecType::Info, "MQTT: Received Start Button Event: %s", Payload);
+        $Log(MQTT, Info, "MQTT: Received Start Button Event: %s", Payload);
         boilerControllerTask.StartIfSafe();
         return true;
     };
@@ -1191,7 +2165,7 @@ void HA_MqttClient::loop()
     // Stop Button command
     static NotificationHandler HandleStopButtonCmd = [](const char *Payload) -> bool
     {
-        logger.Printf(Logger::RecType::Info, "MQTT: Received Stop Button Event: %s", Payload);
+        $Log(MQTT, Info, "MQTT: Received Stop Button Event: %s", Payload);
         boilerControllerTask.StopIfSafe();
         return true;
     };
@@ -1199,90 +2173,87 @@ void HA_MqttClient::loop()
     // Reboot Button command
     static NotificationHandler HandleRebootButtonCmd = [](const char *Payload) -> bool
     {
-        logger.Printf(Logger::RecType::Info, "MQTT: Received Reboot Button Event: %s", Payload);
-        logger.Printf(Logger::RecType::Progress, "MQTT: ***rebooting***");
+        $Log(MQTT, Info, "MQTT: Received Reboot Button Event: %s", Payload);
+        $Log(MQTT, Progress, "MQTT: ***rebooting***");
         delay(1000);
         NVIC_SystemReset();
         $FailFast();
         return true;
     };
 
-    // Home Assistant Integration Available event
+    // Home Assistant Integration Available event - HA (re)started; it needs discovery and the current state again
     static bool HAIntgAvailCameTrue = false;
+    static uint64_t haBirthAt;          // ms - for the birth to online time
 
     static NotificationHandler HandleHAIntgAvailEvent = [](const char *Payload) -> bool
     {
-        logger.Printf(Logger::RecType::Info, "MQTT: Received HA Intg Avail Event: %s", Payload);
+        $Log(MQTT, Info, "MQTT: Received HA Intg Avail Event: %s", Payload);
         if (strcmp(Payload, "online") == 0)
         {
-            HAIntgAvailCameTrue = true;     // Cause reconnect to broker
+            HAIntgAvailCameTrue = true;     // Cause discovery and state to be republished - the session is kept
+            haBirthAt = MonotonicClock::NowInMSecs();
         }
         return true;
     };
 
-    //* Describes a Home Assistant MQTT subscription topic and its notification handler
-    class SubscribedTopic
+    //* Register every subscribed topic with its handler - once; the full topics were built by setup()
+    static bool const topicsRegistered = []() -> bool
     {
-    public:
-        const char *_baseTopic;
-        const char *_topicSuffix;
-        int _baseTopicSize;
-        int _topicSuffixSize;
-        NotificationHandler &_handler;
-
-        SubscribedTopic(const char *BaseTopic, const char *TopicSuffix, NotificationHandler &Handler)
-            : _baseTopic(BaseTopic),
-              _topicSuffix(TopicSuffix),
-              _handler(Handler)
-        {
-            _baseTopicSize = strlen(BaseTopic);
-            _topicSuffixSize = strlen(TopicSuffix);
-        }
-
-        SubscribedTopic() = delete;
-    };
-
-    //* Table of all subscribed topics
-    static SubscribedTopic subscribedTopics[] =
-    {
-        SubscribedTopic(mqttConfig.GetRecord()._baseHATopic, _haIntgAvailSuffix, HandleHAIntgAvailEvent),
-        SubscribedTopic(boilerBaseTopic, _haWHModeSet, HandleWHModeSet),
-        SubscribedTopic(boilerBaseTopic, _haWHSetpointSet, HandleWHSetpointSet),
-        SubscribedTopic(resetButtonBaseTopic, _haButtonCmd, HandleResetButtonCmd),
-        SubscribedTopic(startButtonBaseTopic, _haButtonCmd, HandleStartButtonCmd),
-        SubscribedTopic(stopButtonBaseTopic, _haButtonCmd, HandleStopButtonCmd),
-        SubscribedTopic(rebootButtonBaseTopic, _haButtonCmd, HandleRebootButtonCmd),
-        SubscribedTopic(hysterisisBaseTopic, _haNumericCmd, HandleHysterisisSetCmd)
-    };
-    static int subscribedTopicCount = sizeof(subscribedTopics) / sizeof(SubscribedTopic);
+        topicDispatcher.Add(haIntgStatusTopic, HandleHAIntgAvailEvent);
+        topicDispatcher.Add(boilerModeSetTopic, HandleWHModeSet);
+        topicDispatcher.Add(boilerSetpointSetTopic, HandleWHSetpointSet);
+        topicDispatcher.Add(resetButtonCmdTopic, HandleResetButtonCmd);
+        topicDispatcher.Add(startButtonCmdTopic, HandleStartButtonCmd);
+        topicDispatcher.Add(stopButtonCmdTopic, HandleStopButtonCmd);
+        topicDispatcher.Add(rebootButtonCmdTopic, HandleRebootButtonCmd);
+        topicDispatcher.Add(hysterisisSetTopic, HandleHysterisisSetCmd);
+        return true;
+    }();
+    $Assert(topicsRegistered);
 
     //* Notification dispatcher for incoming MQTT messages - called from the onMessage() handler lambda
     static auto OnMessage = [](int msgSize, MqttClient &Client) -> void
     {
-        // Process the incoming message
-        String topic = std::move(Client.messageTopic());
-        char payload[msgSize + 1];
-        int read = Client.read((uint8_t *)&payload[0], msgSize);
-        $Assert(read == msgSize);
-        payload[msgSize] = '\0';
-        logger.Printf(Logger::RecType::Info, "Received message on topic: %s - payload: %s", topic.c_str(), payload);
-
-        // Call the handler for the topic
-        int i;
-        for (i = 0; i < subscribedTopicCount; i++)
-        {
-            if ((topic.length() == (subscribedTopics[i]._baseTopicSize + subscribedTopics[i]._topicSuffixSize)) 
-                                    && (topic.startsWith(subscribedTopics[i]._baseTopic)) 
-                                    && (topic.endsWith(subscribedTopics[i]._topicSuffix)))
-            {
-                subscribedTopics[i]._handler(payload); // Call the handler for the topic; given it the payload
-                break;
+        // The library only hands out its received topic as a String copy - take it once; no further String work
+        String const topic = Client.messageTopic();
+
+        if ((uint32_t)msgSize > rxLargestPayload)
+        {
+            rxLargestPayload = msgSize;
+        }
+
+        // Oversized - drain it through the arena (bounded by msgSize) and drop it
+        if (msgSize > SPA_MQTT_MAX_PAYLOAD)
+        {
+            int remaining = msgSize;
+            while (remaining > 0)
+            {
+                int read = Client.read((uint8_t *)&rxPayload[0], std::min(remaining, SPA_MQTT_MAX_PAYLOAD));
+                if (read <= 0)
+                {
+                    break;
+                }
+                remaining -= read;
             }
+            rxOversizeDrops++;
+            $LogLimited(MQTT, Warning, "MQTT: Dropped %d byte payload on topic: %s", msgSize, topic.c_str());
+            return;
+        }
+
+        int read = Client.read((uint8_t *)&rxPayload[0], msgSize);
+        if (read != msgSize)
+        {
+            rxShortReads++;
+            $LogLimited(MQTT, Warning, "MQTT: Short read (%d of %d) on topic: %s", read, msgSize, topic.c_str());
+            return;
         }
+        rxPayload[msgSize] = '\0';
+        $Log(MQTT, Info, "Received message on topic: %s - payload: %s", topic.c_str(), rxPayload);
 
-        if (i == subscribedTopicCount)
+        // Call the handler for the topic - it parses the payload in place
+        if (!topicDispatcher.Dispatch(topic.c_str(), rxPayload))
         {
-            logger.Printf(Logger::RecType::Warning, "Topic: %s not found in subscribedTopics table", topic.c_str());
+            $LogLimited(MQTT, Warning, "Topic: %s not subscribed", topic.c_str());
         }
     };
 
@@ -1291,7 +2262,7 @@ void HA_MqttClient::loop()
     //******************************************************************************
     //** State machine implementation for MQTT client
 
-    static shared_ptr<Client> netClient = move(NetworkTask::CreateClient());
+    static ClientHandle netClient = NetworkTask::CreateClient();
     static MqttClient mqttClient(*netClient.get());
 
     enum class State
@@ -1305,6 +2276,24 @@ void HA_MqttClient::loop()
     };
     static StateMachineState<State> state(State::WaitForNetConnection);
 
+    static uint64_t connectStartedAt;       // ms - for the connect to online time
+    static bool skipAvailDelay;             // discovery was not resent - no need to give HA time to process it
+    static bool isRepublishing;             // SendConfigs/SendOnlineAvailMsg entered from Connected - session is up
+
+    // Once we have been connected, property changes while not connected are queued for replay
+    static bool hasBeenConnected = false;
+    static bool isCapturing = false;
+    if (((State)state == State::Connected) || isRepublishing)
+    {
+        hasBeenConnected = true;
+        isCapturing = false;
+    }
+    else if (hasBeenConnected)
+    {
+        CaptureOfflineChanges(!isCapturing);
+        isCapturing = true;
+    }
+
     switch ((State)state)
     {
         //* Delay while waiting for network to connect and be available
@@ -1339,7 +2328,7 @@ void HA_MqttClient::loop()
                         return;
                     }
 
-                    logger.Printf(Logger::RecType::Progress, "MQTT: Waiting for network connection - delay until network is available");
+                    $LogLimited(MQTT, Progress, "MQTT: Waiting for network connection - delay until network is available");
                     delayTimer.SetAlarm(5000);
                     networkState.ChangeState(NetworkStatus::Disconnected);
                 }
@@ -1373,8 +2362,8 @@ void HA_MqttClient::loop()
         {
             static IPAddress brokerIP;
 
-            logger.Printf(Logger::RecType::Progress, "MQTT: Connecting to Broker: IP: '%s' Port: '%d'", 
-                IPAddress(mqttConfig.GetRecord()._brokerIP).toString().c_str(), 
+            $LogLimited(MQTT, Progress, "MQTT: Connecting to Broker: IP: '%s' Port: '%d'", 
+                NetworkTask::IPToString(IPAddress(mqttConfig.GetRecord()._brokerIP)).c_str(), 
                 mqttConfig.GetRecord()._brokerPort);
 
             brokerIP = mqttConfig.GetRecord()._brokerIP;
@@ -1383,22 +2372,26 @@ void HA_MqttClient::loop()
             mqttClient.setUsernamePassword(mqttConfig.GetRecord()._username, mqttConfig.GetRecord()._password);
 
             // Add LWT topic; this will change all /avail topics all the entities at the same time
-            mqttClient.beginWill(commonAvailTopic, sizeof(_haAvailOffline), true, 1);
-            printf(mqttClient, "\"%s\"", _haAvailOffline);
+            mqttClient.beginWill(commonAvailTopic, strlen(_availOfflinePayload), true, 1);
+            mqttClient.print(_availOfflinePayload);
             mqttClient.endWill();
 
+            connectStartedAt = MonotonicClock::NowInMSecs();
+            connectStats._connects++;
+
             if (!mqttClient.connect(brokerIP, mqttConfig.GetRecord()._brokerPort))
             {
                 // failed for some reason
-                logger.Printf(Logger::RecType::Critical, "MQTT: Failed to connect to Broker - delaying 5 secs and retrying");
+                $LogLimited(MQTT, Critical, "MQTT: Failed to connect to Broker - delaying 5 secs and retrying");
                 state.ChangeState(State::WaitForNetConnection);
                 return;
             }
 
-            logger.Printf(Logger::RecType::Progress, "MQTT: Connected to Broker - sending subscriptions to Home Assistant");
+            $Log(MQTT, Progress, "MQTT: Connected to Broker - sending subscriptions to Home Assistant");
 
             // Set the message handler for incoming messages
             HAIntgAvailCameTrue = false;
+            isRepublishing = false;
             mqttClient.onMessage([](int messageSize) -> void { OnMessage(messageSize, mqttClient); } );
 
             // Subscribe to all the Home Assistant incoming topics for each entity
@@ -1410,7 +2403,14 @@ void HA_MqttClient::loop()
         case State::SendSubscriptions:
         {
             // Subscribe to all the Home Assistant incoming topics of interest - only one subscription per call
-            // to loop() to allow other network related tasks to be performed between each subscription
+            // to loop() to allow other network related tasks to be performed between each subscription. With
+            // SPA_MQTT_WILDCARD_SUBSCRIBE, HA's status topic and the command wildcard cover every dispatched topic
+            #if SPA_MQTT_WILDCARD_SUBSCRIBE
+            const char* const subscriptions[] = {haIntgStatusTopic, commandWildcardTopic};
+            int const subscriptionCount = sizeof(subscriptions) / sizeof(subscriptions[0]);
+            #else
+            int const subscriptionCount = topicDispatcher.GetCount();
+            #endif
             static int ix;
 
             if (state.IsFirstTime())
@@ -1418,26 +2418,34 @@ void HA_MqttClient::loop()
                 ix = 0;
             }
 
-            if (ix < subscribedTopicCount)
+            if (ix < subscriptionCount)
             {
-                char topic[subscribedTopics[ix]._baseTopicSize + subscribedTopics[ix]._topicSuffixSize + 1];
-                memcpy(topic, subscribedTopics[ix]._baseTopic, subscribedTopics[ix]._baseTopicSize);
-                memcpy(&topic[subscribedTopics[ix]._baseTopicSize], subscribedTopics[ix]._topicSuffix, subscribedTopics[ix]._topicSuffixSize);
-                topic[subscribedTopics[ix]._baseTopicSize + subscribedTopics[ix]._topicSuffixSize] = '\0';
-
-                logger.Printf(Logger::RecType::Progress, "MQTT: Subscribing to topic: %s", topic);
+                #if SPA_MQTT_WILDCARD_SUBSCRIBE
+                const char *topic = subscriptions[ix];
+                #else
+                const char *topic = topicDispatcher.GetTopic(ix);
+                #endif
+                $Log(MQTT, Progress, "MQTT: Subscribing to topic: %s", topic);
                 if (!mqttClient.subscribe(topic))
                 {
-                    logger.Printf(Logger::RecType::Warning, "MQTT: Failed to subscribe to topic: %s - restarting", topic);
+                    $LogLimited(MQTT, Warning, "MQTT: Failed to subscribe to topic: %s - restarting", topic);
                     state.ChangeState(State::WaitForNetConnection);
                     return;
                 }
 
                 ix++;
             }
+            else if (mqttConfig.GetRecord()._discoveryFingerprint == BrokerDiscoveryFingerprint())
+            {
+                $Log(MQTT, Progress, "MQTT: All subscriptions sent - discovery unchanged (retained); now sending /avail message");
+                connectStats._discoverySkipped++;
+                skipAvailDelay = true;
+                state.ChangeState(State::SendOnlineAvailMsg);
+            }
             else
             {
-                logger.Printf(Logger::RecType::Progress, "MQTT: All subscriptions sent to Home Assistant - now sending /config messages");
+                $Log(MQTT, Progress, "MQTT: All subscriptions sent to Home Assistant - now sending /config messages");
+                skipAvailDelay = false;
                 state.ChangeState(State::SendConfigs);
             }
         }
@@ -1458,23 +2466,30 @@ void HA_MqttClient::loop()
             if (ix < _entityDescCount)
             {
                 HaEntityDesc &desc = _entityDescs[ix];
-                logger.Printf(Logger::RecType::Progress, "MQTT: Sending /config message for entity: %s", desc._EntityName);
+                $Log(MQTT, Progress, "MQTT: Sending /config message for entity: %s", desc._EntityName);
                 if (!SendConfigJSON(
                         mqttClient,
                         mqttConfig.GetRecord()._baseHATopic,
                         *desc._BaseTopicResult,
                         mqttConfig.GetRecord()._haDeviceName,
-                        desc._EntityName, desc._ConfigJsonTemplate,
+                        desc._EntityName, desc._StateKey, desc._ConfigJsonTemplate,
                         *desc._ExpandedMsgSizeResult))
                 {
-                    logger.Printf(Logger::RecType::Warning, "MQTT: Failed to send /config message for entity: %s - restarting", desc._EntityName);
+                    $LogLimited(MQTT, Warning, "MQTT: Failed to send /config message for entity: %s - restarting", desc._EntityName);
+                    isRepublishing = false;
                     state.ChangeState(State::WaitForNetConnection);
                     return;
                 }
             }
             else
             {
-                logger.Printf(Logger::RecType::Progress, "MQTT: All /config messages sent to Home Assistant - now sending /avail message after 2sec delay");
+                $Log(MQTT, Progress, "MQTT: All /config messages sent to Home Assistant - now sending /avail message%s",
+                     skipAvailDelay ? "" : " after 2sec delay");
+                if (mqttConfig.GetRecord()._discoveryFingerprint != BrokerDiscoveryFingerprint())
+                {
+                    mqttConfig.GetRecord()._discoveryFingerprint = BrokerDiscoveryFingerprint();
+                    mqttConfig.Write();
+                }
                 state.ChangeState(State::SendOnlineAvailMsg);
             }
 
@@ -1495,7 +2510,7 @@ void HA_MqttClient::loop()
             // Send the /avail message to Home Assistant after a short delay - race issue with Home Assistant
             if (state.IsFirstTime())
             {
-                availState.ChangeState(AvailState::Wait2Secs);  // reset inner state machine on new state change to this state
+                availState.ChangeState(skipAvailDelay ? AvailState::SendAvail : AvailState::Wait2Secs);  // reset inner state machine on new state change to this state
             }
 
             switch ((AvailState)availState)
@@ -1524,15 +2539,33 @@ void HA_MqttClient::loop()
                 case AvailState::SendAvail:
                 {
                     // Tell Home Assistant that all entities are available
-                    logger.Printf(Logger::RecType::Progress, "MQTT: Sending /avail message to Home Assistant");
+                    $Log(MQTT, Progress, "MQTT: Sending /avail message to Home Assistant");
                     if (!SendOnlineAvailMsg(mqttClient))
                     {
-                        logger.Printf(Logger::RecType::Warning, "Failed to send /avail messages to Home Assistant - restarting");
+                        $LogLimited(MQTT, Warning, "Failed to send /avail messages to Home Assistant - restarting");
+                        isRepublishing = false;
                         state.ChangeState(State::WaitForNetConnection);
                         return;
                     }
 
-                    logger.Printf(Logger::RecType::Progress, "MQTT: /avail message sent to Home Assistant - now monitoring for incoming messages");
+                    if (isRepublishing)
+                    {
+                        uint32_t const toOnlineInMs = (uint32_t)(MonotonicClock::NowInMSecs() - haBirthAt);
+                        connectStats._lastBirthToOnlineInMs = toOnlineInMs;
+                        connectStats._maxBirthToOnlineInMs = std::max(connectStats._maxBirthToOnlineInMs, toOnlineInMs);
+                        isRepublishing = false;
+
+                        $Log(MQTT, Progress, "MQTT: /avail message resent to Home Assistant (%ums after its birth)", toOnlineInMs);
+                    }
+                    else
+                    {
+                        uint32_t const toOnlineInMs = (uint32_t)(MonotonicClock::NowInMSecs() - connectStartedAt);
+                        connectStats._lastToOnlineInMs = toOnlineInMs;
+                        connectStats._minToOnlineInMs = std::min(connectStats._minToOnlineInMs, toOnlineInMs);
+                        connectStats._maxToOnlineInMs = std::max(connectStats._maxToOnlineInMs, toOnlineInMs);
+
+                        $Log(MQTT, Progress, "MQTT: /avail message sent to Home Assistant (%ums after connect) - now monitoring for incoming messages", toOnlineInMs);
+                    }
                     state.ChangeState(State::Connected);
                 }
                 break;
@@ -1550,16 +2583,29 @@ void HA_MqttClient::loop()
         case State::Connected:
         {
             static Timer nextConnextCheckTimer;
+            static Timer nextDiagTimer;
+            static Timer nextReplayTimer;
+            static bool isSnapshotPending;
 
             if (state.IsFirstTime())
             {
                 nextConnextCheckTimer.SetAlarm(1000);
+                nextDiagTimer.SetAlarm(0);
+                nextReplayTimer.SetAlarm(0);
+                isSnapshotPending = true;
+
+                ForwardQueue::Record oldest;
+                if (forwardQueue.Peek(oldest))
+                {
+                    $Log(MQTT, Progress, "MQTT: Replaying %u property changes captured while offline (oldest %us ago)",
+                         forwardQueue.GetDepth(), (uint32_t)(MonotonicClock::NowInMSecs() / 1000) - oldest._monotonicSecs);
+                }
             }
 
             // Check for lost network connection and restart SM if lost
             if (!network.IsAvailable())
             {
-                logger.Printf(Logger::RecType::Warning, "MQTT: Lost network connection - restarting");
+                $LogLimited(MQTT, Warning, "MQTT: Lost network connection - restarting");
                 state.ChangeState(State::WaitForNetConnection);
                 return;
             }
@@ -1571,31 +2617,75 @@ void HA_MqttClient::loop()
                 // Check for lost connection to MQTT Broker and restart SM if lost
                 if (!mqttClient.connected())
                 {
-                    logger.Printf(Logger::RecType::Warning, "MQTT: Lost connection to Broker - restarting");
+                    $LogLimited(MQTT, Warning, "MQTT: Lost connection to Broker - restarting");
                     state.ChangeState(State::WaitForNetConnection);
                     return;
                 }
             }
             
-            // Check for HAIntgAvailCameTrue and restart SM if true
+            // Home Assistant restarted - keep the session; republish discovery and /avail without the settle delay.
+            // Re-entering Connected then forces a full state snapshot (see MonitorBoiler)
             if (HAIntgAvailCameTrue)
             {
                 HAIntgAvailCameTrue = false;
-                logger.Printf(Logger::RecType::Progress, "MQTT: HAIntgAvailCameTrue - restarting");
-                state.ChangeState(State::WaitForNetConnection);
+                $Log(MQTT, Progress, "MQTT: HAIntgAvailCameTrue - republishing discovery and state");
+                connectStats._haBirths++;
+                isRepublishing = true;
+                skipAvailDelay = true;
+                state.ChangeState(State::SendConfigs);
                 return;
             }
 
             mqttClient.poll(); // Check for incoming messages
 
-            // Publish to Home Assistant any change of state for the Boiler for each entity - force all properties to be sent
-            // if this state was just entered from another state
-            if (!MonitorBoiler(mqttClient, state.IsFirstTime()))
+            // Replay property changes captured while offline - oldest first; rate limited. The live state waits until
+            // they are all sent, so it is never overwritten by an older value.
+            if (!forwardQueue.IsEmpty())
+            {
+                if (nextReplayTimer.IsAlarmed())
+                {
+                    nextReplayTimer.SetAlarm(_replayIntervalInMs);
+                    if (!SendReplayRecord(mqttClient))
+                    {
+                        $LogLimited(MQTT, Warning, "MQTT: Failed to replay property change - restarting");
+                        state.ChangeState(State::WaitForNetConnection);
+                        return;
+                    }
+                }
+            }
+            else
+            {
+                // Publish to Home Assistant any change of state for the Boiler for each entity - force all properties
+                // to be sent the first time after this state was entered (and any replay done)
+                bool const doForce = isSnapshotPending;
+                isSnapshotPending = false;
+                if (!MonitorBoiler(mqttClient, doForce))
+                {
+                    $LogLimited(MQTT, Warning, "MQTT: Failed in MonitorBoiler - restarting");
+                    state.ChangeState(State::WaitForNetConnection);
+                    return;
+                }
+            }
+
+            // Publish any queued log records - one per pass
+            if (!SendLogRecord(mqttClient))
             {
-                logger.Printf(Logger::RecType::Warning, "MQTT: Failed in MonitorBoiler - restarting");
+                $LogLimited(MQTT, Warning, "MQTT: Failed to publish log record - restarting");
                 state.ChangeState(State::WaitForNetConnection);
                 return;
             }
+
+            // Publish the memory usage diag record periodically
+            if (nextDiagTimer.IsAlarmed())
+            {
+                nextDiagTimer.SetAlarm(_diagPublishIntervalInMs);
+                if (!SendDiag(mqttClient))
+                {
+                    $LogLimited(MQTT, Warning, "MQTT: Failed to publish diag record - restarting");
+                    state.ChangeState(State::WaitForNetConnection);
+                    return;
+                }
+            }
         }
         break;
 
@@ -7,9 +7,40 @@
 #include <functional>
 #include "MQTT_HA.hpp"
 
+//** Largest incoming MQTT payload accepted (bytes) - payloads are read into a fixed receive arena of this size;
+//   larger ones are drained from the connection and dropped (counted)
+#if !defined(SPA_MQTT_MAX_PAYLOAD)
+#define SPA_MQTT_MAX_PAYLOAD        64
+#endif
+
+//** Property publishing - 0: one message per changed property on its own topic; 1: one compact JSON state document
+//   per change on TinyBus/<device>/state, with each entity's /config pointing at its field through a value template
+#if !defined(SPA_MQTT_STATE_TOPIC)
+#define SPA_MQTT_STATE_TOPIC        0
+#endif
+
+//** Command subscriptions - 0: one SUBSCRIBE per command topic under each entity's HA base topic; 1: command topics
+//   live under TinyBus/<device>/cmd/<entity>/... and one wildcard SUBSCRIBE (plus HA's status topic) covers them all
+#if !defined(SPA_MQTT_WILDCARD_SUBSCRIBE)
+#define SPA_MQTT_WILDCARD_SUBSCRIBE 0
+#endif
+
+//** Property changes queued in RAM while the broker is unreachable - replayed in order on their own state topics once
+//   reconnected, ahead of the live state (see also SPA_MQTT_SPILL_SIZE for spilling the oldest to flash)
+#if !defined(SPA_MQTT_FORWARD_DEPTH)
+#define SPA_MQTT_FORWARD_DEPTH      32
+#endif
+
 //* MQTT Client Task
 class HA_MqttClient final : public ArduinoTask
 {
+public:
+    void PrintDispatchStats(Stream &ToStream, int IndentBy = 0);    // per subscribed topic handler counts and times; receive drops
+    void ResetDispatchStats();
+    void PrintPublishStats(Stream &ToStream, int IndentBy = 0);     // per property publishes sent and suppressed
+    void ResetPublishStats();
+    void PrintConnectStats(Stream &ToStream, int IndentBy = 0);     // reconnects and connect to "online" times
+
 protected:
     virtual void setup() override final;
     virtual void loop() override final;
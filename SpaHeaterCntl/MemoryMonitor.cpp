@@ -0,0 +1,265 @@
+// SPA Heater Controller for Maxie HA system 2024 (c)TinyBus
+// Memory (stack and heap) usage monitoring implementation
+
+#include "MemoryMonitor.hpp"
+#include <malloc.h>
+
+MemoryMonitor::ThreadStack  MemoryMonitor::_threads[MaxThreads];
+int                         MemoryMonitor::_nbrOfThreads = 0;
+uint32_t                    MemoryMonitor::_news = 0;
+uint32_t                    MemoryMonitor::_deletes = 0;
+uint32_t                    MemoryMonitor::_newsAtStartup = UINT32_MAX;
+
+
+void MemoryMonitor::RegisterThread(TaskHandle_t Handle, char const* Name, uint32_t StackDepthInWords)
+{
+    synchronized
+    {
+        $Assert(_nbrOfThreads < MaxThreads);
+        _threads[_nbrOfThreads++] = ThreadStack{Name, Handle, StackDepthInWords * sizeof(StackType_t), 0};
+    }
+}
+
+int MemoryMonitor::GetThreadStacks(ThreadStack (&Stacks)[MaxThreads])
+{
+    int nbrOfThreads;
+    synchronized
+    {
+        nbrOfThreads = _nbrOfThreads;
+        memcpy(&Stacks[0], &_threads[0], sizeof(_threads));
+    }
+
+    for (int ix = 0; ix < nbrOfThreads; ix++)
+    {
+        Stacks[ix]._minFreeInBytes = uxTaskGetStackHighWaterMark(Stacks[ix]._handle) * sizeof(StackType_t);
+    }
+    return nbrOfThreads;
+}
+
+void MemoryMonitor::GetStats(Stats& Result)
+{
+    HeapStats_t heapStats;
+    vPortGetHeapStats(&heapStats);
+
+    Result._rtosHeapSize = configTOTAL_HEAP_SIZE;
+    Result._rtosHeapFree = heapStats.xAvailableHeapSpaceInBytes;
+    Result._rtosHeapMinFree = heapStats.xMinimumEverFreeBytesRemaining;
+    Result._rtosHeapLargestFreeBlock = heapStats.xSizeOfLargestFreeBlockInBytes;
+    Result._rtosHeapFreeBlocks = heapStats.xNumberOfFreeBlocks;
+    Result._rtosHeapAllocs = heapStats.xNumberOfSuccessfulAllocations;
+    Result._rtosHeapFrees = heapStats.xNumberOfSuccessfulFrees;
+
+    struct mallinfo const info = mallinfo();
+    Result._heapArena = info.arena;
+    Result._heapInUse = info.uordblks;
+    Result._heapFreeInArena = info.fordblks;
+    synchronized
+    {
+        Result._news = _news;
+        Result._deletes = _deletes;
+        Result._newsSinceStartup = (_newsAtStartup == UINT32_MAX) ? 0 : (_news - _newsAtStartup);
+    }
+}
+
+void MemoryMonitor::Print(Stream& ToStream, int IndentBy)
+{
+    ThreadStack stacks[MaxThreads];
+    int const nbrOfThreads = GetThreadStacks(stacks);
+    for (int ix = 0; ix < nbrOfThreads; ix++)
+    {
+        printf(ToStream, "%*sStack: %s: size: %u; max used: %u; min free: %u\n", IndentBy, "",
+            stacks[ix]._name, stacks[ix]._sizeInBytes, stacks[ix]._sizeInBytes - stacks[ix]._minFreeInBytes, stacks[ix]._minFreeInBytes);
+    }
+
+    Stats stats;
+    GetStats(stats);
+    printf(ToStream, "%*sRTOS heap: size: %u; free: %u; min free: %u; largest free block: %u; free blocks: %u\n", IndentBy, "",
+        stats._rtosHeapSize, stats._rtosHeapFree, stats._rtosHeapMinFree, stats._rtosHeapLargestFreeBlock, stats._rtosHeapFreeBlocks);
+    printf(ToStream, "%*sRTOS heap: allocs: %u; frees: %u\n", IndentBy, "", stats._rtosHeapAllocs, stats._rtosHeapFrees);
+    printf(ToStream, "%*sC++ heap: arena (peak): %u; in use: %u; free in arena: %u; news: %u; deletes: %u; news since startup: %u\n", IndentBy, "",
+        stats._heapArena, stats._heapInUse, stats._heapFreeInArena, stats._news, stats._deletes, stats._newsSinceStartup);
+}
+
+// Linker script (CMSIS/FSP) section symbols - weak so a script without them reads as zero rather than failing the link
+extern "C" char __data_start__[] __attribute__((weak));
+extern "C" char __bss_end__[] __attribute__((weak));
+extern "C" char __StackLimit[] __attribute__((weak));
+extern "C" char __StackTop[] __attribute__((weak));
+
+void MemoryMonitor::PrintRamBudget(Stream& ToStream)
+{
+    static constexpr char const* const rtosStorage = SPA_STATIC_RTOS ? "static" : "in freeRTOS heap";
+    static auto PrintLine = [](Stream& ToStream, char const* Item, uint32_t Bytes, char const* Note) -> void
+    {
+        printf(ToStream, "    %-32s %6u  %s\n", Item, Bytes, Note);
+    };
+
+    Stats stats;
+    GetStats(stats);
+    ThreadStack stacks[MaxThreads];
+    int const nbrOfThreads = GetThreadStacks(stacks);
+
+    printf(ToStream, "RAM budget (bytes):\n");
+
+    uint32_t const staticSize = (__data_start__ && __bss_end__) ? (uint32_t)(__bss_end__ - __data_start__) : 0;
+    PrintLine(ToStream, "Static (.data + .bss)", staticSize, staticSize ? "of which:" : "n/a - no linker symbols");
+
+    char rtosHeapNote[48];
+    snprintf(rtosHeapNote, sizeof(rtosHeapNote), "used: %u; peak: %u", 
+        stats._rtosHeapSize - stats._rtosHeapFree, stats._rtosHeapSize - stats._rtosHeapMinFree);
+    PrintLine(ToStream, "  freeRTOS heap", stats._rtosHeapSize, rtosHeapNote);
+
+    for (int ix = 0; ix < nbrOfThreads; ix++)
+    {
+        char item[32];
+        snprintf(item, sizeof(item), "  %s thread stack + TCB", stacks[ix]._name);
+        PrintLine(ToStream, item, stacks[ix]._sizeInBytes + sizeof(StaticTask_t), rtosStorage);
+    }
+    PrintLine(ToStream, "  Mutexes", InstrumentedMutex::GetCount() * sizeof(StaticSemaphore_t), rtosStorage);
+    PrintLine(ToStream, "  Shared printf buffer", sharedPrintfBuffer.GetSize(), "");
+
+    uint32_t sinkQueues = 0;
+    for (int ix = 0; ix < (int)Logger::SinkId::Count; ix++)
+    {
+        Logger::Sink::Stats sinkStats;
+        logger.GetSink((Logger::SinkId)ix).GetStats(sinkStats);
+        sinkQueues += sinkStats._queueSize;
+    }
+    PrintLine(ToStream, "  Logger sink queues", sinkQueues, "");
+    PrintLine(ToStream, "  Network object pools", NetworkTask::GetPoolsSize(), "");
+
+    char heapNote[48];
+    snprintf(heapNote, sizeof(heapNote), "in use: %u", stats._heapInUse);
+    PrintLine(ToStream, "C++ heap (arena)", stats._heapArena, heapNote);
+
+    uint32_t const mspStackSize = (__StackLimit && __StackTop) ? (uint32_t)(__StackTop - __StackLimit) : 0;
+    PrintLine(ToStream, "Interrupt (MSP) stack", mspStackSize, mspStackSize ? "" : "n/a - no linker symbols");
+    if (staticSize && mspStackSize)
+    {
+        uint32_t const total = (uint32_t)(__StackTop - __data_start__);
+        uint32_t const used = staticSize + stats._heapArena + mspStackSize;
+        PrintLine(ToStream, "Unused (heap headroom)", (total > used) ? (total - used) : 0, "");
+        PrintLine(ToStream, "Total", total, "");
+    }
+}
+
+void MemoryMonitor::GetSnapshot(Snapshot& Result)
+{
+    Result._nbrOfThreads = GetThreadStacks(Result._stacks);
+    GetStats(Result._stats);
+}
+
+int MemoryMonitor::PrintJson(::Print& ToPrint)
+{
+    Snapshot snapshot;
+    GetSnapshot(snapshot);
+    return PrintJson(ToPrint, snapshot);
+}
+
+int MemoryMonitor::PrintJson(::Print& ToPrint, Snapshot const& From)
+{
+    ThreadStack const (&stacks)[MaxThreads] = From._stacks;
+    int const nbrOfThreads = From._nbrOfThreads;
+    Stats const& stats = From._stats;
+
+    int size = ToPrint.print("{\"stacks\":{");
+    for (int ix = 0; ix < nbrOfThreads; ix++)
+    {
+        size += ToPrint.print((ix == 0) ? "\"" : ",\"");
+        size += ToPrint.print(stacks[ix]._name);
+        size += ToPrint.print("\":{\"size\":");
+        size += ToPrint.print(stacks[ix]._sizeInBytes);
+        size += ToPrint.print(",\"minFree\":");
+        size += ToPrint.print(stacks[ix]._minFreeInBytes);
+        size += ToPrint.print("}");
+    }
+
+    struct { char const* _name; uint32_t _value; } const values[] =
+    {
+        {"},\"rtosHeapSize\":", stats._rtosHeapSize},
+        {",\"rtosHeapFree\":", stats._rtosHeapFree},
+        {",\"rtosHeapMinFree\":", stats._rtosHeapMinFree},
+        {",\"rtosHeapLargestFree\":", stats._rtosHeapLargestFreeBlock},
+        {",\"rtosHeapFreeBlocks\":", stats._rtosHeapFreeBlocks},
+        {",\"heapArena\":", stats._heapArena},
+        {",\"heapInUse\":", stats._heapInUse},
+        {",\"heapFreeInArena\":", stats._heapFreeInArena},
+        {",\"news\":", stats._news},
+        {",\"deletes\":", stats._deletes},
+        {",\"newsSinceStartup\":", stats._newsSinceStartup},
+    };
+    for (auto const& value : values)
+    {
+        size += ToPrint.print(value._name);
+        size += ToPrint.print(value._value);
+    }
+    size += ToPrint.print("}");
+
+    return size;
+}
+
+void MemoryMonitor::MarkStartupComplete()
+{
+    synchronized
+    {
+        _newsAtStartup = _news;
+    }
+}
+
+void MemoryMonitor::CountNew()
+{
+    synchronized
+    {
+        _news++;
+    }
+}
+
+void MemoryMonitor::CountDelete()
+{
+    synchronized
+    {
+        _deletes++;
+    }
+}
+
+
+//** Counting replacements of the global new/delete operators - on newlib malloc/free
+void* operator new(size_t Size)
+{
+    MemoryMonitor::CountNew();
+    return malloc(Size);
+}
+
+void* operator new[](size_t Size)
+{
+    MemoryMonitor::CountNew();
+    return malloc(Size);
+}
+
+void operator delete(void* Ptr) noexcept
+{
+    if (Ptr != nullptr)
+    {
+        MemoryMonitor::CountDelete();
+        free(Ptr);
+    }
+}
+
+void operator delete[](void* Ptr) noexcept
+{
+    if (Ptr != nullptr)
+    {
+        MemoryMonitor::CountDelete();
+        free(Ptr);
+    }
+}
+
+void operator delete(void* Ptr, size_t Size) noexcept
+{
+    operator delete(Ptr);
+}
+
+void operator delete[](void* Ptr, size_t Size) noexcept
+{
+    operator delete[](Ptr);
+}
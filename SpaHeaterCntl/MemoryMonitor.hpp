@@ -0,0 +1,79 @@
+// SPA Heater Controller for Maxie HA system 2024 (c)TinyBus
+// Memory (stack and heap) usage monitoring definitions
+
+#pragma once
+#include "SpaHeaterCntl.hpp"
+
+//* Stack and heap usage of the system - used to size the thread stacks, the freeRTOS heap (configTOTAL_HEAP_SIZE)
+//  and the C++ heap from measurements rather than by guessing.
+//
+//  Thread stacks are painted by freeRTOS when the thread is created; the high water mark is the deepest the
+//  paint has been overwritten. Threads are registered with their stack size when created (see RegisterThread()).
+//  The freeRTOS heap (thread stacks and TCBs, queues, semaphores) and the C++ heap (new/delete, String, 
+//  std::vector, shared_ptr - newlib malloc) are separate pools and are reported separately. All C++ 
+//  new/delete calls are counted; once startup is complete the system itself should not allocate (see
+//  StaticContainers.hpp) so news since startup only come from libraries and interactive commands.
+class MemoryMonitor
+{
+public:
+    struct ThreadStack
+    {
+        char const*     _name;
+        TaskHandle_t    _handle;
+        uint32_t        _sizeInBytes;
+        uint32_t        _minFreeInBytes;        // high water mark - least free ever
+    };
+
+    struct Stats
+    {
+        // freeRTOS heap
+        uint32_t    _rtosHeapSize;
+        uint32_t    _rtosHeapFree;
+        uint32_t    _rtosHeapMinFree;           // peak use = size - min free
+        uint32_t    _rtosHeapLargestFreeBlock;  // fragmentation: compare with _rtosHeapFree
+        uint32_t    _rtosHeapFreeBlocks;
+        uint32_t    _rtosHeapAllocs;
+        uint32_t    _rtosHeapFrees;
+
+        // C++ heap
+        uint32_t    _heapArena;                 // taken from the system (sbrk) - the peak footprint
+        uint32_t    _heapInUse;
+        uint32_t    _heapFreeInArena;           // fragmentation: free but not returnable to the system
+        uint32_t    _news;
+        uint32_t    _deletes;
+        uint32_t    _newsSinceStartup;          // should stay at zero - see MarkStartupComplete()
+    };
+
+    static constexpr int MaxThreads = 4;
+
+    //* Everything PrintJson() prints - taken once so the JSON can be sized and then printed identically
+    struct Snapshot
+    {
+        ThreadStack     _stacks[MaxThreads];
+        int             _nbrOfThreads;
+        Stats           _stats;
+    };
+
+public:
+    static void RegisterThread(TaskHandle_t Handle, char const* Name, uint32_t StackDepthInWords);
+    static int GetThreadStacks(ThreadStack (&Stacks)[MaxThreads]);     // returns the number of threads
+    static void GetStats(Stats& Result);
+    static void GetSnapshot(Snapshot& Result);
+
+    static void Print(Stream& ToStream, int IndentBy = 0);
+    static void PrintRamBudget(Stream& ToStream);                       // where the RAM went - printed at boot
+    static int PrintJson(::Print& ToPrint);                             // returns the number of chars printed
+    static int PrintJson(::Print& ToPrint, Snapshot const& From);
+
+    static void MarkStartupComplete();                                  // allocations after this are counted separately
+
+    static void CountNew();
+    static void CountDelete();
+
+private:
+    static ThreadStack      _threads[MaxThreads];
+    static int              _nbrOfThreads;
+    static uint32_t         _news;
+    static uint32_t         _deletes;
+    static uint32_t         _newsAtStartup;
+};
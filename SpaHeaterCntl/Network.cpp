@@ -12,14 +12,14 @@
 class NetDriver
 {
 public:
-    virtual shared_ptr<Client> CreateClient() = 0;
-    virtual shared_ptr<Server> CreateServer(int Port) = 0;
-    virtual shared_ptr<UDP> CreateUDP() = 0;
-    virtual shared_ptr<Client> available(shared_ptr<Server> Server) = 0;
+    virtual ClientHandle CreateClient() = 0;
+    virtual ServerHandle CreateServer(int Port) = 0;
+    virtual UDPHandle CreateUDP() = 0;
+    virtual ClientHandle available(ServerHandle& Server) = 0;
 
     //* Server specific methods
-    virtual void begin(shared_ptr<Server> Server) = 0;
-    virtual void end(shared_ptr<Server> Server) = 0;
+    virtual void begin(ServerHandle& Server) = 0;
+    virtual void end(ServerHandle& Server) = 0;
     //.
     //.
     //.
@@ -57,10 +57,10 @@ CmdLine::Status ShowAddressingConfigProcessor(Stream &CmdStream, int Argc, char
 {
     printf(CmdStream, "Network Addressing Configuration: DHCP: %s; IP: %s; Subnet: %s; Gateway: %s; DNS: %s\n",
         networkConfigRecord.GetRecord()._useDHCP ? "Yes" : "No",
-        IPAddress(IPAddress(networkConfigRecord.GetRecord()._ipAddr)).toString().c_str(),
-        IPAddress(IPAddress(networkConfigRecord.GetRecord()._subnetMask)).toString().c_str(),
-        IPAddress(IPAddress(networkConfigRecord.GetRecord()._gateway)).toString().c_str(),
-        IPAddress(IPAddress(networkConfigRecord.GetRecord()._dnsServer)).toString().c_str());
+        NetworkTask::IPToString(IPAddress(networkConfigRecord.GetRecord()._ipAddr)).c_str(),
+        NetworkTask::IPToString(IPAddress(networkConfigRecord.GetRecord()._subnetMask)).c_str(),
+        NetworkTask::IPToString(IPAddress(networkConfigRecord.GetRecord()._gateway)).c_str(),
+        NetworkTask::IPToString(IPAddress(networkConfigRecord.GetRecord()._dnsServer)).c_str());
 
     return CmdLine::Status::Ok;
 }
@@ -183,50 +183,74 @@ CmdLine::ProcessorDesc networkTaskCmdProcessors[] =
 int const LengthOfNetworkTaskCmdProcessors = sizeof(networkTaskCmdProcessors) / sizeof(networkTaskCmdProcessors[0]);
 
 //* Core Network Component implementation
-shared_ptr<Client> NetworkTask::CreateClient() 
+//  All network objects come from fixed pools sized for the system: clients - MQTT and telnet (+ one for a
+//  telnet reconnect); servers - telnet; UDP - NTP.
+static ObjectPool<WiFiClient, 3>    clientPool;
+static ObjectPool<WiFiServer, 1>    serverPool;
+static ObjectPool<WiFiUDP, 1>       udpPool;
+
+ClientHandle NetworkTask::CreateClient() 
 { 
-    return make_shared<WiFiClient>(); 
+    return clientPool.Create(); 
 }
 
-shared_ptr<Server> NetworkTask::CreateServer(int Port) 
+ServerHandle NetworkTask::CreateServer(int Port) 
 { 
-    return make_shared<WiFiServer>(Port); 
+    return serverPool.Create(Port); 
 }
 
-shared_ptr<UDP> NetworkTask::CreateUDP() 
+UDPHandle NetworkTask::CreateUDP() 
 { 
-    return make_shared<WiFiUDP>(); 
+    return udpPool.Create(); 
 }
 
-shared_ptr<Client> NetworkTask::available(shared_ptr<Server> Server)
+ClientHandle NetworkTask::available(ServerHandle& Server)
 {
-    WiFiClient client = (static_pointer_cast<WiFiServer>(Server))->available();
+    WiFiClient client = static_cast<WiFiServer*>(Server.get())->available();
     if (client)
     {
-        return make_shared<WiFiClient>(client);
+        ClientHandle handle = clientPool.Create(client);
+        if (handle == nullptr)
+        {
+            $LogLimited(Network, Warning, "NetworkTask: Client pool exhausted - connection refused");
+            client.stop();
+        }
+        return handle;
     }
     return nullptr;
 }
 
-void NetworkTask::begin(shared_ptr<Server> Server)
+void NetworkTask::begin(ServerHandle& Server)
+{
+    static_cast<WiFiServer*>(Server.get())->begin();
+}
+
+void NetworkTask::end(ServerHandle& Server)
+{
+    static_cast<WiFiServer*>(Server.get())->end();
+}
+
+uint32_t NetworkTask::GetPoolsSize()
 {
-    (static_pointer_cast<WiFiServer>(Server))->begin();
+    return sizeof(clientPool) + sizeof(serverPool) + sizeof(udpPool);
 }
 
-void NetworkTask::end(shared_ptr<Server> Server)
+IPString NetworkTask::IPToString(IPAddress const& Address)
 {
-    (static_pointer_cast<WiFiServer>(Server))->end();
+    char buffer[IPString::Capacity() + 1];
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", Address[0], Address[1], Address[2], Address[3]);
+    return IPString(buffer);
 }
 
 
 void NetworkTask::Begin()
 {
-    logger.Printf(Logger::RecType::Progress, "NetworkTask: Starting...");
+    $Log(Network, Progress, "NetworkTask: Starting...");
     networkConfigRecord.Begin();
     strcpy(networkConfigRecord.GetRecord()._signature, NetworkConfig::_sigConst);
     if (!networkConfigRecord.IsValid())
     {
-        logger.Printf(Logger::RecType::Progress, "NetworkTask: No valid network configuration found - creating default");
+        $Log(Network, Progress, "NetworkTask: No valid network configuration found - creating default");
         networkConfigRecord.GetRecord()._useDHCP = true;
         networkConfigRecord.GetRecord()._ipAddr = 0;
         networkConfigRecord.GetRecord()._subnetMask = 0;
@@ -274,7 +298,7 @@ void NetworkTask::loop()
 
             if (state.IsFirstTime())
             {
-                logger.Printf(Logger::RecType::Progress, "NetworkTask: Waiting for configuration from wifiJoinApTask...");
+                $Log(Network, Progress, "NetworkTask: Waiting for configuration from wifiJoinApTask...");
             }
             if (wifiJoinApTask.IsCompleted())
             {
@@ -282,7 +306,7 @@ void NetworkTask::loop()
 
                 wifiJoinApTask.GetNetworkConfig(_ssid, _networkPassword);
 
-                logger.Printf(Logger::RecType::Progress, "NetworkTask: Have configuration for SSID: '%s'", &_ssid[0]);
+                $Log(Network, Progress, "NetworkTask: Have configuration for SSID: '%s'", &_ssid[0]);
                 state.ChangeState(State::StartWiFiBegin);
             }
         }
@@ -302,14 +326,14 @@ void NetworkTask::loop()
                     WiFi.setHostname("SpaHeaterCntl");
 
                     // Dump the network configuration
-                    logger.Printf(Logger::RecType::Progress, "NetworkTask: Network Configuration: DHCP: %s; IP: %s; Subnet: %s; Gateway: %s; DNS: %s",
+                    $Log(Network, Progress, "NetworkTask: Network Configuration: DHCP: %s; IP: %s; Subnet: %s; Gateway: %s; DNS: %s",
                                   networkConfigRecord.GetRecord()._useDHCP ? "Yes" : "No",
-                                  IPAddress(IPAddress(networkConfigRecord.GetRecord()._ipAddr)).toString().c_str(),
-                                  IPAddress(IPAddress(networkConfigRecord.GetRecord()._subnetMask)).toString().c_str(),
-                                  IPAddress(IPAddress(networkConfigRecord.GetRecord()._gateway)).toString().c_str(),
-                                  IPAddress(IPAddress(networkConfigRecord.GetRecord()._dnsServer)).toString().c_str());
+                                  IPToString(IPAddress(networkConfigRecord.GetRecord()._ipAddr)).c_str(),
+                                  IPToString(IPAddress(networkConfigRecord.GetRecord()._subnetMask)).c_str(),
+                                  IPToString(IPAddress(networkConfigRecord.GetRecord()._gateway)).c_str(),
+                                  IPToString(IPAddress(networkConfigRecord.GetRecord()._dnsServer)).c_str());
 
-                    logger.Printf(Logger::RecType::Progress, "NetworkTask: Attempting to connect to WPA SSID: '%s'", _ssid);
+                    $LogLimited(Network, Progress, "NetworkTask: Attempting to connect to WPA SSID: '%s'", _ssid);
 
                     WiFi.setHostname("SpaHeaterCntl");
                     if (!networkConfigRecord.GetRecord()._useDHCP)
@@ -321,14 +345,14 @@ void NetworkTask::loop()
                             IPAddress(networkConfigRecord.GetRecord()._gateway),
                             IPAddress(networkConfigRecord.GetRecord()._subnetMask));
 
-                        logger.Printf(Logger::RecType::Progress, "NetworkTask: Using static IP addressing");
+                        $Log(Network, Progress, "NetworkTask: Using static IP addressing");
                     }
 
                     status = WiFi.begin(_ssid, _networkPassword);
                     if (status != WL_CONNECTED)
                     {
                         // If we get here, we are retrying but delaying for a bit - connection failed
-                        logger.Printf(Logger::RecType::Progress, "NetworkTask: WiFi.begin() failed with status: %d", status);
+                        $LogLimited(Network, Progress, "NetworkTask: WiFi.begin() failed with status: %d", status);
                         delayTimer.SetAlarm(5000);          // cause retry in 5 seconds
                         return;
                     }
@@ -336,12 +360,12 @@ void NetworkTask::loop()
 
                 uint8_t mac[6];
                 WiFi.macAddress(&mac[0]);
-                String ourMAC = MacToString(mac);
+                MacString const ourMAC = MacToString(mac);
 
                 IPAddress ip = WiFi.localIP();
                 if ((networkConfigRecord.GetRecord()._useDHCP) && (ip == IPAddress(0, 0, 0, 0)))
                 {
-                    logger.Printf(Logger::RecType::Progress, "NetworkTask: DHCP IP address not assigned: SSID: '%s' (MAC: %s) - retrying...", 
+                    $LogLimited(Network, Progress, "NetworkTask: DHCP IP address not assigned: SSID: '%s' (MAC: %s) - retrying...", 
                         _ssid, 
                         MacToString(mac).c_str());
                     
@@ -351,12 +375,12 @@ void NetworkTask::loop()
                 }
 
                 // Have a connection - move to Connected state
-                String      ipAddr = ip.toString();
+                IPString const  ipAddr = IPToString(ip);
 
                 WiFi.BSSID(&mac[0]);
-                String      apBSSID = MacToString(mac);
+                MacString const apBSSID = MacToString(mac);
 
-                logger.Printf(Logger::RecType::Progress, "NetworkTask: Connected: SSID: '%s' @ %s (MAC: %s); AP BSSID: %s", 
+                $Log(Network, Progress, "NetworkTask: Connected: SSID: '%s' @ %s (MAC: %s); AP BSSID: %s", 
                     _ssid, 
                     ipAddr.c_str(),
                     ourMAC.c_str(),
@@ -390,7 +414,7 @@ void NetworkTask::loop()
                     _isAvailable = false;
                     WiFi.disconnect();
 
-                    logger.Printf(Logger::RecType::Progress, "NetworkTask: Disconnected - delay 2 seconds before retrying...");
+                    $LogLimited(Network, Progress, "NetworkTask: Disconnected - delay 2 seconds before retrying...");
                     state.ChangeState(State::DelayAfterDisconnect);
                     return;
                 }
@@ -419,25 +443,15 @@ void NetworkTask::loop()
     }
 }
 
-String &NetworkTask::AppendHEX(uint8_t Byte, String &AddTo)
-{
-    static char hexDigit[] = "0123456789ABCDEF";
-
-    AddTo += hexDigit[((Byte & 0xF0) >> 4)];
-    AddTo += hexDigit[(Byte & 0x0F)];
-
-    return AddTo;
-}
-
-String NetworkTask::MacToString(uint8_t *Mac)
+MacString NetworkTask::MacToString(uint8_t *Mac)
 {
-    String result = "";
+    MacString result;
     for (int i = 5; i >= 0; i--)
     {
-        AppendHEX(Mac[i], result);
+        result.AppendHex(Mac[i]);
         if (i > 0)
         {
-            result += ":";
+            result.Append(':');
         }
     }
 
@@ -6,12 +6,18 @@
 #include <Client.h>
 #include <Server.h>
 #include <UDP.h>
-#include <memory>
-
-using namespace std;
+#include "StaticContainers.hpp"
 
 
 //** Network related definitions
+//* Handles to network objects - from fixed pools in the network driver (see Network.cpp)
+typedef PoolHandle<Client>  ClientHandle;
+typedef PoolHandle<Server>  ServerHandle;
+typedef PoolHandle<UDP>     UDPHandle;
+
+typedef FixedString<17>     MacString;          // "XX:XX:XX:XX:XX:XX"
+typedef FixedString<15>     IPString;           // "DDD.DDD.DDD.DDD"
+
 //* Main Network Task - maintains WiFi connection
 class NetworkTask final : public ArduinoTask
 {
@@ -23,13 +29,16 @@ public:
 
     bool IsAvailable();
 
-    static shared_ptr<Client> CreateClient();
-    static shared_ptr<Server> CreateServer(int Port);
-    static shared_ptr<UDP> CreateUDP();
+    static ClientHandle CreateClient();
+    static ServerHandle CreateServer(int Port);
+    static UDPHandle CreateUDP();
+
+    static ClientHandle available(ServerHandle& Server);
+    static void begin(ServerHandle& Server);
+    static void end(ServerHandle& Server);
 
-    static shared_ptr<Client> available(shared_ptr<Server> Server);
-    static void begin(shared_ptr<Server> Server);
-    static void end(shared_ptr<Server> Server);
+    static IPString IPToString(IPAddress const& Address);       // heap free IPAddress::toString()
+    static uint32_t GetPoolsSize();                             // RAM used by the network object pools
 
     void disconnect();
 
@@ -38,8 +47,7 @@ protected:
     virtual void loop() override;
 
 private: 
-    static String &AppendHEX(uint8_t Byte, String &AddTo);
-    static String MacToString(uint8_t *Mac);
+    static MacString MacToString(uint8_t *Mac);
 
 private:
     const char *_ssid;
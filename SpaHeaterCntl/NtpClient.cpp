@@ -5,21 +5,48 @@
 
 
 
+//* NTP timestamp helpers - 64 bit big endian: seconds since 1900 . 2^-32 fractions
+static constexpr uint32_t seventyYears = 2208988800UL;
+
+static uint64_t NtpToUnixUSecs(const uint8_t* At)
+{
+    uint32_t const secs = (uint32_t(At[0]) << 24) | (uint32_t(At[1]) << 16) | (uint32_t(At[2]) << 8) | At[3];
+    uint32_t const fraction = (uint32_t(At[4]) << 24) | (uint32_t(At[5]) << 16) | (uint32_t(At[6]) << 8) | At[7];
+    return (uint64_t(secs - seventyYears) * 1000000) + ((uint64_t(fraction) * 1000000) >> 32);
+}
+
+static void PutUInt64(uint8_t* At, uint64_t Value)
+{
+    for (int ix = 7; ix >= 0; ix--)
+    {
+        At[ix] = uint8_t(Value);
+        Value >>= 8;
+    }
+}
+
+
 void NTPClient::setup()
 {
     //_timeServerIPAddress.fromString(_timeServerIP);
 
-    _timeServerIPAddress = IPAddress(162, 159, 200, 123); // time.nist.gov
-    logger.Printf(Logger::RecType::Progress, "NTPClient: Starting - time server: %s", _timeServerIPAddress.toString().c_str());
+    _serverIPAddresses[0] = IPAddress(162, 159, 200, 123);     // time.cloudflare.com
+    _serverIPAddresses[1] = IPAddress(216, 239, 35, 0);        // time.google.com
+    _serverIPAddresses[2] = IPAddress(129, 6, 15, 28);         // time-a-g.nist.gov
+    _selectedServer = -1;
+    _pollInSecs = _minPollInSecs;
+    _pollCount = 0;
+    _lastDelayUSecs = 0;
+
+    $Log(NTP, Progress, "NTPClient: Starting - %d time servers", _serverCount);
     _udp = move(NetworkTask::CreateUDP());
     $Assert(_udp.get() != nullptr);
     if (!_udp->begin(_localPort))
     {
-        logger.Printf(Logger::RecType::Critical, "NTPClient: UDP begin failed - trying secondary port");
+        $Log(NTP, Critical, "NTPClient: UDP begin failed - trying secondary port");
 
         if (!_udp->begin(_localPort + 1))
         {
-            logger.Printf(Logger::RecType::Critical, "NTPClient: UDP begin on secondary port failed - disabling NTPClient");
+            $Log(NTP, Critical, "NTPClient: UDP begin on secondary port failed - disabling NTPClient");
             _udp.reset();
             _udp = nullptr;
         }
@@ -31,7 +58,8 @@ void NTPClient::loop()
     enum class State
     {
         WaitForNetwork,
-        Start,
+        StartRound,
+        SendRequest,
         WaitForResponse,
         Done,
         StallForever    
@@ -46,12 +74,12 @@ void NTPClient::loop()
     {
         if (state.IsFirstTime())
         {
-            //logger.Printf(Logger::RecType::Progress, "NtpClient: WaitForNetwork");
+            //$Log(NTP, Progress, "NtpClient: WaitForNetwork");
         
             if (_udp == nullptr)
             {
                 // UDP is not available for some reason - NtpClient disabled
-                logger.Printf(Logger::RecType::Warning, "NtpClient: UDP is not available - NtpClient disabled!");
+                $Log(NTP, Warning, "NtpClient: UDP is not available - NtpClient disabled!");
                 state.ChangeState(State::StallForever);
                 return;
             }
@@ -59,7 +87,7 @@ void NTPClient::loop()
 
         if (network.IsAvailable())
         {
-            state.ChangeState(State::Start);
+            state.ChangeState(State::StartRound);
         }
     }
     break;
@@ -69,22 +97,25 @@ void NTPClient::loop()
     }
     break;
 
-    case State::Start:
+    //* Query every server (a full round) until one is selected and then periodically; otherwise only the
+    //  selected server
+    case State::StartRound:
     {
-        if (state.IsFirstTime())
-        {
-            logger.Printf(Logger::RecType::Progress, "NtpClient: Start: sendingRequest");
-            sendNTPpacket();
-            timer.SetAlarm(2000);
-        }
+        _fullRound = (_selectedServer < 0) || ((_pollCount % _fullRoundEvery) == 0);
+        _serverIx = _fullRound ? 0 : _selectedServer;
+        memset(_samples, 0, sizeof(_samples));
+        state.ChangeState(State::SendRequest);
+    }
+    break;
 
-        // Wait for 1 second for the request to be sent
-        if (timer.IsAlarmed())
-        {
-            // Now allow 2 seconds for the response
-            timer.SetAlarm(2000);
-            state.ChangeState(State::WaitForResponse);
-        }
+    case State::SendRequest:
+    {
+        $LogLimited(NTP, Progress, "NtpClient: sending request to %s", NetworkTask::IPToString(_serverIPAddresses[_serverIx]).c_str());
+        sendNTPpacket();
+
+        // Allow 2 seconds for the response
+        timer.SetAlarm(2000);
+        state.ChangeState(State::WaitForResponse);
     }
     break;
 
@@ -94,44 +125,36 @@ void NTPClient::loop()
 
         while (_udp->parsePacket())     // drain and process any response packets
         {
-            if (_udp->read(_packetBuffer, _ntpPacketSize) == _ntpPacketSize)
-            {
-                uint32_t highWord = word(_packetBuffer[40], _packetBuffer[41]);
-                uint32_t lowWord = word(_packetBuffer[42], _packetBuffer[43]);
-                uint32_t secsSince1900 = highWord << 16 | lowWord;
-                const uint32_t seventyYears = 2208988800UL;
-                uint32_t epoch = secsSince1900 - seventyYears;
-                static RTCTime time(epoch);
-                time.setUnixTime(epoch);
-
-                logger.Printf(Logger::RecType::NtpRef, "%s", time.toString().c_str());
-                if (!RTC.setTime(time))
-                {
-                    logger.Printf(Logger::RecType::Warning, "NtpClient: RTC.setTime() failed!");
-                }
+            uint64_t const receivedAt = timeService.MonotonicNow();
 
+            if (ProcessResponse(receivedAt))
+            {
                 foundRsp = true;
             }
             else
             {
-                logger.Printf(Logger::RecType::Warning, "NtpClient: Response is bad");
+                $LogLimited(NTP, Warning, "NtpClient: Response is bad");
             }
         }
 
-        if (foundRsp)
+        if (!foundRsp && !timer.IsAlarmed())
         {
-            timer.SetAlarm(uint32_t(60000) /* * 10 */); // 10 minutes until next update
-            state.ChangeState(State::Done);
             return;
         }
 
-        if (timer.IsAlarmed())
+        if (!foundRsp)
         {
-            // No response, try again after a delay
-            logger.Printf(Logger::RecType::Warning, "NtpClient: Response timeout");
-            timer.SetAlarm(10000); // 10 seconds
-            state.ChangeState(State::Done);
+            $LogLimited(NTP, Warning, "NtpClient: Response timeout from %s", NetworkTask::IPToString(_serverIPAddresses[_serverIx]).c_str());
         }
+
+        if (_fullRound && (++_serverIx < _serverCount))
+        {
+            state.ChangeState(State::SendRequest);
+            return;
+        }
+
+        timer.SetAlarm(ApplyRound());
+        state.ChangeState(State::Done);
     }
     break;
 
@@ -142,7 +165,7 @@ void NTPClient::loop()
         {
             if (!networkAvailable)
             {
-                logger.Printf(Logger::RecType::Progress, "NtpClient: Network is not available");
+                $LogLimited(NTP, Progress, "NtpClient: Network is not available");
             }
             state.ChangeState(State::WaitForNetwork);
         }
@@ -156,6 +179,146 @@ void NTPClient::loop()
     }
 }
 
+/**
+ * @brief Reads and validates one response and records it as the current server's sample.
+ * 
+ * With T1 = request sent, T2 = server received, T3 = server sent and T4 = response received:
+ *      offset = ((T2 - T1) + (T3 - T4)) / 2        delay = (T4 - T1) - (T3 - T2)
+ * T1 and T4 are monotonic uSecs, so the offset is that of UTC from the monotonic clock.
+ * 
+ * @return false if the packet is not a valid response to the outstanding request.
+ */
+bool NTPClient::ProcessResponse(uint64_t ReceivedAt)
+{
+    if (_udp->read(_packetBuffer, _ntpPacketSize) != _ntpPacketSize)
+    {
+        return false;
+    }
+
+    uint8_t const leap = _packetBuffer[0] >> 6;
+    uint8_t const mode = _packetBuffer[0] & 0x07;
+    uint8_t const stratum = _packetBuffer[1];
+    if ((leap == 3) || (mode != 4) || (stratum == 0) || (stratum > 15))
+    {
+        return false;               // unsynchronized server, kiss-o'-death or not a server response
+    }
+
+    // The originate timestamp must echo the transmit timestamp of our request
+    uint8_t expected[8];
+    PutUInt64(expected, _requestSentAt);
+    if (memcmp(&_packetBuffer[24], expected, sizeof(expected)) != 0)
+    {
+        return false;
+    }
+
+    int64_t const t1 = (int64_t)_requestSentAt;
+    int64_t const t2 = (int64_t)NtpToUnixUSecs(&_packetBuffer[32]);
+    int64_t const t3 = (int64_t)NtpToUnixUSecs(&_packetBuffer[40]);
+    int64_t const t4 = (int64_t)ReceivedAt;
+    int64_t const delay = (t4 - t1) - (t3 - t2);
+
+    Sample& sample = _samples[_serverIx];
+    sample._valid = true;
+    sample._monotonicUSecs = ReceivedAt;
+    sample._offsetUSecs = ((t2 - t1) + (t3 - t4)) / 2;
+    sample._delayUSecs = (delay > 0) ? (uint32_t)delay : 0;
+    return true;
+}
+
+// Select the lowest delay sample of the round and discipline the time service with it - returns the mSecs
+// until the next round
+uint32_t NTPClient::ApplyRound()
+{
+    int best = -1;
+    for (int ix = 0; ix < _serverCount; ix++)
+    {
+        if (_samples[ix]._valid && ((best < 0) || (_samples[ix]._delayUSecs < _samples[best]._delayUSecs)))
+        {
+            best = ix;
+        }
+    }
+
+    if (best < 0)
+    {
+        // No response, try again after a delay - with a full round
+        _selectedServer = -1;
+        return 10000;
+    }
+
+    Sample const& sample = _samples[best];
+    _selectedServer = best;
+    _lastDelayUSecs = sample._delayUSecs;
+    bool const stepped = timeService.Discipline(sample._monotonicUSecs, sample._offsetUSecs);
+
+    TimeService::Status status;
+    timeService.GetStatus(status);
+
+    // Adapt the poll interval - only once the drift has been estimated
+    if (stepped || !status._driftEstimated)
+    {
+        _pollInSecs = _minPollInSecs;
+    }
+    else if ((status._lastErrorUSecs < _pollUpErrorUSecs) && (status._lastErrorUSecs > -_pollUpErrorUSecs))
+    {
+        _pollInSecs = ((_pollInSecs * 2) < _maxPollInSecs) ? (_pollInSecs * 2) : _maxPollInSecs;
+    }
+    else if ((status._lastErrorUSecs > _pollDownErrorUSecs) || (status._lastErrorUSecs < -_pollDownErrorUSecs))
+    {
+        _pollInSecs = ((_pollInSecs / 2) > _minPollInSecs) ? (_pollInSecs / 2) : _minPollInSecs;
+    }
+    _pollCount++;
+
+    // Reference pair for the log decoder: the sample's monotonic time and the UTC measured for it
+    uint64_t const utc = sample._monotonicUSecs + sample._offsetUSecs;
+    time_t const utcSecs = time_t(utc / 1000000);
+    struct tm utcTime;
+    char utcTimeString[20];
+    gmtime_r(&utcSecs, &utcTime);
+    strftime(utcTimeString, sizeof(utcTimeString), "%Y-%m-%dT%H:%M:%S", &utcTime);     // as RTCTime::toString() - heap free
+    logger.Printf(Logger::RecType::NtpRef, "%u.%06u;%u.%06u;%s;server=%s;delay=%uus;err=%dus;freq=%dppb;poll=%us%s",
+                  (uint32_t)(sample._monotonicUSecs / 1000000), (uint32_t)(sample._monotonicUSecs % 1000000),
+                  (uint32_t)(utc / 1000000), (uint32_t)(utc % 1000000),
+                  utcTimeString,
+                  NetworkTask::IPToString(_serverIPAddresses[best]).c_str(),
+                  sample._delayUSecs,
+                  status._lastErrorUSecs,
+                  status._freqPpb,
+                  _pollInSecs,
+                  stepped ? ";stepped" : "");
+
+    // The RTC only has 1 sec resolution - it is only set when stepping or when it has wandered off
+    uint64_t utcNow;
+    RTCTime rtcNow;
+    if (timeService.UtcNow(utcNow) && RTC.getTime(rtcNow))
+    {
+        int64_t const rtcError = (int64_t)rtcNow.getUnixTime() - (int64_t)(utcNow / 1000000);
+        if (stepped || (rtcError >= 2) || (rtcError <= -2))
+        {
+            RTCTime newTime(time_t(utcNow / 1000000));
+            if (!RTC.setTime(newTime))
+            {
+                $Log(NTP, Warning, "NtpClient: RTC.setTime() failed!");
+            }
+        }
+    }
+
+    return _pollInSecs * 1000;
+}
+
+void NTPClient::PrintStatus(Stream& ToStream)
+{
+    TimeService::Status status;
+    timeService.GetStatus(status);
+
+    printf(ToStream, "NTP: Server: %s; Poll: %us; Last delay: %uus\n",
+           (_selectedServer >= 0) ? NetworkTask::IPToString(_serverIPAddresses[_selectedServer]).c_str() : "none",
+           _pollInSecs, _lastDelayUSecs);
+    printf(ToStream, "NTP: Last error: %dus; Slewing: %dus; Freq: %dppb%s; Samples: %u; Steps: %u\n",
+           status._lastErrorUSecs, status._slewUSecs, status._freqPpb,
+           status._driftEstimated ? " (estimated)" : "",
+           status._samples, status._steps);
+}
+
 void NTPClient::sendNTPpacket()
 {
     memset(_packetBuffer, 0, _ntpPacketSize);
@@ -169,7 +332,12 @@ void NTPClient::sendNTPpacket()
     _packetBuffer[14] = 49;
     _packetBuffer[15] = 52;
 
-    _udp->beginPacket(_timeServerIPAddress, _ntpPort);
+    // Transmit timestamp: T1 in monotonic uSecs - the server echoes it back as the originate timestamp so
+    // the response can be matched to this request
+    _requestSentAt = timeService.MonotonicNow();
+    PutUInt64(&_packetBuffer[40], _requestSentAt);
+
+    _udp->beginPacket(_serverIPAddresses[_serverIx], _ntpPort);
     _udp->write(_packetBuffer, _ntpPacketSize);
     _udp->endPacket();
 }
@@ -4,19 +4,51 @@
 #pragma once
 #include "SpaHeaterCntl.hpp"
 
+//* SNTP client - disciplines timeService (and the RTC) from a small set of NTP servers. Each poll measures
+//  offset and round trip delay from the four NTP timestamps; a full round queries every server and selects
+//  the lowest delay one, which is then polled alone between rounds. The poll interval adapts between
+//  _minPollInSecs and _maxPollInSecs once timeService has estimated the clock's drift.
 class NTPClient : public ArduinoTask
 {
+public:
+    void PrintStatus(Stream& ToStream);
+
 private:
+    // One server's measurement in the current round
+    struct Sample
+    {
+        bool        _valid;
+        uint64_t    _monotonicUSecs;        // T4 - when the response was received
+        int64_t     _offsetUSecs;           // UTC - monotonic
+        uint32_t    _delayUSecs;            // round trip, less the server's processing time
+    };
+
     constexpr static uint32_t _ntpPacketSize = 48;
     constexpr static char *_timeServerIP = "192.168.3.202"; // core2.maxie.hasha.org
     constexpr static uint16_t _ntpPort = 123;
     constexpr static uint32_t _localPort = 2390;
+    constexpr static int _serverCount = 3;
+    constexpr static uint32_t _minPollInSecs = 64;
+    constexpr static uint32_t _maxPollInSecs = 1024;
+    constexpr static uint32_t _fullRoundEvery = 8;              // polls of the selected server between full rounds
+    constexpr static int32_t _pollUpErrorUSecs = 4000;          // mapping error below which the poll interval grows
+    constexpr static int32_t _pollDownErrorUSecs = 16000;       // and above which it shrinks
     uint8_t _packetBuffer[_ntpPacketSize];
-    shared_ptr<UDP> _udp;
-    IPAddress _timeServerIPAddress;
+    UDPHandle _udp;
+    IPAddress _serverIPAddresses[_serverCount];
+    Sample _samples[_serverCount];
+    int _serverIx;                          // being queried
+    int _selectedServer;                    // -1: none yet
+    bool _fullRound;
+    uint32_t _pollInSecs;
+    uint32_t _pollCount;
+    uint64_t _requestSentAt;                // T1 - also sent as the transmit timestamp and echoed back
+    uint32_t _lastDelayUSecs;
 
 private:
     void sendNTPpacket();
+    bool ProcessResponse(uint64_t ReceivedAt);
+    uint32_t ApplyRound();
 
 protected:
     virtual void setup() override;
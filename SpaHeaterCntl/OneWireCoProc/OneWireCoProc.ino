@@ -3,12 +3,24 @@
 
 DS18B20 ds(2);
 
-void ResetISR() 
+void ResetISR()
 {
     asm volatile ("jmp 0");         // Cause software reset
 }
 
-void setup() 
+// Sampling policy as last sent by the R4 (SP command). Until one is received the bus is enumerated
+// continuously - the original free running behavior.
+static uint32_t     busPeriodInMS = 0;              // 0: free running
+static uint32_t     controlPeriodInMS = 0;          // 0: no control sensor only reads
+static uint8_t      controlAddress[8];
+static bool         busEnumDue = true;
+static uint32_t     lastBusEnumTime;
+static uint32_t     lastControlReadTime;
+
+static char         cmdLine[48];
+static uint8_t      cmdLineIx = 0;
+
+void setup()
 {
     Serial.begin(9600);
     delay(1000);
@@ -20,68 +32,179 @@ void setup()
     attachInterrupt(digitalPinToInterrupt(3), ResetISR, FALLING);
 }
 
+// Parse an 8 HEX digit field
+static uint32_t HexToUInt32(const char* Hex)
+{
+    char    digits[9];
 
-void loop() 
-{   
-    delay(20);
+    memcpy(digits, Hex, 8);
+    digits[8] = 0;
+    return strtoul(digits, NULL, 16);
+}
 
-    digitalWrite(LED_BUILTIN, true);
-    Serial.println("ESTART");
-    while (ds.selectNext()) 
+// Process a command line from the R4
+//      SP;<bus period in ms>;<control period in ms>;<control sensor ID - 16 HEX digits>
+static void ProcessCommand(char* Cmd)
+{
+    if (memcmp(Cmd, "SP;", 3) != 0)
     {
-        uint8_t type = ds.getFamilyCode();
+        return;
+    }
 
-        if ((type != MODEL_DS18S20) && (type != MODEL_DS1822) && (type != MODEL_DS18B20))
+    char*       p = &Cmd[3];
+    uint32_t    busPeriod = strtoul(p, &p, 10);
+    if (*p++ != ';') return;
+    uint32_t    controlPeriod = strtoul(p, &p, 10);
+    if (*p++ != ';') return;
+    if (strlen(p) != 16) return;
+
+    uint32_t    idHigh = HexToUInt32(p);
+    uint32_t    idLow = HexToUInt32(p + 8);
+
+    // The sensor ID is the little endian image of the sensor's 8 byte address
+    for (uint8_t ix = 0; ix < 4; ix++)
+    {
+        controlAddress[ix] = uint8_t(idLow >> (ix * 8));
+        controlAddress[ix + 4] = uint8_t(idHigh >> (ix * 8));
+    }
+
+    busPeriodInMS = busPeriod;
+    controlPeriodInMS = ((idHigh | idLow) != 0) ? controlPeriod : 0;
+    busEnumDue = true;                  // Start the new policy with a full enumeration
+}
+
+static void PollForCommands()
+{
+    while (Serial.available())
+    {
+        char c = Serial.read();
+        if (c == '\n')
         {
-            return;
+            continue;
         }
 
-        uint64_t    addr;
+        if (c == '\r')
         {
-            uint8_t address[8];
-            ds.getAddress(address);
-
-            addr = *((uint64_t*)(&address[0]));
+            cmdLine[cmdLineIx] = 0;
+            ProcessCommand(cmdLine);
+            cmdLineIx = 0;
+        }
+        else if (cmdLineIx < (sizeof(cmdLine) - 1))
+        {
+            cmdLine[cmdLineIx++] = c;
+        }
+        else
+        {
+            cmdLineIx = 0;              // Overflow - drop the line
         }
+    }
+}
+
+// Read the currently selected sensor and send its state line to the R4
+static void SendSelectedSensor(uint8_t Type)
+{
+    uint64_t    addr;
+    {
+        uint8_t address[8];
+        ds.getAddress(address);
+
+        addr = *((uint64_t*)(&address[0]));
+    }
 
-        uint8_t res = ds.getResolution();
-        float temp = ds.getTempC();
-        const uint32_t& tempEnc = ((uint32_t)temp);
+    uint8_t res = ds.getResolution();
+    float temp = ds.getTempC();
+    const uint32_t& tempEnc = ((uint32_t)temp);
 
-        static char hexChars[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
+    static char hexChars[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
 
-        static auto ByteToAsciiHex = [] (uint8_t Byte, char* Out) -> void
-        {
-            *Out = hexChars[(Byte>>4) & 0x0F];
-            *(Out+1) = hexChars[(Byte >> 0) & 0x0F];
-        };
+    static auto ByteToAsciiHex = [] (uint8_t Byte, char* Out) -> void
+    {
+        *Out = hexChars[(Byte>>4) & 0x0F];
+        *(Out+1) = hexChars[(Byte >> 0) & 0x0F];
+    };
 
-        static auto ToAscii = [] (uint32_t Uint32, char* Out) -> void
+    static auto ToAscii = [] (uint32_t Uint32, char* Out) -> void
+    {
+        ByteToAsciiHex(uint8_t(Uint32 >> 24), Out);
+        ByteToAsciiHex(uint8_t(Uint32 >> 16), Out+2);
+        ByteToAsciiHex(uint8_t(Uint32 >> 8), Out+4);
+        ByteToAsciiHex(uint8_t(Uint32 >> 0), Out+6);
+    };
+
+  //  XXXXXXXXXXXXXXXX;XX;XX;FFFFFFFF<\n>
+  //  01234567890123456789012345678901
+    static char        s[32];
+    // sprintf(&s[0], "%08lX%08lX;%02X;%02X;", (uint32_t)(addr >> 32), (uint32_t)addr, type, res);
+
+    ToAscii((uint32_t)(addr>>32), &s[0]);
+    ToAscii((uint32_t)(addr), &s[8]);
+    s[16] = ';';
+    ByteToAsciiHex(Type, &s[17]);
+    s[19] = ';';
+    ByteToAsciiHex(res, &s[20]);
+    s[22] = ';';
+    ToAscii(tempEnc, &s[23]);
+    s[31] = 0;
+    Serial.print(s);
+    Serial.println();
+    Serial.flush();
+}
+
+// Full bus enumeration: ESTART, <sensor line>*, ESTOP
+static void EnumerateBus()
+{
+    digitalWrite(LED_BUILTIN, true);
+    Serial.println("ESTART");
+    while (ds.selectNext())
+    {
+        uint8_t type = ds.getFamilyCode();
+
+        if ((type != MODEL_DS18S20) && (type != MODEL_DS1822) && (type != MODEL_DS18B20))
         {
-            ByteToAsciiHex(uint8_t(Uint32 >> 24), Out);
-            ByteToAsciiHex(uint8_t(Uint32 >> 16), Out+2);
-            ByteToAsciiHex(uint8_t(Uint32 >> 8), Out+4);
-            ByteToAsciiHex(uint8_t(Uint32 >> 0), Out+6);
-        };
-
-      //  XXXXXXXXXXXXXXXX;XX;XX;FFFFFFFF<\n>
-      //  01234567890123456789012345678901
-        static char        s[32];
-        // sprintf(&s[0], "%08lX%08lX;%02X;%02X;", (uint32_t)(addr >> 32), (uint32_t)addr, type, res);
-
-        ToAscii((uint32_t)(addr>>32), &s[0]);
-        ToAscii((uint32_t)(addr), &s[8]);
-        s[16] = ';';
-        ByteToAsciiHex(type, &s[17]);
-        s[19] = ';';
-        ByteToAsciiHex(res, &s[20]);
-        s[22] = ';';
-        ToAscii(tempEnc, &s[23]);
-        s[31] = 0;
-        Serial.print(s);
-        Serial.println();
-        Serial.flush();
+            return;
+        }
+
+        SendSelectedSensor(type);
     }
     Serial.println("ESTOP");
     digitalWrite(LED_BUILTIN, false);
 }
+
+// Partial (control sensor only) enumeration: ESTARTP, <sensor line>?, ESTOP
+static void ReadControlSensor()
+{
+    digitalWrite(LED_BUILTIN, true);
+    Serial.println("ESTARTP");
+    if (ds.select(controlAddress))
+    {
+        SendSelectedSensor(ds.getFamilyCode());
+    }
+    Serial.println("ESTOP");
+    digitalWrite(LED_BUILTIN, false);
+}
+
+void loop()
+{
+    PollForCommands();
+
+    uint32_t now = millis();
+
+    if (busPeriodInMS == 0)
+    {
+        // No policy from the R4 - free run
+        delay(20);
+        EnumerateBus();
+    }
+    else if (busEnumDue || ((now - lastBusEnumTime) >= busPeriodInMS))
+    {
+        busEnumDue = false;
+        lastBusEnumTime = now;
+        lastControlReadTime = now;
+        EnumerateBus();
+    }
+    else if ((controlPeriodInMS != 0) && ((now - lastControlReadTime) >= controlPeriodInMS))
+    {
+        lastControlReadTime = now;
+        ReadControlSensor();
+    }
+}
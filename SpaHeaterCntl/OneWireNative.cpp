@@ -0,0 +1,101 @@
+/*
+    OneWireNative Implementation - Timer interrupt driven 1-Wire bus master
+
+    Copyright TinyBus 2024
+*/
+#include "OneWireNative.hpp"
+
+constexpr OneWireNativeBase::Slot OneWireNativeBase::ResetSlot;
+constexpr OneWireNativeBase::Slot OneWireNativeBase::Write1Slot;
+constexpr OneWireNativeBase::Slot OneWireNativeBase::Write0Slot;
+constexpr OneWireNativeBase::Slot OneWireNativeBase::ReadSlot;
+
+// Dallas/Maxim CRC8 (x^8 + x^5 + x^4 + 1) - used for ROM codes and the scratchpad
+uint8_t OneWireNativeBase::Crc8(const uint8_t* Bytes, uint8_t Length)
+{
+    uint8_t crc = 0;
+
+    while (Length--)
+    {
+        uint8_t byte = *Bytes++;
+        for (uint8_t ix = 0; ix < 8; ix++)
+        {
+            uint8_t const mix = (crc ^ byte) & 0x01;
+            crc >>= 1;
+            if (mix)
+                crc ^= 0x8C;
+            byte >>= 1;
+        }
+    }
+    return crc;
+}
+
+#if defined(ARDUINO_UNOR4_WIFI) || defined(ARDUINO_UNOR4_MINIMA)
+//** GptOneWireBus implementation
+GptOneWireBus::GptOneWireBus()
+    :   _timerCountsPerUSec(0),
+        _isRunning(false),
+        _pin(0),
+        _onTimer(nullptr),
+        _context(nullptr)
+{
+}
+
+/**
+ * @brief Configures the bus pin and claims a GPT timer for the slot timing.
+ *
+ * @return false if no GPT timer is available.
+ */
+bool GptOneWireBus::Begin(uint8_t Pin, void (*OnTimer)(void*), void* Context)
+{
+    _pin = Pin;
+    _onTimer = OnTimer;
+    _context = Context;
+    pinMode(_pin, OUTPUT_OPENDRAIN);
+    Release();
+
+    uint8_t timerType = GPT_TIMER;
+    int8_t channel = FspTimer::get_available_timer(timerType);
+    if ((channel < 0) || (timerType != GPT_TIMER))
+    {
+        return false;
+    }
+
+    // Run the GPT directly off PCLKD so a slot edge is a whole number of counts - the initial period is
+    // replaced by the first Arm()
+    _timerCountsPerUSec = R_FSP_SystemClockHzGet(FSP_PRIV_CLOCK_PCLKD) / 1000000;
+    if (!_timer.begin(TIMER_MODE_PERIODIC, timerType, channel, 1000 * _timerCountsPerUSec, 0,
+                      TIMER_SOURCE_DIV_1, TimerCallback, this) ||
+        !_timer.setup_overflow_irq() ||
+        !_timer.open())
+    {
+        return false;
+    }
+
+    return true;
+}
+
+// Arms the timer to fire once, USecs after the edge being handled - or from now if the timer is stopped
+void GptOneWireBus::Arm(uint32_t USecs)
+{
+    // Stopping the GPT first makes the new period take effect immediately rather than at the next overflow.
+    // The counter has run since the last edge (periodic mode restarts it from 0 at the overflow) - that is the
+    // interrupt latency so far, so it comes off the new period rather than adding to the slot phase
+    _timer.stop();
+    uint32_t const elapsed = _isRunning ? _timer.get_counter() : 0;
+    uint32_t const period = USecs * _timerCountsPerUSec;
+    _timer.reset();
+    _timer.set_period((period > (elapsed + _timerCountsPerUSec)) ? (period - elapsed) : _timerCountsPerUSec);
+    _timer.start();
+    _isRunning = true;
+}
+
+void GptOneWireBus::TimerCallback(timer_callback_args_t* Args)
+{
+    if (Args->event == TIMER_EVENT_CYCLE_END)
+    {
+        GptOneWireBus* const bus = (GptOneWireBus*)Args->p_context;
+        bus->_onTimer(bus->_context);
+    }
+}
+#endif
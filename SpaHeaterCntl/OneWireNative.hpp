@@ -0,0 +1,465 @@
+/*
+    OneWireNative Definitions - Timer interrupt driven 1-Wire bus master
+
+    Copyright TinyBus 2024
+*/
+#pragma once
+
+#include "common.hpp"
+#include <atomic>
+
+//** Bus access for BasicOneWireNative
+//
+// A bus is a class providing the line and slot timer access - the only hardware the driver touches:
+//
+//      bool Begin(uint8_t Pin, void (*OnTimer)(void*), void* Context);   // OnTimer(Context) is called from the timer ISR
+//      void DriveLow();                                                    // pull the line low
+//      void Release();                                                     // let the pull-up take it high
+//      bool Sample();                                                      // true if the line is high
+//      void Arm(uint32_t USecs);                                           // call OnTimer once, USecs after the timer
+//                                                                          // edge being handled (from now once stopped)
+//      void Stop();                                                        // cancel any armed call
+//
+// Arm() times each edge from the previous one, not from when the ISR got to re-arm the timer - so the interrupt
+// latency is not added to every phase of a slot.
+//
+// GptOneWireBus (below) is the R4 implementation; a simulated bus lets the driver run on the host (see Tests/).
+
+/**
+ * @brief Bus independent parts of the 1-Wire master - status, commands, slot shapes and CRC.
+ */
+class OneWireNativeBase
+{
+public:
+    enum class Status : uint8_t
+    {
+        Idle,           // No transaction started since Begin()
+        Busy,           // Transaction in progress in the ISR
+        Done,           // Transaction complete; results are valid
+        NoPresence,     // No device answered the bus reset
+        SearchFailed,   // Search ROM found no device (both bit and complement read as 1)
+    };
+
+    // Driver counters - written in the ISR; read with GetStats()
+    struct Stats
+    {
+        uint32_t    _transactionCount;
+        uint32_t    _noPresenceCount;
+        uint32_t    _searchFailedCount;
+        uint32_t    _slotCount;
+    };
+
+    static constexpr uint8_t    MaxTxBytes = 10;        // Match ROM (1 + 8) + function command
+    static constexpr uint8_t    MaxRxBytes = 9;         // DS18x20 scratchpad
+
+    // ROM and function commands
+    static constexpr uint8_t    SearchRomCmd = 0xF0;
+    static constexpr uint8_t    MatchRomCmd = 0x55;
+    static constexpr uint8_t    SkipRomCmd = 0xCC;
+    static constexpr uint8_t    ConvertTCmd = 0x44;
+    static constexpr uint8_t    ReadScratchpadCmd = 0xBE;
+
+    static uint8_t Crc8(const uint8_t* Bytes, uint8_t Length);
+
+protected:
+    // One time slot - all times in uSecs from the falling edge
+    struct Slot
+    {
+        uint16_t    _lowUSecs;
+        uint16_t    _sampleAtUSecs;     // zero if the line is not sampled
+        uint16_t    _slotUSecs;
+    };
+    static constexpr Slot   ResetSlot = {480, 550, 960};     // presence sampled 70us after release
+    static constexpr Slot   Write1Slot = {6, 0, 70};
+    static constexpr Slot   Write0Slot = {60, 0, 70};
+    static constexpr Slot   ReadSlot = {3, 12, 70};      // sampled well before the 15us the data is valid for
+
+    enum class Phase : uint8_t
+    {
+        Low,            // Line driven low
+        Released,       // Line released - waiting to sample
+        Recover,        // Waiting for the end of the slot
+    };
+
+    enum class Stage : uint8_t
+    {
+        Reset,
+        Tx,
+        Rx,
+        SearchBit,      // Reading the ROM bit
+        SearchCompBit,  // Reading the complement of the ROM bit
+        SearchWrite,    // Writing the selected direction
+    };
+
+    static inline bool GetBit(const uint8_t* Bytes, uint8_t BitIx) { return (Bytes[BitIx >> 3] >> (BitIx & 7)) & 1; }
+    static inline void SetBit(uint8_t* Bytes, uint8_t BitIx, bool Bit)
+    {
+        if (Bit) Bytes[BitIx >> 3] |= (1 << (BitIx & 7));
+        else     Bytes[BitIx >> 3] &= ~(1 << (BitIx & 7));
+    }
+};
+
+/**
+ * @brief Non-blocking 1-Wire bus master driven from a timer interrupt.
+ *
+ * A transaction (bus reset + N bytes written + M bytes read) or a single Search ROM pass is handed to
+ * the driver with StartTransaction()/StartSearch() and then runs entirely in the timer ISR, one time
+ * slot at a time: the ISR drives the line low, releases it, samples it and re-arms the timer for the
+ * next edge. The calling task only polls GetStatus() - it never spins or waits on the bus.
+ *
+ * Every time slot has the same shape: the line is held low for _lowUSecs, released, optionally sampled
+ * at _sampleAtUSecs, and the slot ends at _slotUSecs (all relative to the falling edge). Bus resets
+ * and read/write bit slots only differ in those three numbers (see Maxim AN126 standard speed).
+ *
+ * Results (the read bytes and the search ROM) are written by the ISR before it publishes the final
+ * status; GetStatus()/IsBusy() read the status with acquire ordering, so they are valid once either
+ * reports the transaction is over.
+ *
+ * @tparam TBus The line and timer access (see above).
+ */
+template <typename TBus>
+class BasicOneWireNative : public OneWireNativeBase
+{
+public:
+    BasicOneWireNative()
+        :   _status(Status::Idle)
+    {
+        memset(&_stats, 0, sizeof(_stats));
+        ResetSearch();
+    }
+
+    ~BasicOneWireNative()
+    {
+        $FailFast();
+    }
+
+    // Configures the bus pin and claims the slot timer - false if the bus could not be set up
+    bool Begin(uint8_t Pin)
+    {
+        return _bus.Begin(Pin, OnTimer, this);
+    }
+
+    // Start a transaction: reset, write TxLen bytes, read RxLen bytes. Only valid when not Busy.
+    void StartTransaction(const uint8_t* Tx, uint8_t TxLen, uint8_t RxLen)
+    {
+        $Assert(_status != Status::Busy);
+        $Assert((TxLen <= MaxTxBytes) && (RxLen <= MaxRxBytes));
+
+        memcpy(_txBytes, Tx, TxLen);
+        _txLen = TxLen;
+        _rxLen = RxLen;
+        memset(_rxBytes, 0, sizeof(_rxBytes));
+        _isSearch = false;
+
+        _stage = Stage::Reset;
+        _status = Status::Busy;
+        StartSlot(ResetSlot);
+    }
+
+    // Search ROM support - ResetSearch() then StartSearch() until a Done pass reports IsLastDevice()
+    void ResetSearch()
+    {
+        memset(_rom, 0, sizeof(_rom));
+        _lastDiscrepancy = 0;
+        _lastDeviceFlag = false;
+    }
+
+    // Starts one Search ROM pass; on Done GetSearchRom() holds the next device's ROM code
+    void StartSearch()
+    {
+        $Assert(_status != Status::Busy);
+        $Assert(!_lastDeviceFlag);
+
+        _txBytes[0] = SearchRomCmd;
+        _txLen = 1;
+        _rxLen = 0;
+        _isSearch = true;
+        _lastZero = 0;
+
+        _stage = Stage::Reset;
+        _status = Status::Busy;
+        StartSlot(ResetSlot);
+    }
+
+    inline bool IsLastDevice() const { return _lastDeviceFlag; }
+    inline uint64_t GetSearchRom() const
+    {
+        uint64_t rom;
+        memcpy(&rom, _rom, sizeof(rom));
+        return rom;
+    }
+
+    inline Status GetStatus() const
+    {
+        Status const status = _status;
+        std::atomic_thread_fence(std::memory_order_acquire);        // pairs with the release in Finish()
+        return status;
+    }
+    inline bool IsBusy() const { return GetStatus() == Status::Busy; }
+    inline const uint8_t* GetRxBytes() const { return &_rxBytes[0]; }
+
+    void GetStats(Stats& Stats)
+    {
+        synchronized
+        {
+            Stats = _stats;
+        }
+    }
+
+    inline TBus& GetBus() { return _bus; }
+
+private:
+    //** ISR side
+    static void OnTimer(void* Context)
+    {
+        ((BasicOneWireNative*)Context)->OnSlotEdge();
+    }
+
+    void OnSlotEdge()
+    {
+        switch (_phase)
+        {
+            case Phase::Low:
+            {
+                _bus.Release();
+                if (_slot._sampleAtUSecs != 0)
+                {
+                    _phase = Phase::Released;
+                    _bus.Arm(_slot._sampleAtUSecs - _slot._lowUSecs);
+                }
+                else
+                {
+                    _phase = Phase::Recover;
+                    _bus.Arm(_slot._slotUSecs - _slot._lowUSecs);
+                }
+            }
+            break;
+
+            case Phase::Released:
+            {
+                _sampledBit = _bus.Sample();
+                _phase = Phase::Recover;
+                _bus.Arm(_slot._slotUSecs - _slot._sampleAtUSecs);
+            }
+            break;
+
+            case Phase::Recover:
+            {
+                _bus.Stop();
+                _stats._slotCount++;
+                SlotComplete();
+            }
+            break;
+
+            default:
+            {
+                $FailFast();
+            }
+        }
+    }
+
+    void StartSlot(const Slot& NextSlot)
+    {
+        _slot = NextSlot;
+        _phase = Phase::Low;
+        _bus.DriveLow();
+        _bus.Arm(_slot._lowUSecs);
+    }
+
+    // Consume the result of the slot just completed and advance the transaction
+    void SlotComplete()
+    {
+        switch (_stage)
+        {
+            case Stage::Reset:
+            {
+                if (_sampledBit)                        // Nobody pulled the line low - no presence pulse
+                {
+                    Finish(Status::NoPresence);
+                    return;
+                }
+                _bitIx = 0;
+                _stage = Stage::Tx;
+            }
+            break;
+
+            case Stage::Tx:
+            {
+                if (++_bitIx == (_txLen * 8))
+                {
+                    _bitIx = 0;
+                    _stage = _isSearch ? Stage::SearchBit : Stage::Rx;
+                }
+            }
+            break;
+
+            case Stage::Rx:
+            {
+                SetBit(_rxBytes, _bitIx, _sampledBit);
+                _bitIx++;
+            }
+            break;
+
+            case Stage::SearchBit:
+            {
+                _idBit = _sampledBit;
+                _stage = Stage::SearchCompBit;
+            }
+            break;
+
+            case Stage::SearchCompBit:
+            {
+                bool direction;
+                uint8_t const bitNumber = _bitIx + 1;
+
+                if (_idBit && _sampledBit)
+                {
+                    Finish(Status::SearchFailed);       // No devices participating
+                    return;
+                }
+                else if (_idBit != _sampledBit)
+                {
+                    direction = _idBit;                 // All remaining devices agree
+                }
+                else
+                {
+                    // Discrepancy - follow the previous pass up to the last discrepancy, then take the 1 branch
+                    // at it and the 0 branch beyond it
+                    if (bitNumber < _lastDiscrepancy)
+                        direction = GetBit(_rom, _bitIx);
+                    else
+                        direction = (bitNumber == _lastDiscrepancy);
+
+                    if (!direction)
+                        _lastZero = bitNumber;
+                }
+
+                SetBit(_rom, _bitIx, direction);
+                _stage = Stage::SearchWrite;
+            }
+            break;
+
+            case Stage::SearchWrite:
+            {
+                if (++_bitIx == 64)
+                {
+                    _lastDiscrepancy = _lastZero;
+                    _lastDeviceFlag = (_lastDiscrepancy == 0);
+                    Finish(Status::Done);
+                    return;
+                }
+                _stage = Stage::SearchBit;
+            }
+            break;
+
+            default:
+            {
+                $FailFast();
+            }
+        }
+
+        StartNextSlot();
+    }
+
+    void StartNextSlot()
+    {
+        switch (_stage)
+        {
+            case Stage::Tx:
+                StartSlot(GetBit(_txBytes, _bitIx) ? Write1Slot : Write0Slot);
+                break;
+
+            case Stage::Rx:
+                if (_bitIx == (_rxLen * 8))
+                    Finish(Status::Done);
+                else
+                    StartSlot(ReadSlot);
+                break;
+
+            case Stage::SearchBit:
+            case Stage::SearchCompBit:
+                StartSlot(ReadSlot);
+                break;
+
+            case Stage::SearchWrite:
+                StartSlot(GetBit(_rom, _bitIx) ? Write1Slot : Write0Slot);
+                break;
+
+            default:
+                $FailFast();
+        }
+    }
+
+    void Finish(Status Result)
+    {
+        _stats._transactionCount++;
+        if (Result == Status::NoPresence)
+            _stats._noPresenceCount++;
+        else if (Result == Status::SearchFailed)
+            _stats._searchFailedCount++;
+
+        std::atomic_thread_fence(std::memory_order_release);        // results are visible before the status
+        _status = Result;
+    }
+
+private:
+    TBus                _bus;
+
+    volatile Status     _status;
+    Stats               _stats;
+
+    // Current slot
+    Slot                _slot;
+    Phase               _phase;
+    bool                _sampledBit;
+
+    // Current transaction
+    Stage               _stage;
+    bool                _isSearch;
+    uint8_t             _bitIx;
+    uint8_t             _txBytes[MaxTxBytes];
+    uint8_t             _txLen;
+    uint8_t             _rxBytes[MaxRxBytes];
+    uint8_t             _rxLen;
+
+    // Search ROM state (Maxim AN187) - bit numbers are 1 based; 0 means none
+    uint8_t             _rom[8];
+    uint8_t             _lastDiscrepancy;
+    uint8_t             _lastZero;
+    bool                _lastDeviceFlag;
+    bool                _idBit;
+};
+
+#if defined(ARDUINO_UNOR4_WIFI) || defined(ARDUINO_UNOR4_MINIMA)
+#include <FspTimer.h>
+
+/**
+ * @brief R4 bus - a GPT timer (run directly off PCLKD so a slot edge is a whole number of counts) and the
+ * bus pin configured as open drain. An external pull-up (4.7K) is required.
+ */
+class GptOneWireBus
+{
+public:
+    GptOneWireBus();
+
+    bool Begin(uint8_t Pin, void (*OnTimer)(void*), void* Context);
+    inline void DriveLow() { digitalWrite(_pin, LOW); }
+    inline void Release() { digitalWrite(_pin, HIGH); }
+    inline bool Sample() { return digitalRead(_pin) == HIGH; }
+    void Arm(uint32_t USecs);
+    inline void Stop() { _timer.stop(); _isRunning = false; }
+
+private:
+    static void TimerCallback(timer_callback_args_t* Args);
+
+private:
+    FspTimer            _timer;
+    uint32_t            _timerCountsPerUSec;
+    bool                _isRunning;         // the counter holds the time since the last edge
+    uint8_t             _pin;
+    void                (*_onTimer)(void*);
+    void*               _context;
+};
+
+typedef BasicOneWireNative<GptOneWireBus> OneWireNative;
+#endif
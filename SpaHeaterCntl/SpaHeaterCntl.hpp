@@ -5,13 +5,12 @@
 #include <Arduino.h>
 #include <RTC.h>
 #include <time.h>
-#include <vector>
-#include <stack>
 #include <Arduino_FreeRTOS.h>
 
 using namespace std;
 
 #include "common.hpp"
+#include "StaticContainers.hpp"
 #include "clilib.hpp"
 #include "FlashStore.hpp"
 #include "BoilerControllerTask.hpp"
@@ -20,6 +19,8 @@ using namespace std;
 #include "Network.hpp"
 #include "MQTT_HA.hpp"
 #include "NtpClient.hpp"
+#include "TimeService.hpp"
+#include "MemoryMonitor.hpp"
 
 
 
@@ -6,14 +6,7 @@ static_assert(configTOTAL_HEAP_SIZE == 0x1400, "freeRTOS heap is not the correct
 // See: C:\Users\richhas.MAXIE\AppData\Local\Arduino15\packages\arduino\hardware\renesas_uno\1.0.5\variants\UNO*\defines.txt
 
 // Tasks to add:
-//    Not WiFi dependent:
-//      DiagLog store and fwd
-//
 //    TODO:
-//      - Change log prints to use correct log levels
-//      - Add a log level into system config
-//      - Config:
-//          - Use end of 8K for circular log buffer
 //      - NetworkTask - make independent of WiFi. Support ethernet and WiFi
 //      - Make dual targeted - UNO R4 Minima (Ethernet) and UNO R4 Maxie (WiFi)
 //         - ARDUINO_UNOR4_WIFI vs ARDUINO_UNOR4_MINIMA
@@ -30,8 +23,8 @@ class TelnetConsole final : public ArduinoTask
 {
 private:
     ConsoleTask _console;
-    shared_ptr<Server> _server;
-    shared_ptr<Client> _client;
+    ServerHandle _server;
+    ClientHandle _client;
 
 public:
     TelnetConsole();
@@ -54,12 +47,20 @@ struct BootRecord
 //*** Global state objects
 TaskHandle_t    mainThread;
 TaskHandle_t    backgroundThread;
+constexpr uint32_t mainThreadStackDepth = (1024 + 500) / 4;     // in words
+constexpr uint32_t boilerThreadStackDepth = 1024 / 4;           // in words
+#if SPA_STATIC_RTOS
+StackType_t     mainThreadStack[mainThreadStackDepth];
+StaticTask_t    mainThreadTcb;
+StackType_t     boilerThreadStack[boilerThreadStackDepth];
+StaticTask_t    boilerThreadTcb;
+#endif
 TelnetConsole   telnetConsole;
 FlashStore<BootRecord, PS_BootRecordBase> bootRecord;
     static_assert(PS_BootRecordBlkSize >= sizeof(FlashStore<BootRecord, PS_BootRecordBase>));
 
 //* Percounter for the overall foreground system loop
-PerfCounter perfCounterForMainLoop(uSecSystemClock);
+PerfCounter perfCounterForMainLoop;
 
 
 //* Telnet Admin Console Task implementation
@@ -75,7 +76,7 @@ TelnetConsole::~TelnetConsole()
 
 void TelnetConsole::setup()
 {
-    logger.Printf(Logger::RecType::Progress, "TelnetConsole: Starting - listening on port 23...");
+    $Log(Console, Progress, "TelnetConsole: Starting - listening on port 23...");
     _server = move(NetworkTask::CreateServer(23));
     $Assert(_server.get() != nullptr);
     _server->begin();
@@ -120,7 +121,8 @@ void TelnetConsole::loop()
     {
         if (state.IsFirstTime())
         {
-            logger.Printf(Logger::RecType::Info, "TelnetConsole: Client connected");
+            $Log(Console, Info, "TelnetConsole: Client connected");
+            logger.SetTelnetStream(_client.get());
             _console.SetStream(*_client);
             _console.Setup();
             _console.begin(consoleTaskCmdProcessors, LengthOfConsoleTaskCmdProcessors, "Main");
@@ -132,7 +134,8 @@ void TelnetConsole::loop()
         }
         else
         {
-            logger.Printf(Logger::RecType::Info, "TelnetConsole: Client disconnected");
+            logger.SetTelnetStream(nullptr);
+            $Log(Console, Info, "TelnetConsole: Client disconnected");
             _client->stop();
             _client = nullptr;
             state.ChangeState(State::StartServer);
@@ -200,6 +203,19 @@ CmdLine::Status ShowRTCDateTime(Stream &CmdStream, int Argc, char const **Args,
     }
     printf(CmdStream, "Current RTC Date and Time are: %s\n", currentTime.toString().c_str());
 
+    uint64_t const monotonic = timeService.MonotonicNow();
+    uint64_t utc;
+    printf(CmdStream, "Monotonic clock: %u.%06u secs\n", (uint32_t)(monotonic / 1000000), (uint32_t)(monotonic % 1000000));
+    if (timeService.ToUtc(monotonic, utc))
+    {
+        printf(CmdStream, "UTC (NTP disciplined): %s.%06u\n", RTCTime(time_t(utc / 1000000)).toString().c_str(), (uint32_t)(utc % 1000000));
+    }
+    else
+    {
+        printf(CmdStream, "UTC: no NTP reference yet\n");
+    }
+    ntpClient.PrintStatus(CmdStream);
+
     return CmdLine::Status::Ok;
 }
 
@@ -241,6 +257,15 @@ CmdLine::Status ShowPerfCounters(Stream &CmdStream, int Argc, char const **Args,
     printf(CmdStream, "Perf Counter: MQTT loop:\n");
     haMqttClient.GetPerfCounter().Print(CmdStream, 4);
 
+    printf(CmdStream, "Perf Counter: MQTT topic handlers:\n");
+    haMqttClient.PrintDispatchStats(CmdStream, 4);
+
+    printf(CmdStream, "MQTT publishes:\n");
+    haMqttClient.PrintPublishStats(CmdStream, 4);
+
+    printf(CmdStream, "MQTT connects:\n");
+    haMqttClient.PrintConnectStats(CmdStream, 4);
+
     printf(CmdStream, "Perf Counter: Console loop:\n");
     consoleTask.GetPerfCounter().Print(CmdStream, 4);
 
@@ -253,6 +278,20 @@ CmdLine::Status ShowPerfCounters(Stream &CmdStream, int Argc, char const **Args,
     printf(CmdStream, "Perf Counter: Boiler Background Task loop:\n");
     boilerControllerTask.GetPerfCounter().Print(CmdStream, 4);
 
+    printf(CmdStream, "Boiler: Temp Sensor events lost (queue full): %u\n", boilerControllerTask.GetSensorEventOverflows());
+
+    printf(CmdStream, "Logger: Rate limited records suppressed: %u\n", logger.GetTotalSuppressed());
+    for (int ix = 0; ix < (int)Logger::SinkId::Count; ix++)
+    {
+        Logger::Sink::Stats stats;
+        logger.GetSink((Logger::SinkId)ix).GetStats(stats);
+        printf(CmdStream, "Logger: %s sink: records: %u; dropped: %u; queue high water: %u of %u\n",
+               Logger::GetSinkDescription((Logger::SinkId)ix), stats._records, stats._dropped, stats._highWater, stats._queueSize);
+    }
+
+    printf(CmdStream, "Memory:\n");
+    MemoryMonitor::Print(CmdStream, 4);
+
     return CmdLine::Status::Ok;
 }
 
@@ -261,10 +300,158 @@ CmdLine::Status ResetPerfCounters(Stream &CmdStream, int Argc, char const **Args
     perfCounterForMainLoop.Reset();
     network.GetPerfCounter().Reset();
     haMqttClient.GetPerfCounter().Reset();
+    haMqttClient.ResetDispatchStats();
+    haMqttClient.ResetPublishStats();
     consoleTask.GetPerfCounter().Reset();
     telnetConsole.GetPerfCounter().Reset();
     ntpClient.GetPerfCounter().Reset();
     boilerControllerTask.GetPerfCounter().Reset();
+    InstrumentedMutex::ResetAllStats();
+    return CmdLine::Status::Ok;
+}
+
+CmdLine::Status ShowLocks(Stream &CmdStream, int Argc, char const **Args, void *Context)
+{
+    for (InstrumentedMutex* mutex = InstrumentedMutex::GetFirst(); mutex != nullptr; mutex = mutex->GetNext())
+    {
+        InstrumentedMutex::Stats stats;
+        mutex->GetStats(stats);
+
+        printf(CmdStream, "Lock: %s\n", mutex->GetName());
+        printf(CmdStream, "    Acquisitions: %s; contended: ", UInt64ToString(stats._acquisitions));
+        printf(CmdStream, "%s\n", UInt64ToString(stats._contended));
+        printf(CmdStream, "    Wait: avg: %sus; ", UInt64ToString(stats._contended ? (stats._totalWaitInUSecs / stats._contended) : 0));
+        printf(CmdStream, "max: %sus\n", UInt64ToString(stats._maxWaitInUSecs));
+        printf(CmdStream, "    Hold: avg: %sus; ", UInt64ToString(stats._acquisitions ? (stats._totalHoldInUSecs / stats._acquisitions) : 0));
+        printf(CmdStream, "max: %sus\n", UInt64ToString(stats._maxHoldInUSecs));
+        printf(CmdStream, "    Boiler thread: contended: %s; ", UInt64ToString(stats._watchedContended));
+        printf(CmdStream, "worst wait: %sus\n", UInt64ToString(stats._watchedMaxWaitInUSecs));
+    }
+
+    return CmdLine::Status::Ok;
+}
+
+//* 'top' live view - wall time share, loop rate and worst recent latency of each loop, from the loop PerfCounters
+//
+// The loop counters time wall clock, not CPU: a loop's share includes any time another thread preempted it
+// (the boiler thread preempting the main loop and its sub-tasks), so the shares can add up to more than the
+// CPU used. "Outside loops" is the window less both threads' loop time - a lower bound on idle. Per thread
+// CPU (FreeRTOS run-time stats, since boot) is added when the kernel is configured for it.
+//
+struct TopViewRow
+{
+    char const*     _name;
+    PerfCounter&    (*_getCounter)();
+    uint64_t        _lastTotalInUSecs;
+    uint64_t        _lastSamples;
+};
+
+static TopViewRow topViewRows[] =
+{
+    {"Main loop",       []() -> PerfCounter& { return perfCounterForMainLoop; }},
+    {"  Console",       []() -> PerfCounter& { return consoleTask.GetPerfCounter(); }},
+    {"  Telnet",        []() -> PerfCounter& { return telnetConsole.GetPerfCounter(); }},
+    {"  Network",       []() -> PerfCounter& { return network.GetPerfCounter(); }},
+    {"  MQTT",          []() -> PerfCounter& { return haMqttClient.GetPerfCounter(); }},
+    {"  NTP",           []() -> PerfCounter& { return ntpClient.GetPerfCounter(); }},
+    {"Boiler thread",   []() -> PerfCounter& { return boilerControllerTask.GetPerfCounter(); }},
+};
+static constexpr int topViewMainRow = 0;
+static constexpr int topViewBoilerRow = (sizeof(topViewRows) / sizeof(topViewRows[0])) - 1;
+
+static void PrintTopViewLine(Stream &ToStream, char const* Name, uint64_t BusyInUSecs, uint64_t WindowInUSecs)
+{
+    uint32_t const permille = (uint32_t)((BusyInUSecs * 1000) / WindowInUSecs);
+    printf(ToStream, "%-16s %3u.%u%%\x1b[K\r\n", Name, permille / 10, permille % 10);
+}
+
+void TopView(Stream &ToStream, bool FirstTime)
+{
+    static uint64_t lastTime = 0;
+    uint64_t const now = MonotonicClock::NowInUSecs();
+    uint64_t const window = now - lastTime;
+    lastTime = now;
+
+    if (FirstTime)
+    {
+        for (auto& row : topViewRows)
+        {
+            row._lastTotalInUSecs = row._getCounter().TotalTimeInUSecs();
+            row._lastSamples = row._getCounter().TotalSamples();
+            row._getCounter().TakeRecentMaxTimeInUSecs();
+        }
+        ToStream.print("\x1b[2J\x1b[HSampling... (any key to exit)\r\n");
+        return;
+    }
+
+    ToStream.print("\x1b[H");
+    printf(ToStream, "top - loop wall time, window %ums (any key to exit)\x1b[K\r\n", (uint32_t)(window / 1000));
+    printf(ToStream, "%-16s %6s %10s %12s\x1b[K\r\n", "Loop", "Wall", "Loops/s", "Worst(us)");
+
+    uint64_t busy[sizeof(topViewRows) / sizeof(topViewRows[0])];
+    uint64_t subTasksBusy = 0;
+    for (int ix = 0; ix < (int)(sizeof(topViewRows) / sizeof(topViewRows[0])); ix++)
+    {
+        TopViewRow& row = topViewRows[ix];
+        PerfCounter& counter = row._getCounter();
+        uint64_t const total = counter.TotalTimeInUSecs();
+        uint64_t const samples = counter.TotalSamples();
+
+        // a perfReset in the window restarts the counters
+        busy[ix] = (total >= row._lastTotalInUSecs) ? (total - row._lastTotalInUSecs) : total;
+        uint64_t const loops = (samples >= row._lastSamples) ? (samples - row._lastSamples) : samples;
+        row._lastTotalInUSecs = total;
+        row._lastSamples = samples;
+
+        if ((ix != topViewMainRow) && (ix != topViewBoilerRow))
+        {
+            subTasksBusy += busy[ix];
+        }
+
+        uint32_t const permille = (uint32_t)((busy[ix] * 1000) / window);
+        printf(ToStream, "%-16s %3u.%u%% %10u %12u\x1b[K\r\n",
+            row._name, permille / 10, permille % 10, 
+            (uint32_t)((loops * 1000000) / window), (uint32_t)counter.TakeRecentMaxTimeInUSecs());
+    }
+
+    uint64_t const mainBusy = busy[topViewMainRow];
+    uint64_t const accounted = mainBusy + busy[topViewBoilerRow];
+    PrintTopViewLine(ToStream, "  Other", (mainBusy > subTasksBusy) ? (mainBusy - subTasksBusy) : 0, window);
+    PrintTopViewLine(ToStream, "Outside loops", (window > accounted) ? (window - accounted) : 0, window);
+
+#if (configGENERATE_RUN_TIME_STATS == 1) && (configUSE_TRACE_FACILITY == 1)
+    static TaskStatus_t threads[8];
+    uint32_t totalRunTime;
+    UBaseType_t const nbrOfThreads = uxTaskGetSystemState(threads, sizeof(threads) / sizeof(threads[0]), &totalRunTime);
+
+    printf(ToStream, "\x1b[K\r\n%-16s %6s (since boot)\x1b[K\r\n", "Thread", "CPU");
+    for (UBaseType_t ix = 0; (ix < nbrOfThreads) && (totalRunTime > 0); ix++)
+    {
+        uint32_t const permille = (uint32_t)(((uint64_t)threads[ix].ulRunTimeCounter * 1000) / totalRunTime);
+        printf(ToStream, "%-16s %3u.%u%%\x1b[K\r\n", threads[ix].pcTaskName, permille / 10, permille % 10);
+    }
+#endif
+
+    ToStream.print("\x1b[J");
+}
+
+CmdLine::Status ShowTop(Stream &CmdStream, int Argc, char const **Args, void *Context)
+{
+    uint32_t refreshInMs = 2000;
+    if (Argc > 2)
+    {
+        return CmdLine::Status::TooManyParameters;
+    }
+    if (Argc == 2)
+    {
+        refreshInMs = atoi(Args[1]) * 1000;
+        if (refreshInMs == 0)
+        {
+            return CmdLine::Status::InvalidParameter;
+        }
+    }
+
+    ((ConsoleTask *)Context)->StartLiveView(TopView, refreshInMs);
     return CmdLine::Status::Ok;
 }
 
@@ -278,6 +465,11 @@ CmdLine::ProcessorDesc consoleTaskCmdProcessors[] =
     {StartNetworkCmdProcessor, "network", "Network related menu"},
     {ShowPerfCounters, "perf", "Show performance counters"},
     {ResetPerfCounters, "perfReset", "Reset performance counters"},
+    {ShowTop, "top", "Live per loop wall time share (includes preemption), loop rate and worst recent latency. Usage: top [<refresh secs>]"},
+    {ShowLocks, "locks", "Show lock wait and hold times, including the boiler thread's worst wait"},
+    {LogLevelProcessor, "logLevel", "Show or set per module log levels. Usage: logLevel [<module>|all INFO|PROG|WARN|CRIT|OFF]"},
+    {LogSinkProcessor, "logSink", "Show or set log sink levels. Usage: logSink [<sink> INFO|PROG|WARN|CRIT|OFF]"},
+    {DiagLogProcessor, "diagLog", "Dump or erase the flash diag log. Usage: diagLog [erase]"},
 };
 int const LengthOfConsoleTaskCmdProcessors = sizeof(consoleTaskCmdProcessors) / sizeof(consoleTaskCmdProcessors[0]);
 
@@ -302,30 +494,42 @@ void setup()
     RTC.getTime(now);
     RTC.setTimeIfNotRunning(now);
 
-    // Start our uSecSystemClock
-    uSecSystemClock.Reset();
-
     Serial.begin(250000);
     delay(1000);
 
 
     //    modem.debug(Serial, 0);
 
+#if SPA_STATIC_RTOS
+    mainThread = xTaskCreateStatic
+    (
+        MainThreadEntry,
+        static_cast<const char*>("Loop Thread"),
+        mainThreadStackDepth,       /* ulStackDepth in words */
+        nullptr,                    /* pvParameters */
+        1,                          /* uxPriority */
+        mainThreadStack,            /* puxStackBuffer */
+        &mainThreadTcb              /* pxTaskBuffer */
+    );
+    auto const status = (mainThread != nullptr) ? pdPASS : pdFAIL;
+#else
     auto const status = xTaskCreate
     (
         MainThreadEntry,
         static_cast<const char*>("Loop Thread"),
-        (1024 + 500) / 4,           /* usStackDepth in words */
+        mainThreadStackDepth,       /* usStackDepth in words */
         nullptr,                    /* pvParameters */
         1,                          /* uxPriority */
         &mainThread                 /* pxCreatedTask */
     );
+#endif
 
     if (status != pdPASS) 
     {
         Serial.println("Failed to create 'main' thread");
         $FailFast();
     }
+    MemoryMonitor::RegisterThread(mainThread, "main", mainThreadStackDepth);
 
     vTaskStartScheduler();
     $FailFast();
@@ -372,7 +576,7 @@ void FinishStart()
     }
 
     logger.Begin(bootRecord.GetRecord().BootCount);
-    // logger.SetFilter(Logger::RecType::Progress);         // TODO: Walk through and set the RecType for things that are progress info to be Progress
+    logger.SetLevelsFromConfig();           // Per module log levels - see the logLevel command
 
     //** Logger used for all output from this point on
     tempSensorsConfig.Begin();
@@ -388,20 +592,35 @@ void FinishStart()
         $Assert(boilerConfig.IsValid());
     }
 
+#if SPA_STATIC_RTOS
+    backgroundThread = xTaskCreateStatic(
+        BoilerControllerTask::BoilerControllerThreadEntry,
+        static_cast<const char *>("Loop Thread"),
+        boilerThreadStackDepth,                     /* ulStackDepth in words */
+        nullptr,                                    /* pvParameters */
+        2,                                          /* uxPriority */
+        boilerThreadStack,                          /* puxStackBuffer */
+        &boilerThreadTcb                            /* pxTaskBuffer */
+    );
+    auto const status = (backgroundThread != nullptr) ? pdPASS : pdFAIL;
+#else
     auto const status = xTaskCreate(
         BoilerControllerTask::BoilerControllerThreadEntry,
         static_cast<const char *>("Loop Thread"),
-        (1024) / 4,                                 /* usStackDepth in words */
+        boilerThreadStackDepth,                     /* usStackDepth in words */
         nullptr,                                    /* pvParameters */
         2,                                          /* uxPriority */
         &backgroundThread                           /* pxCreatedTask */
     );
+#endif
 
     if (status != pdPASS)
     {
-        logger.Printf(Logger::RecType::Critical, "Failed to create 'background' thread");
+        $Log(Main, Critical, "Failed to create 'background' thread");
         $FailFast();
     }
+    MemoryMonitor::RegisterThread(backgroundThread, "boiler", boilerThreadStackDepth);
+    InstrumentedMutex::SetWatchedTask(backgroundThread);    // report the boiler thread's worst lock waits
 
     consoleTask.Setup();
     consoleTask.begin(consoleTaskCmdProcessors, LengthOfConsoleTaskCmdProcessors, "Main");
@@ -410,6 +629,9 @@ void FinishStart()
     haMqttClient.Setup();
     telnetConsole.Setup();
     ntpClient.Setup();
+
+    MemoryMonitor::MarkStartupComplete();
+    MemoryMonitor::PrintRamBudget(Serial);
 }
 
 //byte padBuffer[1900 + 3072];     // with rtos heap of 5K (configTOTAL_HEAP_SIZE == 0x1400)
@@ -432,7 +654,7 @@ void loop()
         if (boilerConfig.IsValid() && boilerConfig.GetRecord().IsConfigured() &&
             tempSensorsConfig.IsValid() && tempSensorsConfig.GetRecord().IsConfigured())
         {
-            logger.Printf(Logger::RecType::Progress, "Main: Autostarting Boiler State Machine");
+            $Log(Main, Progress, "Main: Autostarting Boiler State Machine");
             firstHeaterStateMachineStarted = true;
 
             // Set all needed to prime the boiler state machine
@@ -441,6 +663,39 @@ void loop()
         }
     }
 
+    //* Report temp sensor hot-plug events from the Boiler's sensor discovery
+    BoilerControllerTask::SensorEvent sensorEvent;
+    while (boilerControllerTask.GetSensorEvent(sensorEvent))
+    {
+        bool const isConfigured = tempSensorsConfig.IsValid() &&
+                                  ((sensorEvent._id == tempSensorsConfig.GetRecord()._ambiantTempSensorId) ||
+                                   (sensorEvent._id == tempSensorsConfig.GetRecord()._boilerInTempSensorId) ||
+                                   (sensorEvent._id == tempSensorsConfig.GetRecord()._boilerOutTempSensorId));
+
+        if ((sensorEvent._type == BoilerControllerTask::SensorEvent::Type::Removed) && isConfigured)
+        {
+            $Log(Boiler, Warning, "Main: Configured Temp Sensor Removed: %" $PRIX64, To$PRIX64(sensorEvent._id));
+        }
+        else
+        {
+            $Log(Boiler, Info, "Main: Temp Sensor %s: %" $PRIX64 "%s",
+                 BoilerControllerTask::GetSensorEventTypeDescription(sensorEvent._type),
+                 To$PRIX64(sensorEvent._id),
+                 isConfigured ? " (configured)" : "");
+        }
+    }
+
+    static uint32_t reportedSensorEventOverflows = 0;
+    uint32_t const sensorEventOverflows = boilerControllerTask.GetSensorEventOverflows();
+    if (sensorEventOverflows != reportedSensorEventOverflows)
+    {
+        $Log(Boiler, Warning, "Main: %u Temp Sensor events lost - event queue full", sensorEventOverflows - reportedSensorEventOverflows);
+        reportedSensorEventOverflows = sensorEventOverflows;
+    }
+
+    logger.Flush();     // report any rate limited log records that have since gone quiet
+    logger.Drain();     // move queued log records to their sinks
+
     network.Loop();     // give network a chance to do its thing
     haMqttClient.Loop();
     ntpClient.Loop();
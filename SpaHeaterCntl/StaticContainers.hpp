@@ -0,0 +1,357 @@
+// SPA Heater Controller for Maxie HA system 2024 (c)TinyBus
+// Fixed capacity (heap free) container support
+
+#pragma once
+#include "common.hpp"
+#include <new>
+#include <utility>
+#include <type_traits>
+
+//** Fixed capacity replacements for std::vector, String, std::function and shared_ptr. None of them allocate;
+//   capacities are compile time and exceeding one is a $FailFast() unless noted. Use these for anything that
+//   lives past startup or runs on a hot path - the heap (newlib malloc) is small and fragments.
+
+
+//** Vector with inline storage for up to TCapacity elements
+//
+template <typename T, int TCapacity>
+class StaticVector
+{
+private:
+    alignas(T) uint8_t  _storage[TCapacity * sizeof(T)];
+    int                 _size;
+
+    __inline T* Data() { return reinterpret_cast<T*>(&_storage[0]); }
+    __inline T const* Data() const { return reinterpret_cast<T const*>(&_storage[0]); }
+
+public:
+    StaticVector(const StaticVector&) = delete;
+    StaticVector &operator=(const StaticVector &) = delete;
+
+    __inline StaticVector() : _size(0) {}
+    __inline ~StaticVector() { Clear(); }
+
+    __inline void PushBack(const T& Value)
+    {
+        if (_size >= TCapacity)
+        {
+            $FailFast();
+        }
+        new (&Data()[_size]) T(Value);
+        _size++;
+    }
+
+    __inline void PopBack()
+    {
+        $Assert(_size > 0);
+        _size--;
+        Data()[_size].~T();
+    }
+
+    __inline void Erase(int Index)       // order preserving
+    {
+        $Assert((Index >= 0) && (Index < _size));
+        for (int ix = Index; ix < (_size - 1); ix++)
+        {
+            Data()[ix] = Data()[ix + 1];
+        }
+        PopBack();
+    }
+
+    __inline void Clear()
+    {
+        while (_size > 0) PopBack();
+    }
+
+    __inline T& operator[](int Index) { $Assert((Index >= 0) && (Index < _size)); return Data()[Index]; }
+    __inline T const& operator[](int Index) const { $Assert((Index >= 0) && (Index < _size)); return Data()[Index]; }
+
+    __inline T* begin() { return Data(); }
+    __inline T* end() { return Data() + _size; }
+    __inline T const* begin() const { return Data(); }
+    __inline T const* end() const { return Data() + _size; }
+
+    __inline int Size() const { return _size; }
+    static constexpr int Capacity() { return TCapacity; }
+    __inline bool IsEmpty() const { return _size == 0; }
+    __inline bool IsFull() const { return _size == TCapacity; }
+};
+
+
+//** Null terminated string with inline storage for up to TCapacity chars. Appends that do not fit are
+//   truncated and return false - input from the network must never be able to fault the system.
+//
+template <int TCapacity>
+class FixedString
+{
+private:
+    char    _chars[TCapacity + 1];
+    int     _length;
+
+public:
+    __inline FixedString() : _length(0) { _chars[0] = 0; }
+    __inline FixedString(char const* From) : FixedString() { Append(From); }
+
+    __inline void Clear() { _length = 0; _chars[0] = 0; }
+
+    __inline bool Append(char C)
+    {
+        if (_length >= TCapacity)
+        {
+            return false;
+        }
+        _chars[_length++] = C;
+        _chars[_length] = 0;
+        return true;
+    }
+
+    __inline bool Append(char const* From, int Length = -1)
+    {
+        for (int ix = 0; (Length < 0) ? (From[ix] != 0) : (ix < Length); ix++)
+        {
+            if (!Append(From[ix]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    __inline bool AppendHex(uint8_t Byte)
+    {
+        static char const hexDigit[] = "0123456789ABCDEF";
+        return Append(hexDigit[(Byte & 0xF0) >> 4]) && Append(hexDigit[Byte & 0x0F]);
+    }
+
+    __inline bool StartsWith(char const* Prefix) const { return strncmp(_chars, Prefix, strlen(Prefix)) == 0; }
+    __inline bool operator==(char const* Other) const { return strcmp(_chars, Other) == 0; }
+
+    __inline char const* c_str() const { return _chars; }
+    __inline int Length() const { return _length; }
+    static constexpr int Capacity() { return TCapacity; }
+    __inline bool IsFull() const { return _length == TCapacity; }
+};
+
+
+//** std::function replacement - the callable is stored inline (TStorageSize bytes) and never on the heap
+//
+template <typename TSignature, int TStorageSize = 2 * sizeof(void*)>
+class InplaceFunction;
+
+template <typename TReturn, typename... TArgs, int TStorageSize>
+class InplaceFunction<TReturn(TArgs...), TStorageSize>
+{
+private:
+    typedef TReturn (*Invoker)(void* Callable, TArgs... Args);
+    typedef void (*Manager)(void* To, void const* From);        // copies From into To; or destroys To if From is nullptr
+
+    alignas(void*) uint8_t  _storage[TStorageSize];
+    Invoker                 _invoker;
+    Manager                 _manager;
+
+    template <typename TCallable>
+    static TReturn Invoke(void* Callable, TArgs... Args)
+    {
+        return (*reinterpret_cast<TCallable*>(Callable))(std::forward<TArgs>(Args)...);
+    }
+
+    template <typename TCallable>
+    static void Manage(void* To, void const* From)
+    {
+        if (From != nullptr)
+        {
+            new (To) TCallable(*reinterpret_cast<TCallable const*>(From));
+        }
+        else
+        {
+            reinterpret_cast<TCallable*>(To)->~TCallable();
+        }
+    }
+
+public:
+    __inline InplaceFunction() : _invoker(nullptr), _manager(nullptr) {}
+
+    template <typename TCallable, typename = typename std::enable_if<!std::is_same<typename std::decay<TCallable>::type, InplaceFunction>::value>::type>
+    __inline InplaceFunction(TCallable&& Callable)
+    {
+        typedef typename std::decay<TCallable>::type CallableType;
+        static_assert(sizeof(CallableType) <= TStorageSize, "Callable does not fit in the InplaceFunction storage");
+        static_assert(alignof(CallableType) <= alignof(void*), "Callable alignment is not supported");
+
+        new (&_storage[0]) CallableType(std::forward<TCallable>(Callable));
+        _invoker = &Invoke<CallableType>;
+        _manager = &Manage<CallableType>;
+    }
+
+    __inline InplaceFunction(const InplaceFunction& Other) : _invoker(Other._invoker), _manager(Other._manager)
+    {
+        if (_manager != nullptr)
+        {
+            _manager(&_storage[0], &Other._storage[0]);
+        }
+    }
+
+    __inline InplaceFunction& operator=(const InplaceFunction& Other)
+    {
+        if (this != &Other)
+        {
+            this->~InplaceFunction();
+            new (this) InplaceFunction(Other);
+        }
+        return *this;
+    }
+
+    __inline ~InplaceFunction()
+    {
+        if (_manager != nullptr)
+        {
+            _manager(&_storage[0], nullptr);
+        }
+    }
+
+    __inline TReturn operator()(TArgs... Args)
+    {
+        $Assert(_invoker != nullptr);
+        return _invoker(&_storage[0], std::forward<TArgs>(Args)...);
+    }
+
+    __inline explicit operator bool() const { return _invoker != nullptr; }
+};
+
+
+//** shared_ptr replacement for long lived objects that come from an ObjectPool. A PoolHandle is the single
+//   owner of its object (move only); the object is destroyed and its pool slot freed when the handle is reset
+//   or destroyed. A handle can be converted to a handle of a base class of its object.
+//
+template <typename T>
+class PoolHandle
+{
+    template <typename U> friend class PoolHandle;
+
+public:
+    typedef void (*Releaser)(void* Slot);
+
+private:
+    T*          _object;
+    void*       _slot;
+    Releaser    _release;
+
+public:
+    PoolHandle(const PoolHandle&) = delete;
+    PoolHandle &operator=(const PoolHandle &) = delete;
+
+    __inline PoolHandle() : _object(nullptr), _slot(nullptr), _release(nullptr) {}
+    __inline PoolHandle(std::nullptr_t) : PoolHandle() {}
+    __inline PoolHandle(T* Object, void* Slot, Releaser Release) : _object(Object), _slot(Slot), _release(Release) {}
+
+    template <typename U>
+    __inline PoolHandle(PoolHandle<U>&& Other) : _object(Other._object), _slot(Other._slot), _release(Other._release)
+    {
+        Other._object = nullptr;
+    }
+
+    __inline PoolHandle(PoolHandle&& Other) : _object(Other._object), _slot(Other._slot), _release(Other._release)
+    {
+        Other._object = nullptr;
+    }
+
+    __inline PoolHandle& operator=(PoolHandle&& Other)
+    {
+        if (this != &Other)
+        {
+            reset();
+            _object = Other._object;
+            _slot = Other._slot;
+            _release = Other._release;
+            Other._object = nullptr;
+        }
+        return *this;
+    }
+
+    __inline PoolHandle& operator=(std::nullptr_t) { reset(); return *this; }
+    __inline ~PoolHandle() { reset(); }
+
+    __inline void reset()
+    {
+        if (_object != nullptr)
+        {
+            _object = nullptr;
+            _release(_slot);
+        }
+    }
+
+    __inline T* get() const { return _object; }
+    __inline T* operator->() const { $Assert(_object != nullptr); return _object; }
+    __inline T& operator*() const { $Assert(_object != nullptr); return *_object; }
+    __inline explicit operator bool() const { return _object != nullptr; }
+    __inline bool operator==(std::nullptr_t) const { return _object == nullptr; }
+    __inline bool operator!=(std::nullptr_t) const { return _object != nullptr; }
+};
+
+//** Fixed pool of TCapacity objects of type T - objects are constructed in place by Create() and handed out
+//   as PoolHandles. Create() returns an empty handle when the pool is exhausted. Thread safe.
+//
+template <typename T, int TCapacity>
+class ObjectPool
+{
+private:
+    struct Slot
+    {
+        alignas(T) uint8_t  _storage[sizeof(T)];
+        bool                _inUse;
+    };
+
+    Slot    _slots[TCapacity];
+
+    static void Release(void* SlotToRelease)
+    {
+        Slot* slot = reinterpret_cast<Slot*>(SlotToRelease);
+        reinterpret_cast<T*>(&slot->_storage[0])->~T();
+        synchronized
+        {
+            slot->_inUse = false;
+        }
+    }
+
+public:
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool &operator=(const ObjectPool &) = delete;
+
+    __inline ObjectPool()
+    {
+        for (auto& slot : _slots) slot._inUse = false;
+    }
+
+    template <typename... TArgs>
+    PoolHandle<T> Create(TArgs&&... Args)
+    {
+        Slot* slot = nullptr;
+        synchronized
+        {
+            for (auto& candidate : _slots)
+            {
+                if (!candidate._inUse)
+                {
+                    candidate._inUse = true;
+                    slot = &candidate;
+                    break;
+                }
+            }
+        }
+
+        if (slot == nullptr)
+        {
+            return PoolHandle<T>();
+        }
+        return PoolHandle<T>(new (&slot->_storage[0]) T(std::forward<TArgs>(Args)...), slot, &Release);
+    }
+
+    int InUse()
+    {
+        int inUse = 0;
+        for (auto& slot : _slots) inUse += slot._inUse ? 1 : 0;
+        return inUse;
+    }
+
+    static constexpr int Capacity() { return TCapacity; }
+};
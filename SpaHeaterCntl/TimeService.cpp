@@ -0,0 +1,177 @@
+// SPA Heater Controller for Maxie HA system 2024 (c)TinyBus
+// Time Service related implementation
+
+#include "TimeService.hpp"
+
+constexpr int64_t TimeService::StepThresholdUSecs;
+
+
+TimeService::TimeService()
+    : _baseMonotonicUSecs(0),
+      _baseUtcUSecs(0),
+      _slewUSecs(0),
+      _freqPpb(0),
+      _lastFreqAdjustPpb(INT32_MAX),
+      _lastErrorUSecs(0),
+      _fitAnchorMonotonicUSecs(0),
+      _fitAnchorOffsetUSecs(0),
+      _fitW(0.0),
+      _fitX(0.0),
+      _fitY(0.0),
+      _fitXX(0.0),
+      _fitXY(0.0),
+      _samples(0),
+      _steps(0),
+      _hasReference(false)
+{
+}
+
+uint64_t TimeService::MonotonicNow()
+{
+    return uSecSystemClock.Now();
+}
+
+// Part of the slew applied after Elapsed uSecs from the base - at _maxSlewPpb until all of it is applied
+int64_t TimeService::SlewApplied(int64_t Elapsed)
+{
+    if ((Elapsed <= 0) || (_slewUSecs == 0))
+    {
+        return 0;
+    }
+
+    int64_t const slewed = (Elapsed * _maxSlewPpb) / 1000000000;
+    if (_slewUSecs > 0)
+    {
+        return (slewed < _slewUSecs) ? slewed : _slewUSecs;
+    }
+    return (-slewed > _slewUSecs) ? -slewed : _slewUSecs;
+}
+
+// UTC = base + elapsed + frequency correction + the part of the slew applied so far
+int64_t TimeService::MapToUtc(uint64_t MonotonicUSecs)
+{
+    int64_t const elapsed = (int64_t)(MonotonicUSecs - _baseMonotonicUSecs);
+    return _baseUtcUSecs + elapsed + ((elapsed * _freqPpb) / 1000000000) + SlewApplied(elapsed);
+}
+
+/**
+ * @brief Applies one offset measurement (UTC - monotonic at MonotonicUSecs) to the mapping.
+ * 
+ * The first measurement, and any that disagrees with the mapping by more than StepThresholdUSecs, steps the
+ * mapping. Otherwise the mapping is rebased at its current (continuous) value and the error is slewed out.
+ * 
+ * The frequency correction is the slope of the raw measured offsets over monotonic time - a least squares
+ * fit with exponential forgetting (_fitDecay) so a drift that changes with temperature is followed. It is
+ * restarted on each step.
+ * 
+ * @return true if the mapping was stepped.
+ */
+bool TimeService::Discipline(uint64_t MonotonicUSecs, int64_t OffsetUSecs)
+{
+    int64_t const measured = (int64_t)MonotonicUSecs + OffsetUSecs;
+    bool stepped = false;
+
+    synchronized
+    {
+        _samples++;
+
+        int64_t const error = _hasReference ? (measured - MapToUtc(MonotonicUSecs)) : 0;
+        _lastErrorUSecs = error;
+
+        if (!_hasReference || (error > StepThresholdUSecs) || (error < -StepThresholdUSecs))
+        {
+            _baseMonotonicUSecs = MonotonicUSecs;
+            _baseUtcUSecs = measured;
+            _slewUSecs = 0;
+            _hasReference = true;
+            _steps++;
+            stepped = true;
+
+            // Restart the drift fit from this measurement
+            _fitAnchorMonotonicUSecs = MonotonicUSecs;
+            _fitAnchorOffsetUSecs = OffsetUSecs;
+            _fitW = _fitX = _fitY = _fitXX = _fitXY = 0.0;
+            _lastFreqAdjustPpb = INT32_MAX;
+        }
+        else
+        {
+            _baseUtcUSecs = measured - error;       // the mapping's current value - continuous
+            _baseMonotonicUSecs = MonotonicUSecs;
+            _slewUSecs = error;
+        }
+
+        // Fold the measurement into the drift fit: x in secs, y in uSecs - so the slope is in ppm
+        double const x = (double)(int64_t)(MonotonicUSecs - _fitAnchorMonotonicUSecs) / 1000000.0;
+        double const y = (double)(OffsetUSecs - _fitAnchorOffsetUSecs);
+        _fitW = (_fitW * _fitDecay) + 1.0;
+        _fitX = (_fitX * _fitDecay) + x;
+        _fitY = (_fitY * _fitDecay) + y;
+        _fitXX = (_fitXX * _fitDecay) + (x * x);
+        _fitXY = (_fitXY * _fitDecay) + (x * y);
+
+        double const denominator = (_fitW * _fitXX) - (_fitX * _fitX);
+        if ((_fitW >= 2.0) && (denominator > 1.0))
+        {
+            int64_t freqPpb = (int64_t)(((_fitW * _fitXY) - (_fitX * _fitY)) / denominator * 1000.0);
+            freqPpb = (freqPpb > _maxFreqPpb) ? _maxFreqPpb : ((freqPpb < -_maxFreqPpb) ? -_maxFreqPpb : freqPpb);
+
+            if (_samples > 1)
+            {
+                _lastFreqAdjustPpb = freqPpb - _freqPpb;
+            }
+            _freqPpb = freqPpb;
+        }
+    }
+
+    return stepped;
+}
+
+bool TimeService::HasReference()
+{
+    return _hasReference;
+}
+
+// Drift is considered estimated once a few measurements have stopped moving the frequency estimate much
+bool TimeService::IsDriftEstimated()
+{
+    synchronized
+    {
+        return (_samples >= 4) && (_lastFreqAdjustPpb < _driftSettledPpb) && (_lastFreqAdjustPpb > -_driftSettledPpb);
+    }
+}
+
+bool TimeService::ToUtc(uint64_t MonotonicUSecs, uint64_t& UtcUSecs)
+{
+    synchronized
+    {
+        if (!_hasReference)
+        {
+            return false;
+        }
+        UtcUSecs = (uint64_t)MapToUtc(MonotonicUSecs);
+    }
+    return true;
+}
+
+bool TimeService::UtcNow(uint64_t& UtcUSecs)
+{
+    return ToUtc(MonotonicNow(), UtcUSecs);
+}
+
+void TimeService::GetStatus(Status& Status)
+{
+    bool const driftEstimated = IsDriftEstimated();
+
+    synchronized
+    {
+        Status._hasReference = _hasReference;
+        Status._driftEstimated = driftEstimated;
+        Status._freqPpb = (int32_t)_freqPpb;
+        Status._lastErrorUSecs = (int32_t)_lastErrorUSecs;
+        Status._slewUSecs = (int32_t)_slewUSecs;
+        Status._samples = _samples;
+        Status._steps = _steps;
+    }
+}
+
+TimeService timeService;
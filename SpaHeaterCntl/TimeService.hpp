@@ -0,0 +1,72 @@
+// SPA Heater Controller for Maxie HA system 2024 (c)TinyBus
+// Time Service related definitions
+
+#pragma once
+#include "SpaHeaterCntl.hpp"
+
+//* Maps the monotonic uSec system clock to UTC. The mapping is disciplined by NTP offset measurements
+//  (see Discipline()): small errors are slewed out at no more than _maxSlewPpb rather than stepped, and the
+//  trend of the measurements gives an estimate of the clock's frequency error (drift). The
+//  monotonic clock itself is never adjusted - log stamps and perf counters stay purely monotonic.
+//  All log records are stamped with monotonic time; NtpRef log records carry the reference pairs so the
+//  stamps can be converted to UTC off the device (see Tools/logdecode.py).
+class TimeService
+{
+public:
+    struct Status
+    {
+        bool        _hasReference;
+        bool        _driftEstimated;
+        int32_t     _freqPpb;               // estimated frequency correction in parts per billion
+        int32_t     _lastErrorUSecs;        // of the mapping at the last measurement
+        int32_t     _slewUSecs;             // being slewed out
+        uint32_t    _samples;
+        uint32_t    _steps;
+    };
+
+    static constexpr int64_t    StepThresholdUSecs = 128000;        // larger errors are stepped
+
+public:
+    TimeService();
+
+    uint64_t MonotonicNow();                                            // uSecs since boot - thread safe
+    bool Discipline(uint64_t MonotonicUSecs, int64_t OffsetUSecs);      // measured UTC - monotonic; true if stepped
+    bool HasReference();
+    bool IsDriftEstimated();
+    bool ToUtc(uint64_t MonotonicUSecs, uint64_t& UtcUSecs);            // UTC is uSecs since the Unix epoch
+    bool UtcNow(uint64_t& UtcUSecs);
+    void GetStatus(Status& Status);
+
+private:
+    int64_t SlewApplied(int64_t Elapsed);                               // caller is synchronized
+    int64_t MapToUtc(uint64_t MonotonicUSecs);                          // caller is synchronized
+
+private:
+    static constexpr int32_t    _maxSlewPpb = 500000;               // 500ppm
+    static constexpr int32_t    _maxFreqPpb = 500000;
+    static constexpr int32_t    _driftSettledPpb = 2000;            // freq adjustment below which drift is estimated
+    static constexpr double     _fitDecay = 0.9;                    // per measurement weight decay of the drift fit
+
+    uint64_t    _baseMonotonicUSecs;
+    int64_t     _baseUtcUSecs;
+    int64_t     _slewUSecs;                 // total to slew in from the base
+    int64_t     _freqPpb;
+    int64_t     _lastFreqAdjustPpb;
+    int64_t     _lastErrorUSecs;
+
+    // Drift fit - weighted sums over (secs since anchor, offset uSecs less the anchor's)
+    uint64_t    _fitAnchorMonotonicUSecs;
+    int64_t     _fitAnchorOffsetUSecs;
+    double      _fitW;
+    double      _fitX;
+    double      _fitY;
+    double      _fitXX;
+    double      _fitXY;
+
+    uint32_t    _samples;
+    uint32_t    _steps;
+    bool        _hasReference;
+};
+
+//** Cross module references
+extern TimeService timeService;
@@ -63,12 +63,12 @@ void WiFiJoinApTask::SetConfig(const char* SSID, const char* NetPassword, const
 void WiFiJoinApTask::setup()
 {
     _config.Begin();
-    logger.Printf(Logger::RecType::Progress, "WiFiJoinApTask: Active - Config is %s", (_config.IsValid() ? "valid" : "invalid"));
+    $Log(WiFiJoinAp, Progress, "WiFiJoinApTask: Active - Config is %s", (_config.IsValid() ? "valid" : "invalid"));
 
     // check for the WiFi module
     if (WiFi.status() == WL_NO_MODULE) 
     {
-        logger.Printf(Logger::RecType::Critical, "WiFiJoinApTask: Communication with WiFi module failed!");
+        $Log(WiFiJoinAp, Critical, "WiFiJoinApTask: Communication with WiFi module failed!");
         $FailFast();
     }
 
@@ -76,7 +76,7 @@ void WiFiJoinApTask::setup()
     String fv = WiFi.firmwareVersion();
     if (fv < WIFI_FIRMWARE_LATEST_VERSION) 
     {
-        logger.Printf(Logger::RecType::Warning, "WiFiJoinApTask: Please upgrade the firmware");
+        $Log(WiFiJoinAp, Warning, "WiFiJoinApTask: Please upgrade the firmware");
     }
 }
 
@@ -133,10 +133,10 @@ void WiFiJoinApTask::loop()
         {
             WiFi.config(IPAddress(192,48,56,2));
 
-            status = WiFi.beginAP(_apNetName.c_str(), _apNetPassword.c_str());
+            status = WiFi.beginAP(_apNetName, _apNetPassword);
             if (status != WL_AP_LISTENING) 
             {
-                logger.Printf(Logger::RecType::Warning, "WiFiJoinApTask: Creating access point failed: %i\n\r", status);
+                $Log(WiFiJoinAp, Warning, "WiFiJoinApTask: Creating access point failed: %i\n\r", status);
                 state = State::WatchConfig;
                 return;
             }
@@ -173,19 +173,19 @@ void WiFiJoinApTask::loop()
                 if (status == WL_AP_CONNECTED) 
                 {
                     // a device has connected to the AP
-                    logger.Printf(Logger::RecType::Progress, "WiFiJoinApTask: Device connected to AP");
+                    $Log(WiFiJoinAp, Progress, "WiFiJoinApTask: Device connected to AP");
                 } 
                 else 
                 {
                     // a device has disconnected from the AP, and we are back in listening mode
-                    logger.Printf(Logger::RecType::Progress, "WiFiJoinApTask: Device disconnected from AP");
+                    $Log(WiFiJoinAp, Progress, "WiFiJoinApTask: Device disconnected from AP");
                 }
             }
 
             _client = _server.available();
             if (_client)
             {
-                _currentLine = "";
+                _currentLine.Clear();
                 state = State::ClientConnected;
             }
         }
@@ -208,7 +208,7 @@ void WiFiJoinApTask::loop()
                     // EOL...
                     // if the current line is blank, you got two newline characters in a row.
                     // that's the end of the client HTTP request, so send a response:
-                    if (_currentLine.length() == 0) 
+                    if (_currentLine.Length() == 0) 
                     {
                         // HTTP headers always start with a response code (e.g. HTTP/1.1 200 OK)
                         // and a content-type so the client knows what's coming, then a blank line:
@@ -262,20 +262,20 @@ void WiFiJoinApTask::loop()
                     }
                     else 
                     {   // if you got a newline, then clear currentLine:
-                        _currentLine = "";
+                        _currentLine.Clear();
                     }
                 }
                 else if (c != '\r') 
                 {             
                     // if you got anything else but a carriage return character,
-                    _currentLine += c;      // add it to the end of the currentLine
+                    _currentLine.Append(c);     // add it to the end of the currentLine - truncated if too long
                 }
 
-                if (_currentLine.startsWith("POST /submit"))
+                if (_currentLine.StartsWith("POST /submit"))
                 {
                     // have posted response
                     state = State::EatPostHeader;
-                    _currentLine = "";
+                    _currentLine.Clear();
                     return;
                 }
             }
@@ -301,7 +301,7 @@ void WiFiJoinApTask::loop()
                     // EOL...
                     // if the current line is blank, you got two newline characters in a row.
                     // that's the end of the client HTTP response (POST), so get the submitted form data:
-                    if (_currentLine.length() == 0) 
+                    if (_currentLine.Length() == 0) 
                     {
                         state = State::ProcessFormData;
                         return;
@@ -309,26 +309,26 @@ void WiFiJoinApTask::loop()
                     else 
                     { 
                         // Check for content length header and remember that value if found
-                        if (_currentLine.startsWith("Content-Length: "))
+                        if (_currentLine.StartsWith("Content-Length: "))
                         {
-                            contentLength = _currentLine.substring(16).toInt();
+                            contentLength = atoi(_currentLine.c_str() + 16);
                         }
                           // if you got a newline, then clear currentLine. Keep eating lines until a blank line
-                        _currentLine = "";
+                        _currentLine.Clear();
                     }
                 }
                 else if (c != '\r') 
                 {             
                     // if you got anything else but a carriage return character,
-                    _currentLine += c;      // add it to the end of the currentLine
+                    _currentLine.Append(c);     // add it to the end of the currentLine - truncated if too long
                 }
             }
         }
         break;
 
-        static String savedSSID;
-        static String savedNetPw;
-        static String savedAdminPw;
+        static ValueString savedSSID;
+        static ValueString savedNetPw;
+        static ValueString savedAdminPw;
 
         case State::ProcessFormData:
         {
@@ -343,7 +343,7 @@ void WiFiJoinApTask::loop()
             {
                 // Have the full payload in _currentLine
                 ParsePostData(_currentLine, savedSSID, savedNetPw, savedAdminPw);
-                logger.Printf(Logger::RecType::Info, "WiFiJoinApTask: Posted Config data: SSID: '%s'; password: '%s'; admin pw: '%s'\n",
+                $Log(WiFiJoinAp, Info, "WiFiJoinApTask: Posted Config data: SSID: '%s'; password: '%s'; admin pw: '%s'\n",
                               savedSSID.c_str(),
                               savedNetPw.c_str(),
                               savedAdminPw.c_str());
@@ -360,7 +360,7 @@ void WiFiJoinApTask::loop()
             if (_client.available()) 
             {                                        // if there's bytes to read from the client,
                 char c = _client.read();            // read a byte, then
-                _currentLine += c;
+                _currentLine.Append(c);
                 contentLength--;
             }
         }
@@ -369,7 +369,7 @@ void WiFiJoinApTask::loop()
         case State::StartNetConnection:
         {
             // Test that the supplied network is available and can be connected to given the supplied info
-            logger.Printf(Logger::RecType::Info, "WiFiJoinApTask: Attempting to connect to: '%s'", savedSSID.c_str());
+            $Log(WiFiJoinAp, Info, "WiFiJoinApTask: Attempting to connect to: '%s'", savedSSID.c_str());
             status = WiFi.begin(savedSSID.c_str(), savedNetPw.c_str());
             if (status == WL_CONNECTED)
             {
@@ -377,7 +377,7 @@ void WiFiJoinApTask::loop()
                 return;
             }
 
-            logger.Printf(Logger::RecType::Info, "WiFiJoinApTask: Attempt to connect to: '%s' failed! - try again", savedSSID.c_str());
+            $LogLimited(WiFiJoinAp, Info, "WiFiJoinApTask: Attempt to connect to: '%s' failed! - try again", savedSSID.c_str());
             lastError = "*** WiFi.begin() failed ***";
             _client.stop();
             _server.end();
@@ -388,7 +388,7 @@ void WiFiJoinApTask::loop()
         case State::NetConnected:
         {
             // Supplied WiFi config info proved to work - store the config and restart SM at first state
-            logger.Printf(Logger::RecType::Info, "WiFiJoinApTask: Connected to '%s'", savedSSID.c_str());
+            $Log(WiFiJoinAp, Info, "WiFiJoinApTask: Connected to '%s'", savedSSID.c_str());
 
             // If is left up to other components to use the validated wifi config info - detach from the network
             _client.stop();
@@ -405,11 +405,11 @@ void WiFiJoinApTask::loop()
             _config.Write();
             $Assert(_config.IsValid());
 
-            // Free up some heap
-            savedSSID = "";
-            savedNetPw = "";
-            savedAdminPw = "";
-            _currentLine = "";
+            // Don't keep the passwords around
+            savedSSID.Clear();
+            savedNetPw.Clear();
+            savedAdminPw.Clear();
+            _currentLine.Clear();
 
             state = State::Sleep;       // Go to final state
         }
@@ -418,7 +418,7 @@ void WiFiJoinApTask::loop()
         case State::CloseClientConnection:
         {
             _client.stop();
-            logger.Printf(Logger::RecType::Info, "WiFiJoinApTask: client disconnected");
+            $Log(WiFiJoinAp, Info, "WiFiJoinApTask: client disconnected");
             state = State::WatchForClient;
         }
         break;
@@ -456,26 +456,29 @@ void WiFiJoinApTask::PrintWiFiStatus(Stream& ToStream)
     ToStream.println(ip);
 }
 
-// Helper function to extract value for a given key
-String WiFiJoinApTask::GetValueByKey(String& Data, String Key) 
+// Helper function to extract value for a given key - truncated to the Value's capacity
+void WiFiJoinApTask::GetValueByKey(LineString const& Data, const char* Key, ValueString& Value) 
 {
-    String value = "";
-    int startPos = Data.indexOf(Key + "=");
-    if (startPos != -1) {
-        int endPos = Data.indexOf('&', startPos);
-        if (endPos == -1) {
-            endPos = Data.length();
+    int const keyLength = strlen(Key);
+
+    Value.Clear();
+    for (const char* start = strstr(Data.c_str(), Key); start != nullptr; start = strstr(start + 1, Key))
+    {
+        if (start[keyLength] == '=')
+        {
+            const char* const value = start + keyLength + 1;
+            const char* const end = strchr(value, '&');
+            Value.Append(value, (end == nullptr) ? strlen(value) : (end - value));
+            return;
         }
-        value = Data.substring(startPos + Key.length() + 1, endPos);
     }
-    return value;
 }
 
 // Function to parse the POST data
-void WiFiJoinApTask::ParsePostData(String& PostData, String& Network, String& WifiPassword, String& TelnetAdminPassword) 
+void WiFiJoinApTask::ParsePostData(LineString const& PostData, ValueString& Network, ValueString& WifiPassword, ValueString& TelnetAdminPassword) 
 {
-    Network = GetValueByKey(PostData, "SSID");
-    WifiPassword = GetValueByKey(PostData, "wifiPassword");
-    TelnetAdminPassword = GetValueByKey(PostData, "telnetAdminPassword");
+    GetValueByKey(PostData, "SSID", Network);
+    GetValueByKey(PostData, "wifiPassword", WifiPassword);
+    GetValueByKey(PostData, "telnetAdminPassword", TelnetAdminPassword);
 }
 
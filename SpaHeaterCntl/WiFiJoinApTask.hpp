@@ -34,9 +34,12 @@ private:
     bool _isInSleepState;
     WiFiServer _server;
     WiFiClient _client;
-    String _currentLine;
-    String _apNetName;
-    String _apNetPassword;
+    typedef FixedString<256> LineString;                            // HTTP request lines and the POSTed form data
+    typedef FixedString<sizeof(Config::_ssid) - 1> ValueString;     // a form value - as stored in Config
+
+    LineString _currentLine;
+    const char* _apNetName;
+    const char* _apNetPassword;
 
 public:
     WiFiJoinApTask() = delete;
@@ -55,8 +58,8 @@ protected:
     virtual void loop() override;
 
 private:
-    static String GetValueByKey(String &Data, String Key);
-    static void ParsePostData(String &PostData, String &Network, String &WifiPassword, String &TelnetAdminPassword);
+    static void GetValueByKey(LineString const& Data, const char* Key, ValueString& Value);
+    static void ParsePostData(LineString const& PostData, ValueString& Network, ValueString& WifiPassword, ValueString& TelnetAdminPassword);
     static void PrintWiFiStatus(Stream &ToStream);
 };
 
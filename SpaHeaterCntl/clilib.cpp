@@ -79,8 +79,8 @@ bool CmdLine::IsReady()
                 _stream->flush();
 
                 // clear the esc seq from the stream - or timeout
-                unsigned long timeoutTime = millis() + 2000;
-                while (timeoutTime > millis())
+                unsigned long const startTime = millis();
+                while ((millis() - startTime) < 2000)
                 {
                     if (_stream->available() > 0)
                     {
@@ -0,0 +1,91 @@
+/*
+    Host build shim - just enough of the Arduino core for the sketch's portable code to build and run
+    on the host (see Tests/Makefile). ARDUINO is deliberately not defined.
+
+    Copyright TinyBus 2024
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <type_traits>
+
+#define __inline inline
+
+#define HIGH                1
+#define LOW                 0
+#define INPUT               0
+#define OUTPUT              1
+#define OUTPUT_OPENDRAIN    4
+#define LED_BUILTIN         13
+
+void pinMode(uint8_t Pin, uint8_t Mode);
+void digitalWrite(uint8_t Pin, uint8_t Value);
+int digitalRead(uint8_t Pin);
+void delayMicroseconds(unsigned int USecs);
+unsigned long millis();
+
+// There is nothing to disable on the host - FailFast() calls this just before it halts, so a failed
+// $Assert() ends the test run instead of spinning
+void noInterrupts();
+void interrupts();
+
+//* synchronized blocks - the host tests are single threaded
+#define synchronized for (bool __once = true; __once; __once = false)
+
+class Print
+{
+public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* Buffer, size_t Size)
+    {
+        size_t count = 0;
+        while (Size-- > 0)
+        {
+            count += write(*Buffer++);
+        }
+        return count;
+    }
+    size_t write(const char* Str) { return write((const uint8_t*)Str, strlen(Str)); }
+    size_t write(const char* Buffer, size_t Size) { return write((const uint8_t*)Buffer, Size); }
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+
+    size_t print(const char* Str) { return write(Str); }
+    size_t print(char C) { return write((uint8_t)C); }
+    size_t print(int Value)
+    {
+        char buffer[16];
+        return write(buffer, snprintf(buffer, sizeof(buffer), "%d", Value));
+    }
+    size_t println(const char* Str) { return print(Str) + println(); }
+    size_t println() { return write("\r\n"); }
+};
+
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+//* Serial is stdout
+class HostSerial : public Stream
+{
+public:
+    virtual size_t write(uint8_t c) override { return fwrite(&c, 1, 1, stdout); }
+    virtual size_t write(const uint8_t* Buffer, size_t Size) override { return fwrite(Buffer, 1, Size, stdout); }
+    using Print::write;
+    virtual void flush() override { fflush(stdout); }
+    virtual int available() override { return 0; }
+    virtual int read() override { return -1; }
+    virtual int peek() override { return -1; }
+};
+
+extern HostSerial Serial;
@@ -0,0 +1,114 @@
+/*
+    Host build shim - the freeRTOS calls and Cortex-M registers the sketch's portable code uses, backed by a
+    simulated tick. HostKernel drives the simulation: time only moves when a test advances it (or reads
+    a SysTick or SCB register - see SetReadStep()), so hours of ticks can be run in milliseconds.
+
+    Copyright TinyBus 2024
+*/
+#pragma once
+
+#include <cstdint>
+
+typedef uint32_t    TickType_t;
+typedef long        BaseType_t;
+typedef void*       TaskHandle_t;
+typedef void*       SemaphoreHandle_t;
+
+#define pdTRUE                      1
+#define pdFALSE                     0
+#define portMAX_DELAY               0xFFFFFFFFUL
+#define configTICK_RATE_HZ          1000
+#define configSUPPORT_STATIC_ALLOCATION 0
+
+#define taskSCHEDULER_SUSPENDED     0
+#define taskSCHEDULER_NOT_STARTED   1
+#define taskSCHEDULER_RUNNING       2
+
+struct TimeOut_t
+{
+    BaseType_t  xOverflowCount;
+    TickType_t  xTimeOnEntering;
+};
+
+/**
+ * @brief Simulated SysTick and kernel tick count.
+ *
+ * The SysTick counts CyclesPerTick core cycles down per tick. The kernel counts a tick when the tick
+ * interrupt runs - at once, unless a critical section holds it off, in which case the tick is pending
+ * (ICSR.PENDSTSET) until the critical section is left. The kernel tick count is 64 bits here; the 32-bit
+ * tick count and the overflow count seen through vTaskSetTimeOutState() are its halves.
+ */
+class HostKernel
+{
+public:
+    static constexpr uint32_t   CyclesPerTick = 48000;          // 48MHz core, 1kHz tick
+
+    static void Reset(uint64_t StartTicks);                     // scheduler not started; SysTick at the start of a tick
+    static void StartScheduler();
+    static void Advance(uint64_t Cycles);
+    static void SetReadStep(uint32_t Cycles);                   // cycles that pass on each SysTick->VAL or ICSR read
+    static uint64_t TrueUSecs();                                // simulated time since tick zero
+
+    // freeRTOS and register access
+    static void EnterCritical();
+    static void ExitCritical();
+    static uint64_t GetKernelTicks() { return _kernelTicks; }
+    static uint32_t ReadSysTickVal();
+    static bool ReadTickPending();
+    static BaseType_t GetSchedulerState() { return _schedulerState; }
+
+private:
+    static void DeliverTicks();
+
+    static uint64_t     _cycles;            // since tick zero
+    static uint64_t     _hwTicks;           // SysTick reloads since tick zero
+    static uint64_t     _kernelTicks;       // counted by the (simulated) tick interrupt
+    static uint32_t     _readStep;
+    static int          _criticalNesting;
+    static BaseType_t   _schedulerState;
+};
+
+struct HostSysTickVal
+{
+    operator uint32_t() const { return HostKernel::ReadSysTickVal(); }
+};
+
+struct HostSysTickRegs
+{
+    HostSysTickVal  VAL;
+    uint32_t        LOAD;
+};
+
+struct HostIcsr
+{
+    operator uint32_t() const { return HostKernel::ReadTickPending() ? (1UL << 26) : 0; }
+};
+
+struct HostScbRegs
+{
+    HostIcsr        ICSR;
+};
+
+extern HostSysTickRegs  hostSysTick;
+extern HostScbRegs      hostScb;
+
+#define SysTick                     (&hostSysTick)
+#define SCB                         (&hostScb)
+#define SCB_ICSR_PENDSTSET_Msk      (1UL << 26)
+
+#define taskENTER_CRITICAL()        HostKernel::EnterCritical()
+#define taskEXIT_CRITICAL()         HostKernel::ExitCritical()
+
+inline BaseType_t xTaskGetSchedulerState() { return HostKernel::GetSchedulerState(); }
+inline void vTaskSetTimeOutState(TimeOut_t* TimeOut)
+{
+    uint64_t const ticks = HostKernel::GetKernelTicks();
+    TimeOut->xOverflowCount = (BaseType_t)(uint32_t)(ticks >> 32);
+    TimeOut->xTimeOnEntering = (TickType_t)ticks;
+}
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return nullptr; }
+
+// Mutexes - there is a single thread, so a take never waits
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { static int mutex; return &mutex; }
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t, TickType_t) { return pdTRUE; }
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t) { return pdTRUE; }
@@ -0,0 +1,104 @@
+/*
+    Host build shim implementations
+
+    Copyright TinyBus 2024
+*/
+#include <Arduino.h>
+#include <Arduino_FreeRTOS.h>
+
+HostSerial Serial;
+
+//* Pins - only the LED is ever touched outside of a simulated bus
+static uint8_t pinValues[64];
+
+void pinMode(uint8_t Pin, uint8_t Mode) {}
+void digitalWrite(uint8_t Pin, uint8_t Value) { pinValues[Pin & 63] = Value; }
+int digitalRead(uint8_t Pin) { return pinValues[Pin & 63]; }
+void delayMicroseconds(unsigned int USecs) {}
+unsigned long millis() { return (unsigned long)(HostKernel::TrueUSecs() / 1000); }
+
+void noInterrupts()
+{
+    fflush(stdout);
+    abort();
+}
+
+void interrupts() {}
+
+//* There is no Logger in the host build - nothing is queued
+void FailFastDrainLog() {}
+
+//** HostKernel implementation
+HostSysTickRegs hostSysTick = {{}, HostKernel::CyclesPerTick - 1};
+HostScbRegs hostScb;
+
+uint64_t    HostKernel::_cycles = 0;
+uint64_t    HostKernel::_hwTicks = 0;
+uint64_t    HostKernel::_kernelTicks = 0;
+uint32_t    HostKernel::_readStep = 0;
+int         HostKernel::_criticalNesting = 0;
+BaseType_t  HostKernel::_schedulerState = taskSCHEDULER_NOT_STARTED;
+
+void HostKernel::Reset(uint64_t StartTicks)
+{
+    _cycles = StartTicks * CyclesPerTick;
+    _hwTicks = StartTicks;
+    _kernelTicks = StartTicks;
+    _readStep = 0;
+    _criticalNesting = 0;
+    _schedulerState = taskSCHEDULER_NOT_STARTED;
+}
+
+void HostKernel::StartScheduler()
+{
+    _schedulerState = taskSCHEDULER_RUNNING;
+}
+
+void HostKernel::Advance(uint64_t Cycles)
+{
+    _cycles += Cycles;
+    _hwTicks = _cycles / CyclesPerTick;
+    DeliverTicks();
+}
+
+void HostKernel::SetReadStep(uint32_t Cycles)
+{
+    _readStep = Cycles;
+}
+
+uint64_t HostKernel::TrueUSecs()
+{
+    return _cycles / (CyclesPerTick / 1000);
+}
+
+void HostKernel::EnterCritical()
+{
+    _criticalNesting++;
+}
+
+void HostKernel::ExitCritical()
+{
+    _criticalNesting--;
+    DeliverTicks();
+}
+
+uint32_t HostKernel::ReadSysTickVal()
+{
+    Advance(_readStep);
+    return CyclesPerTick - 1 - (uint32_t)(_cycles % CyclesPerTick);
+}
+
+bool HostKernel::ReadTickPending()
+{
+    Advance(_readStep);
+    return _hwTicks > _kernelTicks;
+}
+
+// The tick interrupt - held off while in a critical section
+void HostKernel::DeliverTicks()
+{
+    if (_criticalNesting == 0)
+    {
+        _kernelTicks = _hwTicks;
+    }
+}
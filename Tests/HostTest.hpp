@@ -0,0 +1,30 @@
+/*
+    Minimal host test support - each test is a program; it prints its failures and exits non-zero
+    if there were any
+
+    Copyright TinyBus 2024
+*/
+#pragma once
+
+#include <cstdio>
+
+extern int hostTestFailures;
+
+#define $Check(c)                                                                       \
+    do                                                                                  \
+    {                                                                                   \
+        if (!(c))                                                                       \
+        {                                                                               \
+            printf("FAILED: %s:%d: %s\n", __FILE__, __LINE__, #c);                      \
+            hostTestFailures++;                                                         \
+        }                                                                               \
+    } while (0)
+
+#define $HostTestMain(Name, Body)                                                       \
+    int hostTestFailures = 0;                                                           \
+    int main()                                                                          \
+    {                                                                                   \
+        Body();                                                                         \
+        printf("%s: %s\n", Name, (hostTestFailures == 0) ? "ok" : "FAILED");           \
+        return (hostTestFailures == 0) ? 0 : 1;                                         \
+    }
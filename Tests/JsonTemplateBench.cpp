@@ -0,0 +1,289 @@
+/*
+    JsonTemplate against the ExpandJson it replaced - the same output, and the time to size and expand a
+    topic and a discovery /config message the way setup() does
+
+    Copyright TinyBus 2024
+*/
+#include "HostTest.hpp"
+#include <Arduino.h>
+#include "common.hpp"
+#include "JsonTemplate.hpp"
+#include <cstdarg>
+#include <cctype>
+#include <string>
+
+//** The replaced implementation (MQTT_HA.cpp before JsonTemplate) - one virtual print(char) per template byte,
+//   ' translated at runtime. Its arguments were fetched with VarArgsBase(), which reads the caller's stack and
+//   only works on the device's ABI; va_arg fetches the same pointers here, as the template first refers to them.
+static size_t ExpandJson(Print &To, const char *JsonFormat, ...)
+{
+    char const* args[10];
+    int fetched = 0;                    // only the arguments the template has referred to so far are fetched
+    va_list argList;
+    va_start(argList, JsonFormat);
+
+    size_t result = 0;
+
+    char *p = (char *)JsonFormat;
+    while (*p)
+    {
+        if (*p == '%')
+        {
+            p++;
+
+            if (isdigit(*p))
+            {
+                int index = *p - '0';
+                if ((index <= 9) && (index >= 0))
+                {
+                    while (fetched <= index)
+                    {
+                        args[fetched++] = va_arg(argList, char const*);
+                    }
+                    result += To.print((char *)(args[index]));
+                }
+            }
+            else if (*p == '%')
+            {
+                result += To.print('%');
+            }
+            else
+            {
+                Serial.print("Error: Invalid format specifier: ");
+                va_end(argList);
+                return 0;
+            }
+        }
+        else if (*p == '\'')
+        {
+            result += To.print('"');
+        }
+        else
+        {
+            result += To.print(*p);
+        }
+        p++;
+    }
+
+    va_end(argList);
+    return result;
+}
+
+//* Utility class for determining the size of an Expanded JSON string template (as it was in MQTT_HA.cpp)
+class PrintOutputCounter : public Print
+{
+private:
+    int _count;
+
+public:
+    PrintOutputCounter() : _count(0) {}
+    virtual size_t write(uint8_t c) override final
+    {
+        _count++;
+        return 1;
+    }
+    virtual size_t write(const uint8_t *buffer, size_t size) override final
+    {
+        _count += size;
+        return size;
+    }
+    int GetCount() const { return _count; }
+};
+
+//* Utility class for expanding a JSON string template into a buffer (as in MQTT_HA.cpp)
+class BufferPrinter : public Print
+{
+private:
+    char *_buffer;
+    int _size;
+    int _maxSize;
+
+public:
+    BufferPrinter(char *buffer, int maxSize) : _buffer(buffer), _size(0), _maxSize(maxSize) {}
+
+    virtual size_t write(uint8_t c) override final
+    {
+        if (_size < _maxSize)
+        {
+            _buffer[_size++] = (char)c;
+            _buffer[_size] = 0;
+            return 1;
+        }
+        _buffer[_maxSize] = 0;
+        return 0;
+    }
+
+    virtual size_t write(const uint8_t *buffer, size_t size) override final
+    {
+        size_t const bytesToCopy = (size < (size_t)(_maxSize - _size)) ? size : (size_t)(_maxSize - _size);
+        memcpy(&_buffer[_size], buffer, bytesToCopy);
+        _size += bytesToCopy;
+        _buffer[_size] = 0;
+        return bytesToCopy;
+    }
+
+    int GetSize() const { return _size; }
+};
+
+//** The templates - MQTT_HA.cpp's water_heater base topic and /config message (own topic commands, no state topic)
+static constexpr char BoilerBaseTopicJsonTemplate[] = "%0/water_heater/%1";
+static constexpr auto boilerBaseTopicJson = $CompileJsonTemplate(BoilerBaseTopicJsonTemplate);
+
+static constexpr char BoilerConfigJsonTemplate[] =
+    "{\n"
+        "'~' : '%0/water_heater/%2',\n"
+        "'name': '%2',\n"
+        "'modes': [\n"
+            "'off',\n"
+            "'eco',\n"
+            "'performance'\n"
+        "],\n"
+
+        "'avty_t' : '%3',\n"
+        "'avty_tpl' : '{{ value_json }}',\n"
+        "'mode_stat_t': '~/mode',\n"
+        "'mode_stat_tpl' : '{{ value_json }}',\n"
+        "'mode_cmd_t': '~/mode/set',\n"
+        "'temp_stat_t': '~/temperature',\n"
+        "'temp_stat_tpl' : '{{ value_json }}',\n"
+        "'temp_cmd_t': '~/temperature/set',\n"
+        "'curr_temp_t': '~/current_temperature',\n"
+        "'curr_temp_tpl' : '{{ value_json }}',\n"
+        "'power_command_topic' : '~/power/set',\n"
+        "'max_temp' : '160',\n"
+        "'min_temp' : '65',\n"
+        "'precision': 1.0,\n"
+        "'temp_unit' : 'F',\n"
+        "'init': 101,\n"
+        "'opt' : 'false',\n"
+        "'uniq_id':'%2',\n"
+        "'dev':\n"
+        "{\n"
+            "'identifiers' : ['01'],\n"
+            "'name' : '%1'\n"
+        "}\n"
+    "}\n";
+static constexpr auto boilerConfigJson = $CompileJsonTemplate(BoilerConfigJsonTemplate);
+
+static constexpr char PercentJsonTemplate[] = "'%0' is 100%% '%1'";
+static constexpr auto percentJson = $CompileJsonTemplate(PercentJsonTemplate);
+
+static char const* const baseTopic = "homeassistant";
+static char const* const deviceName = "SpaHeater";
+static char const* const entityName = "Boiler";
+static char const* const availTopic = "TinyBus/SpaHeater/avail";
+static char const* const stateTopic = "TinyBus/SpaHeater/state";
+
+static char buffer[2048];
+
+//* setup()'s old pattern - count, then expand
+static size_t OldTopic()
+{
+    PrintOutputCounter counter;
+    size_t const size = ExpandJson(counter, BoilerBaseTopicJsonTemplate, baseTopic, entityName);
+    BufferPrinter printer(buffer, size);
+    ExpandJson(printer, BoilerBaseTopicJsonTemplate, baseTopic, entityName);
+    return printer.GetSize();
+}
+
+static size_t NewTopic()
+{
+    size_t const size = boilerBaseTopicJson.Size(baseTopic, entityName);
+    BufferPrinter printer(buffer, size);
+    boilerBaseTopicJson.Expand(printer, baseTopic, entityName);
+    return printer.GetSize();
+}
+
+static size_t OldConfig()
+{
+    PrintOutputCounter counter;
+    size_t const size = ExpandJson(counter, BoilerConfigJsonTemplate, baseTopic, deviceName, entityName, availTopic, stateTopic, "");
+    BufferPrinter printer(buffer, size);
+    ExpandJson(printer, BoilerConfigJsonTemplate, baseTopic, deviceName, entityName, availTopic, stateTopic, "");
+    return printer.GetSize();
+}
+
+static size_t NewConfig()
+{
+    JsonTemplate<6> const view(boilerConfigJson);       // as stored in the entity table
+    size_t const size = view.Size(baseTopic, deviceName, entityName, availTopic, stateTopic, "");
+    BufferPrinter printer(buffer, size);
+    view.Expand(printer, baseTopic, deviceName, entityName, availTopic, stateTopic, "");
+    return printer.GetSize();
+}
+
+static std::string Expanded(size_t (*Expand)())
+{
+    size_t const size = Expand();
+    return std::string(buffer, size);
+}
+
+static void TestSameOutput()
+{
+    $Check(Expanded(OldTopic) == "homeassistant/water_heater/Boiler");
+    $Check(Expanded(NewTopic) == Expanded(OldTopic));
+
+    std::string const oldConfig = Expanded(OldConfig);
+    $Check(oldConfig.find('\'') == std::string::npos);
+    $Check(oldConfig.find("\"name\" : \"SpaHeater\"") != std::string::npos);
+    $Check(Expanded(NewConfig) == oldConfig);
+
+    PrintOutputCounter counter;
+    size_t const oldSize = ExpandJson(counter, PercentJsonTemplate, "a", "bc");
+    BufferPrinter printer(buffer, sizeof(buffer) - 1);
+    $Check(percentJson.Expand(printer, "a", "bc") == oldSize);
+    $Check(percentJson.Size("a", "bc") == oldSize);
+    $Check(std::string(buffer, printer.GetSize()) == "\"a\" is 100% \"bc\"");
+
+    static_assert(decltype(boilerConfigJson)::ArgCount == 4, "highest argument slot + 1");
+    static_assert(decltype(percentJson)::ArgCount == 2, "%% is not an argument slot");
+}
+
+// Best of a few runs of Iterations calls - in nSecs per call
+static uint64_t TimeIt(size_t (*Expand)(), int Iterations)
+{
+    uint64_t best = UINT64_MAX;
+    volatile size_t sink = 0;
+    for (int run = 0; run < 5; run++)
+    {
+        HostClockSource::Ticks const start = HostClockSource::Now();
+        for (int ix = 0; ix < Iterations; ix++)
+        {
+            sink = sink + Expand();
+        }
+        uint64_t const elapsed = HostClockSource::Now() - start;
+        best = (elapsed < best) ? elapsed : best;
+    }
+    return best / Iterations;
+}
+
+static void Benchmark()
+{
+    struct
+    {
+        char const* _name;
+        size_t      (*_old)();
+        size_t      (*_new)();
+        int         _iterations;
+    } const cases[] =
+    {
+        {"base topic", OldTopic, NewTopic, 200000},
+        {"/config message", OldConfig, NewConfig, 20000},
+    };
+
+    printf("%-16s %14s %15s %8s\n", "size+expand", "ExpandJson ns", "JsonTemplate ns", "speedup");
+    for (auto const& benchCase : cases)
+    {
+        uint64_t const oldNs = TimeIt(benchCase._old, benchCase._iterations);
+        uint64_t const newNs = TimeIt(benchCase._new, benchCase._iterations);
+        printf("%-16s %14u %15u %7.1fx\n", benchCase._name, (uint32_t)oldNs, (uint32_t)newNs, (double)oldNs / (newNs ? newNs : 1));
+    }
+}
+
+static void RunTests()
+{
+    TestSameOutput();
+    Benchmark();
+}
+
+$HostTestMain("JsonTemplateBench", RunTests)
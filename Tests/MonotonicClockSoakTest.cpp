@@ -0,0 +1,214 @@
+/*
+    MonotonicClock, Timer, USecClock and PerfCounter over simulated months of ticks - across every 32-bit
+    tick count wrap, with SysTick reloads landing inside the clock's critical section
+
+    Copyright TinyBus 2024
+*/
+#include "HostTest.hpp"
+#include <Arduino.h>
+#include <Arduino_FreeRTOS.h>
+#include "common.hpp"
+#include <type_traits>
+
+static constexpr uint64_t   CyclesPerUSec = HostKernel::CyclesPerTick / 1000;
+static constexpr uint64_t   CyclesPerSec = CyclesPerUSec * 1000000;
+static constexpr uint64_t   WrapTicks = 1ULL << 32;                 // ~49.7 days at 1kHz
+static constexpr int        Wraps = 3;                              // ~5 months
+
+// Deterministic xorshift - the same soak every run
+static uint64_t randomState = 0x9E3779B97F4A7C15ULL;
+static uint64_t Random(uint64_t Below)
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 7;
+    randomState ^= randomState << 17;
+    return randomState % Below;
+}
+
+struct SoakTimer
+{
+    Timer       _timer;
+    uint64_t    _dueInMs;           // true time
+    bool        _isSet;
+};
+
+static SoakTimer    timers[4];
+static USecClock    soakClock;
+static uint64_t     soakClockOriginMin;     // true uSecs bracketing soakClock.Reset()
+static uint64_t     soakClockOriginMax;
+static uint64_t     lastUSecs;
+static uint64_t     lastMSecs;
+static uint64_t     reads;
+
+static void SetTimer(SoakTimer& ToSet, uint32_t AlarmInMs)
+{
+    ToSet._timer.SetAlarm(AlarmInMs);
+    ToSet._dueInMs = (HostKernel::TrueUSecs() / 1000) + AlarmInMs;
+    ToSet._isSet = true;
+}
+
+// Read every clock once and check it against the simulation's true time
+static void CheckClocks()
+{
+    HostKernel::SetReadStep((uint32_t)Random(2 * HostKernel::CyclesPerTick / 3));
+
+    uint64_t const trueBefore = HostKernel::TrueUSecs();
+    uint64_t const uSecs = MonotonicClock::NowInUSecs();
+    uint64_t const trueAfter = HostKernel::TrueUSecs();
+
+    // Exact to the uSec at some point during the read, and never backwards
+    $Check((uSecs >= trueBefore) && (uSecs <= trueAfter));
+    $Check(uSecs >= lastUSecs);
+    lastUSecs = uSecs;
+
+    // Tick resolution; no register is read so no time passes
+    uint64_t const mSecs = MonotonicClock::NowInMSecs();
+    $Check(mSecs == (HostKernel::TrueUSecs() / 1000));
+    $Check(mSecs >= lastMSecs);
+    lastMSecs = mSecs;
+
+    for (SoakTimer& timer : timers)
+    {
+        if (timer._isSet)
+        {
+            $Check(timer._timer.IsAlarmed() == (mSecs >= timer._dueInMs));
+        }
+    }
+
+    uint64_t const elapsedMin = HostKernel::TrueUSecs();
+    uint64_t const elapsed = soakClock.Now();
+    uint64_t const elapsedMax = HostKernel::TrueUSecs();
+    $Check((elapsed >= (elapsedMin - soakClockOriginMax)) && (elapsed <= (elapsedMax - soakClockOriginMin)));
+
+    reads++;
+}
+
+static void ResetSoakClock()
+{
+    soakClockOriginMin = HostKernel::TrueUSecs();
+    soakClock.Reset();
+    soakClockOriginMax = HostKernel::TrueUSecs();
+}
+
+static void TestBeforeScheduler()
+{
+    HostKernel::Reset(WrapTicks - 1);
+    HostKernel::Advance(HostKernel::CyclesPerTick / 2);
+
+    $Check(MonotonicClock::NowInUSecs() == 0);
+    $Check(MonotonicClock::NowInMSecs() == 0);
+
+    USecClock clock;
+    clock.Reset();
+    $Check(clock.Now() == 0);
+}
+
+static void TestSoak()
+{
+    // Start a few seconds before the first wrap
+    uint64_t const startTicks = WrapTicks - 5000;
+    HostKernel::Reset(startTicks);
+    HostKernel::StartScheduler();
+    HostKernel::Advance(Random(HostKernel::CyclesPerTick));
+    lastUSecs = 0;
+    lastMSecs = 0;
+    ResetSoakClock();
+
+    timers[3]._timer.SetAlarm(Timer::FOREVER);
+    timers[3]._dueInMs = UINT64_MAX;
+    timers[3]._isSet = true;
+
+    for (int wrap = 1; wrap <= Wraps; wrap++)
+    {
+        uint64_t const wrapInUSecs = wrap * WrapTicks * 1000;
+
+        // Long running timers - one due just across the wrap, one well past it
+        SetTimer(timers[0], 2500 + (uint32_t)Random(5000));
+        SetTimer(timers[1], (uint32_t)Random(3 * 24 * 60 * 60 * 1000));
+
+        // Weeks of coarse steps (up to 6 hours) to 30 seconds before the wrap
+        while ((HostKernel::TrueUSecs() + 30000000) < wrapInUSecs)
+        {
+            uint64_t const toGo = (wrapInUSecs - 30000000 - HostKernel::TrueUSecs()) * CyclesPerUSec;
+            uint64_t const step = 1 + Random(6 * 60 * 60 * CyclesPerSec);
+            HostKernel::Advance((step < toGo) ? step : toGo);
+            CheckClocks();
+            if (Random(16) == 0)
+            {
+                SetTimer(timers[2], (uint32_t)Random(24 * 60 * 60 * 1000));
+            }
+        }
+
+        // A timer set just before the wrap that is due just after it
+        SetTimer(timers[2], 30000 + (uint32_t)Random(3000));
+        if (wrap == 1)
+        {
+            ResetSoakClock();
+        }
+
+        // Sub-tick steps through the wrap - the reads advance time too, so SysTick reloads land between
+        // the clock's register reads
+        while (HostKernel::TrueUSecs() < (wrapInUSecs + 30000000))
+        {
+            HostKernel::Advance(Random(HostKernel::CyclesPerTick));
+            CheckClocks();
+        }
+        $Check(HostKernel::GetKernelTicks() > (wrap * WrapTicks));
+    }
+
+    // Every timer that was armed before the last wrap and is due has fired
+    $Check(timers[0]._timer.IsAlarmed());
+    $Check(timers[2]._timer.IsAlarmed());
+    $Check(!timers[3]._timer.IsAlarmed());
+    $Check(reads > 50000);
+}
+
+// PerfCounter on the MonotonicClock measures a section that spans the wrap
+static void TestPerfCounterAcrossWrap()
+{
+    HostKernel::Reset(WrapTicks - 2);
+    HostKernel::StartScheduler();
+    HostKernel::SetReadStep(0);
+
+    BasicPerfCounter<MonotonicClockSource> perfCounter;
+    perfCounter.Start();
+    HostKernel::Advance(5 * HostKernel::CyclesPerTick + (HostKernel::CyclesPerTick / 4));
+    perfCounter.Stop();
+    perfCounter.Start();
+    HostKernel::Advance(HostKernel::CyclesPerTick / 2);
+    perfCounter.Stop();
+
+    $Check(perfCounter.TotalSamples() == 2);
+    $Check(perfCounter.MaxTimeInUSecs() == 5250);
+    $Check(perfCounter.MinTimeInUSecs() == 500);
+    $Check(perfCounter.TotalTimeInUSecs() == 5750);
+}
+
+// The host's default PerfCounter clock is HostClockSource - real time, in nSecs
+static void TestHostClockSource()
+{
+    static_assert(std::is_same<DefaultPerfClockSource, HostClockSource>::value, "the host build times PerfCounters with HostClockSource");
+
+    HostClockSource::Ticks const before = HostClockSource::Now();
+    PerfCounter perfCounter;
+    perfCounter.Start();
+    struct timespec const sleepFor = {0, 2000000};
+    nanosleep(&sleepFor, nullptr);
+    perfCounter.Stop();
+    HostClockSource::Ticks const after = HostClockSource::Now();
+
+    $Check(after > before);
+    $Check(perfCounter.TotalSamples() == 1);
+    $Check(perfCounter.MinTimeInUSecs() >= 2000);
+    $Check(perfCounter.MaxTimeInUSecs() <= HostClockSource::ToUSecs(after - before));
+}
+
+static void RunTests()
+{
+    TestBeforeScheduler();
+    TestSoak();
+    TestPerfCounterAcrossWrap();
+    TestHostClockSource();
+}
+
+$HostTestMain("MonotonicClockSoakTest", RunTests)
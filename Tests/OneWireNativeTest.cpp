@@ -0,0 +1,206 @@
+/*
+    BasicOneWireNative against the simulated bus - transactions, Search ROM and slot timing
+
+    Copyright TinyBus 2024
+*/
+#include "HostTest.hpp"
+#include "SimulatedOneWireBus.hpp"
+#include <algorithm>
+
+typedef BasicOneWireNative<SimulatedOneWireBus> SimOneWire;
+
+// A DS18B20 (family 0x28) ROM code with a valid CRC
+static uint64_t MakeRom(uint64_t Serial48)
+{
+    uint8_t bytes[8];
+    bytes[0] = 0x28;
+    for (int ix = 0; ix < 6; ix++)
+    {
+        bytes[1 + ix] = (uint8_t)(Serial48 >> (8 * ix));
+    }
+    bytes[7] = OneWireNativeBase::Crc8(bytes, 7);
+
+    uint64_t rom;
+    memcpy(&rom, bytes, sizeof(rom));
+    return rom;
+}
+
+static bool RunToCompletion(SimOneWire& OneWire)
+{
+    bool const finished = OneWire.GetBus().Run();
+    return finished && !OneWire.IsBusy() && !OneWire.GetBus().IsLineLow();
+}
+
+// Full Search ROM sweep - the ROMs found, in the order found
+static std::vector<uint64_t> SearchAll(SimOneWire& OneWire)
+{
+    std::vector<uint64_t> roms;
+    OneWire.ResetSearch();
+    do
+    {
+        OneWire.StartSearch();
+        if (!RunToCompletion(OneWire) || (OneWire.GetStatus() != OneWireNativeBase::Status::Done))
+        {
+            break;
+        }
+        roms.push_back(OneWire.GetSearchRom());
+    } while (!OneWire.IsLastDevice() && (roms.size() < 16));
+    return roms;
+}
+
+static void MatchRomTransaction(SimOneWire& OneWire, uint64_t Rom, uint8_t Command, uint8_t RxLen)
+{
+    uint8_t tx[OneWireNativeBase::MaxTxBytes];
+    tx[0] = OneWireNativeBase::MatchRomCmd;
+    memcpy(&tx[1], &Rom, sizeof(Rom));
+    tx[9] = Command;
+    OneWire.StartTransaction(tx, 10, RxLen);
+}
+
+static void TestNoPresence()
+{
+    static SimOneWire& oneWire = *new SimOneWire();     // never destroyed - the destructor fails fast
+    $Check(oneWire.Begin(2));
+    $Check(oneWire.GetStatus() == OneWireNativeBase::Status::Idle);
+
+    uint8_t const tx[] = {OneWireNativeBase::SkipRomCmd, OneWireNativeBase::ConvertTCmd};
+    oneWire.StartTransaction(tx, sizeof(tx), 0);
+    $Check(oneWire.IsBusy());
+    $Check(RunToCompletion(oneWire));
+    $Check(oneWire.GetStatus() == OneWireNativeBase::Status::NoPresence);
+    $Check(oneWire.GetBus().GetSlots() == 1);           // just the reset
+
+    OneWireNativeBase::Stats stats;
+    oneWire.GetStats(stats);
+    $Check(stats._transactionCount == 1);
+    $Check(stats._noPresenceCount == 1);
+    $Check(oneWire.GetBus().GetTimingViolations() == 0);
+}
+
+static void TestSearchAndRead()
+{
+    static SimOneWire& oneWire = *new SimOneWire();     // never destroyed - the destructor fails fast
+    $Check(oneWire.Begin(2));
+
+    // a and b differ only in the top serial bit, b and c only in the bottom one - discrepancies deep in the ROM
+    SimulatedOneWireBus::Device a(MakeRom(0x000000000001));
+    SimulatedOneWireBus::Device b(MakeRom(0x800000000001));
+    SimulatedOneWireBus::Device c(MakeRom(0x800000000000));
+    uint8_t const scratchpad[8] = {0x91, 0x01, 0x4B, 0x46, 0x7F, 0xFF, 0x0F, 0x10};      // 25.0625C
+    b.SetScratchpad(scratchpad);
+
+    oneWire.GetBus().Attach(a);
+    oneWire.GetBus().Attach(b);
+    oneWire.GetBus().Attach(c);
+
+    // Every device is found exactly once, each with a valid ROM CRC
+    std::vector<uint64_t> found = SearchAll(oneWire);
+    $Check(found.size() == 3);
+    $Check(oneWire.IsLastDevice());
+    for (SimulatedOneWireBus::Device* device : {&a, &b, &c})
+    {
+        $Check(std::count(found.begin(), found.end(), device->GetRom()) == 1);
+    }
+    for (uint64_t rom : found)
+    {
+        uint8_t bytes[8];
+        memcpy(bytes, &rom, sizeof(bytes));
+        $Check(OneWireNativeBase::Crc8(bytes, 7) == bytes[7]);
+    }
+
+    // Skip ROM Convert T reaches every device
+    uint8_t const convert[] = {OneWireNativeBase::SkipRomCmd, OneWireNativeBase::ConvertTCmd};
+    oneWire.StartTransaction(convert, sizeof(convert), 0);
+    $Check(RunToCompletion(oneWire));
+    $Check(oneWire.GetStatus() == OneWireNativeBase::Status::Done);
+    $Check((a.GetConversions() == 1) && (b.GetConversions() == 1) && (c.GetConversions() == 1));
+
+    // Match ROM selects one device - the others stay off the wire, so its scratchpad reads back intact
+    MatchRomTransaction(oneWire, b.GetRom(), OneWireNativeBase::ReadScratchpadCmd, 9);
+    $Check(RunToCompletion(oneWire));
+    $Check(oneWire.GetStatus() == OneWireNativeBase::Status::Done);
+    $Check(memcmp(oneWire.GetRxBytes(), b.GetScratchpad(), 9) == 0);
+    $Check(OneWireNativeBase::Crc8(oneWire.GetRxBytes(), 8) == oneWire.GetRxBytes()[8]);
+
+    // A ROM nobody has - the read floats high
+    MatchRomTransaction(oneWire, MakeRom(0x123456), OneWireNativeBase::ReadScratchpadCmd, 9);
+    $Check(RunToCompletion(oneWire));
+    for (int ix = 0; ix < 9; ix++)
+    {
+        $Check(oneWire.GetRxBytes()[ix] == 0xFF);
+    }
+
+    $Check(oneWire.GetBus().GetTimingViolations() == 0);
+}
+
+static void TestSearchFailed()
+{
+    static SimOneWire& oneWire = *new SimOneWire();     // never destroyed - the destructor fails fast
+    $Check(oneWire.Begin(2));
+
+    // Answers the reset but not Search ROM - both the bit and its complement read as 1
+    SimulatedOneWireBus::Device silent(MakeRom(42), false);
+    oneWire.GetBus().Attach(silent);
+
+    oneWire.ResetSearch();
+    oneWire.StartSearch();
+    $Check(RunToCompletion(oneWire));
+    $Check(oneWire.GetStatus() == OneWireNativeBase::Status::SearchFailed);
+
+    OneWireNativeBase::Stats stats;
+    oneWire.GetStats(stats);
+    $Check(stats._searchFailedCount == 1);
+    $Check(oneWire.GetBus().GetTimingViolations() == 0);
+}
+
+// The ISR runs late after every timer edge - the slots stay within AN126 up to a few uSecs of latency, and a read
+// sampled past the 15us window is reported
+static void TestIsrLatency()
+{
+    uint8_t const scratchpad[8] = {0x91, 0x01, 0x4B, 0x46, 0x7F, 0xFF, 0x0F, 0x10};
+    for (uint32_t latency : {1, 2, 3, 6})
+    {
+        SimOneWire& oneWire = *new SimOneWire();            // never destroyed - the destructor fails fast
+        $Check(oneWire.Begin(2));
+        oneWire.GetBus().SetIsrLatency(latency);
+
+        SimulatedOneWireBus::Device& a = *new SimulatedOneWireBus::Device(MakeRom(0x000000000001));
+        SimulatedOneWireBus::Device& b = *new SimulatedOneWireBus::Device(MakeRom(0x800000000001));
+        b.SetScratchpad(scratchpad);
+        oneWire.GetBus().Attach(a);
+        oneWire.GetBus().Attach(b);
+
+        std::vector<uint64_t> found = SearchAll(oneWire);
+        MatchRomTransaction(oneWire, b.GetRom(), OneWireNativeBase::ReadScratchpadCmd, 9);
+        $Check(RunToCompletion(oneWire));
+
+        if (latency <= 3)
+        {
+            $Check(found.size() == 2);
+            $Check(memcmp(oneWire.GetRxBytes(), b.GetScratchpad(), 9) == 0);
+            $Check(oneWire.GetBus().GetTimingViolations() == 0);
+        }
+        else
+        {
+            $Check(oneWire.GetBus().GetTimingViolations() > 0);
+        }
+    }
+}
+
+static void TestBeginFails()
+{
+    static SimOneWire& oneWire = *new SimOneWire();     // never destroyed - the destructor fails fast
+    oneWire.GetBus().SetBeginResult(false);
+    $Check(!oneWire.Begin(2));
+}
+
+static void RunTests()
+{
+    TestNoPresence();
+    TestSearchAndRead();
+    TestSearchFailed();
+    TestIsrLatency();
+    TestBeginFails();
+}
+
+$HostTestMain("OneWireNativeTest", RunTests)
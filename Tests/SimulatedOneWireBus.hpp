@@ -0,0 +1,383 @@
+/*
+    Simulated 1-Wire bus - a BasicOneWireNative bus (see OneWireNative.hpp) with DS18B20-like devices on it,
+    so the driver's ISR state machine runs on the host against a model of the wire
+
+    Copyright TinyBus 2024
+*/
+#pragma once
+
+#include "OneWireNative.hpp"
+#include <vector>
+
+/**
+ * @brief Timer and line model for BasicOneWireNative.
+ *
+ * Time is simulated in uSecs and only moves in Run(), which fires the armed timer (the driver's ISR) until
+ * the driver stops arming it. The ISR runs SetIsrLatency() uSecs after the timer edge; as on the GPT, Arm() in
+ * the ISR times the next edge from that edge, and from now once the timer is stopped. The line is a wired-AND of the master and every attached device. Devices
+ * decode each slot when the master releases the line - from how long it was held low - and answer by
+ * holding the line low (presence pulse; a 0 bit in a read slot).
+ *
+ * Every slot's timing is checked against the standard speed limits (Maxim AN126); violations are counted.
+ */
+class SimulatedOneWireBus
+{
+public:
+    class Device
+    {
+    public:
+        Device(uint64_t Rom, bool AnswersSearch = true)
+            :   _rom(Rom),
+                _answersSearch(AnswersSearch),
+                _mode(Mode::Idle),
+                _bitIx(0),
+                _conversions(0)
+        {
+            memset(_scratchpad, 0, sizeof(_scratchpad));
+        }
+
+        void SetScratchpad(uint8_t const (&Bytes)[8])
+        {
+            memcpy(_scratchpad, Bytes, 8);
+            _scratchpad[8] = OneWireNativeBase::Crc8(_scratchpad, 8);
+        }
+
+        uint64_t GetRom() const { return _rom; }
+        uint8_t const* GetScratchpad() const { return _scratchpad; }
+        uint32_t GetConversions() const { return _conversions; }
+
+    private:
+        friend class SimulatedOneWireBus;
+
+        enum class Mode : uint8_t
+        {
+            Idle,               // not selected - ignores slots until the next reset
+            RomCommand,
+            MatchRom,
+            SearchBit,
+            SearchCompBit,
+            SearchDirection,
+            FunctionCommand,
+            ReadScratchpad,
+        };
+
+        void OnReset()
+        {
+            _mode = Mode::RomCommand;
+            _bitIx = 0;
+            _rxByte = 0;
+        }
+
+        // The bit this device puts on the wire in the current slot - true (released) if it is not sending
+        bool TxBit() const
+        {
+            switch (_mode)
+            {
+                case Mode::SearchBit:
+                    return RomBit(_bitIx);
+                case Mode::SearchCompBit:
+                    return !RomBit(_bitIx);
+                case Mode::ReadScratchpad:
+                    return (_bitIx >= 72) || ((_scratchpad[_bitIx >> 3] >> (_bitIx & 7)) & 1);
+                default:
+                    return true;
+            }
+        }
+
+        // Advance by one bit slot; MasterBit is what the master wrote (1 for a read slot)
+        void OnSlot(bool MasterBit)
+        {
+            switch (_mode)
+            {
+                case Mode::RomCommand:
+                case Mode::FunctionCommand:
+                {
+                    _rxByte |= (MasterBit << _bitIx);
+                    if (++_bitIx == 8)
+                    {
+                        OnCommand(_rxByte);
+                    }
+                }
+                break;
+
+                case Mode::MatchRom:
+                {
+                    if (MasterBit != RomBit(_bitIx))
+                    {
+                        _mode = Mode::Idle;
+                    }
+                    else if (++_bitIx == 64)
+                    {
+                        StartReceive(Mode::FunctionCommand);
+                    }
+                }
+                break;
+
+                case Mode::SearchBit:
+                    _mode = Mode::SearchCompBit;
+                    break;
+
+                case Mode::SearchCompBit:
+                    _mode = Mode::SearchDirection;
+                    break;
+
+                case Mode::SearchDirection:
+                {
+                    if (MasterBit != RomBit(_bitIx))
+                    {
+                        _mode = Mode::Idle;             // lost this branch of the search
+                    }
+                    else
+                    {
+                        _mode = (++_bitIx == 64) ? Mode::Idle : Mode::SearchBit;
+                    }
+                }
+                break;
+
+                case Mode::ReadScratchpad:
+                    _bitIx++;
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        void OnCommand(uint8_t Command)
+        {
+            if (_mode == Mode::RomCommand)
+            {
+                if ((Command == OneWireNativeBase::SearchRomCmd) && _answersSearch)
+                {
+                    _bitIx = 0;
+                    _mode = Mode::SearchBit;
+                }
+                else if (Command == OneWireNativeBase::MatchRomCmd)
+                {
+                    _bitIx = 0;
+                    _mode = Mode::MatchRom;
+                }
+                else if (Command == OneWireNativeBase::SkipRomCmd)
+                {
+                    StartReceive(Mode::FunctionCommand);
+                }
+                else
+                {
+                    _mode = Mode::Idle;
+                }
+            }
+            else if (Command == OneWireNativeBase::ConvertTCmd)
+            {
+                _conversions++;
+                _mode = Mode::Idle;
+            }
+            else if (Command == OneWireNativeBase::ReadScratchpadCmd)
+            {
+                _bitIx = 0;
+                _mode = Mode::ReadScratchpad;
+            }
+            else
+            {
+                _mode = Mode::Idle;
+            }
+        }
+
+        void StartReceive(Mode To)
+        {
+            _mode = To;
+            _bitIx = 0;
+            _rxByte = 0;
+        }
+
+        bool RomBit(uint8_t BitIx) const { return (_rom >> BitIx) & 1; }
+
+    private:
+        uint64_t const  _rom;
+        bool const      _answersSearch;
+        uint8_t         _scratchpad[9];
+        Mode            _mode;
+        uint8_t         _bitIx;
+        uint8_t         _rxByte;
+        uint32_t        _conversions;
+    };
+
+    // Slot timing limits - uSecs from the falling edge
+    static constexpr uint32_t   ResetLowMin = 480;
+    static constexpr uint32_t   PresenceFrom = 15;          // after the release
+    static constexpr uint32_t   PresenceUntil = 75;
+    static constexpr uint32_t   BitLowMax = 15;             // a 1 written, or a read slot
+    static constexpr uint32_t   Write0LowMin = 60;
+    static constexpr uint32_t   Write0LowMax = 120;
+    static constexpr uint32_t   SlotMin = 60;
+    static constexpr uint32_t   RecoveryMin = 1;
+    static constexpr uint32_t   DeviceHoldUntil = 45;       // a device sending 0 holds the line this long
+
+    SimulatedOneWireBus()
+        :   _onTimer(nullptr),
+            _context(nullptr),
+            _beginResult(true),
+            _nowUSecs(0),
+            _isrLatencyUSecs(0),
+            _isArmed(false),
+            _isRunning(false),
+            _alarmAtUSecs(0),
+            _edgeAtUSecs(0),
+            _isLow(false),
+            _fallAtUSecs(0),
+            _releaseAtUSecs(0),
+            _holdFromUSecs(0),
+            _holdUntilUSecs(0),
+            _lastWasReset(false),
+            _timingViolations(0),
+            _slots(0)
+    {
+    }
+
+    //* Bus interface
+    bool Begin(uint8_t Pin, void (*OnTimer)(void*), void* Context)
+    {
+        _onTimer = OnTimer;
+        _context = Context;
+        return _beginResult;
+    }
+
+    void DriveLow()
+    {
+        if (_isLow)
+        {
+            _timingViolations++;
+        }
+        if ((_slots > 0) && (_nowUSecs < (_releaseAtUSecs + RecoveryMin)))
+        {
+            _timingViolations++;
+        }
+        if ((_slots > 0) && !_lastWasReset && ((_nowUSecs - _fallAtUSecs) < (SlotMin + RecoveryMin)))
+        {
+            _timingViolations++;
+        }
+        _isLow = true;
+        _fallAtUSecs = _nowUSecs;
+    }
+
+    void Release()
+    {
+        uint32_t const lowUSecs = _nowUSecs - _fallAtUSecs;
+        _isLow = false;
+        _releaseAtUSecs = _nowUSecs;
+        _slots++;
+        _holdUntilUSecs = 0;
+
+        if (lowUSecs >= ResetLowMin)
+        {
+            _lastWasReset = true;
+            for (Device* device : _devices)
+            {
+                device->OnReset();
+            }
+            if (!_devices.empty())
+            {
+                _holdFromUSecs = _nowUSecs + PresenceFrom;
+                _holdUntilUSecs = _nowUSecs + PresenceUntil;
+            }
+            return;
+        }
+
+        _lastWasReset = false;
+        bool const masterBit = (lowUSecs < BitLowMax);
+        if ((lowUSecs == 0) || (!masterBit && ((lowUSecs < Write0LowMin) || (lowUSecs > Write0LowMax))))
+        {
+            _timingViolations++;
+        }
+
+        // Devices sending a 0 keep the line low past the master's sample point
+        bool wire = true;
+        for (Device* device : _devices)
+        {
+            wire = wire && device->TxBit();
+        }
+        if (!wire)
+        {
+            _holdFromUSecs = _nowUSecs;
+            _holdUntilUSecs = _fallAtUSecs + DeviceHoldUntil;
+        }
+
+        // A device reads the wire - so one that sends a 1 while another sends a 0 sees the 0 (Search ROM)
+        for (Device* device : _devices)
+        {
+            device->OnSlot(masterBit && wire);
+        }
+    }
+
+    bool Sample()
+    {
+        if (!_lastWasReset && ((_nowUSecs - _fallAtUSecs) > BitLowMax))
+        {
+            _timingViolations++;            // read slot sampled too late
+        }
+        return !_isLow && !((_nowUSecs >= _holdFromUSecs) && (_nowUSecs < _holdUntilUSecs));
+    }
+
+    void Arm(uint32_t USecs)
+    {
+        uint64_t const alarmAtUSecs = (_isRunning ? _edgeAtUSecs : _nowUSecs) + USecs;
+        _isArmed = true;
+        _isRunning = true;
+        _alarmAtUSecs = (alarmAtUSecs > _nowUSecs) ? alarmAtUSecs : (_nowUSecs + 1);
+    }
+
+    void Stop()
+    {
+        _isArmed = false;
+        _isRunning = false;
+    }
+
+    //* Simulation control
+    void Attach(Device& ToAttach) { _devices.push_back(&ToAttach); }
+    void DetachAll() { _devices.clear(); }
+    void SetBeginResult(bool Result) { _beginResult = Result; }
+    void SetIsrLatency(uint32_t USecs) { _isrLatencyUSecs = USecs; }      // timer edge to the driver's ISR
+
+    // Fire the timer until the driver stops arming it - false if it was still running after MaxSlots edges
+    bool Run(uint32_t MaxEdges = 100000)
+    {
+        while (_isArmed)
+        {
+            if (MaxEdges-- == 0)
+            {
+                return false;
+            }
+            _edgeAtUSecs = _alarmAtUSecs;
+            _nowUSecs = _alarmAtUSecs + _isrLatencyUSecs;
+            _isArmed = false;
+            _onTimer(_context);
+        }
+        return true;
+    }
+
+    uint64_t GetNowInUSecs() const { return _nowUSecs; }
+    uint32_t GetTimingViolations() const { return _timingViolations; }
+    uint32_t GetSlots() const { return _slots; }
+    bool IsLineLow() const { return _isLow; }
+
+private:
+    void                    (*_onTimer)(void*);
+    void*                   _context;
+    bool                    _beginResult;
+    std::vector<Device*>    _devices;
+
+    uint64_t                _nowUSecs;
+    uint32_t                _isrLatencyUSecs;
+    bool                    _isArmed;
+    bool                    _isRunning;             // armed since the last Stop() - edges are timed from _edgeAtUSecs
+    uint64_t                _alarmAtUSecs;
+    uint64_t                _edgeAtUSecs;
+
+    bool                    _isLow;
+    uint64_t                _fallAtUSecs;
+    uint64_t                _releaseAtUSecs;
+    uint64_t                _holdFromUSecs;         // devices hold the line low over [from, until)
+    uint64_t                _holdUntilUSecs;
+    bool                    _lastWasReset;
+    uint32_t                _timingViolations;
+    uint32_t                _slots;
+};
@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+# SPA Heater Controller for Maxie HA system 2024 (c)TinyBus
+#
+# Decodes SpaHeaterCntl log records into absolute (UTC) times.
+#
+# Records look like:    TYPE:<instance>:<seq>:<secs>.<usecs>:<message>
+# where the stamp is the device's monotonic clock since boot. NTPR records carry a reference pair:
+#                       NTPR:<instance>:<seq>:<stamp>:<mono secs>.<usecs>;<unix secs>.<usecs>;<RTC time>
+# Each record is converted with the reference of its boot instance that is closest in monotonic time.
+# Records of an instance with no NTPR record are converted from the SLOG (boot) record's RTC time, to
+# the nearest second only, and are flagged with '~'.
+#
+# Usage: logdecode.py [logfile ...]        (reads stdin if no files are given)
+#        Input can be a Serial or telnet capture, a 'diagLog' dump or the MQTT log topic payloads.
+
+import argparse
+import bisect
+import datetime
+import fileinput
+import re
+import sys
+
+RECORD = re.compile(r'^(SLOG|NTPR|INFO|PROG|WARN|CRIT):(\d+):(\d+):(\d+)\.(\d{6}):(.*)$')
+NTP_REF = re.compile(r'^(\d+)\.(\d{6});(\d+)\.(\d{6});')
+
+
+def to_usecs(secs, usecs):
+    return int(secs) * 1000000 + int(usecs)
+
+
+def parse(lines):
+    records = []
+    for line in lines:
+        match = RECORD.match(line.strip())
+        if match:
+            rec_type, instance, seq, secs, usecs, message = match.groups()
+            records.append((rec_type, int(instance), int(seq), to_usecs(secs, usecs), message))
+    return records
+
+
+def collect_references(records):
+    """Returns {instance: ([mono...], [(mono, utc, exact)...])} sorted by monotonic time"""
+    refs = {}
+    for rec_type, instance, _, stamp, message in records:
+        ref = None
+        if rec_type == 'NTPR':
+            match = NTP_REF.match(message)
+            if match:
+                ref = (to_usecs(*match.group(1, 2)), to_usecs(*match.group(3, 4)), True)
+        elif rec_type == 'SLOG':
+            try:
+                rtc = datetime.datetime.fromisoformat(message.strip())
+                ref = (stamp, int(rtc.replace(tzinfo=datetime.timezone.utc).timestamp()) * 1000000, False)
+            except ValueError:
+                pass
+        if ref:
+            refs.setdefault(instance, []).append(ref)
+
+    result = {}
+    for instance, instance_refs in refs.items():
+        exact = sorted(r for r in instance_refs if r[2])
+        chosen = exact if exact else sorted(instance_refs)
+        result[instance] = ([r[0] for r in chosen], chosen)
+    return result
+
+
+def to_utc(refs, instance, stamp):
+    if instance not in refs:
+        return None, False
+    monos, chosen = refs[instance]
+    ix = bisect.bisect_left(monos, stamp)
+    candidates = [chosen[i] for i in (ix - 1, ix) if 0 <= i < len(chosen)]
+    mono, utc, exact = min(candidates, key=lambda r: abs(r[0] - stamp))
+    return utc + (stamp - mono), exact
+
+
+def format_utc(utc_usecs):
+    when = datetime.datetime.fromtimestamp(utc_usecs // 1000000, tz=datetime.timezone.utc)
+    return '%s.%06dZ' % (when.strftime('%Y-%m-%dT%H:%M:%S'), utc_usecs % 1000000)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert SpaHeaterCntl log record stamps to UTC')
+    parser.add_argument('files', nargs='*', help='log captures (default: stdin)')
+    args = parser.parse_args()
+
+    records = parse(fileinput.input(args.files))
+    refs = collect_references(records)
+
+    for rec_type, instance, seq, stamp, message in records:
+        utc, exact = to_utc(refs, instance, stamp)
+        when = format_utc(utc) if utc is not None else '%27s' % ('+%d.%06ds' % (stamp // 1000000, stamp % 1000000))
+        print('%s%s %s %u:%u %s' % (when, ' ' if exact or utc is None else '~', rec_type, instance, seq, message))
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())